@@ -0,0 +1,838 @@
+//===---------------------------------------------------------
+//                       ASYNC_LOADER
+//===---------------------------------------------------------
+//
+// Asynchronous loading of files into dynarrays of trivially
+// copyable elements.
+//
+// Loading many large dynarrays one after another with
+// blocking reads leaves the storage device idle for the
+// latency of every single request. The loader instead
+// allocates each destination dynarray uninitialized, splits
+// the file into chunks and keeps up to `queue_depth` chunk
+// reads of all pending files in flight at the same time,
+// alternating between the files, so that loading becomes
+// bound by the bandwidth of the device.
+//
+// On Linux the reads are issued through an io_uring driven
+// by a single thread of the loader. io_uring is set up with
+// raw system calls and does not require liburing. Where it is
+// unavailable (old kernels, seccomp filters, other systems)
+// a number of loader threads issue the chunk reads with
+// pread instead.
+//
+// Completion is reported either through a future or through
+// a callback that is invoked on a thread of the loader.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_ASYNC_LOADER_HPP
+#define UTILS_ASYNC_LOADER_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+#include "dynarray_serialize.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(UTILS_SERIAL_POSIX)
+	#include <sys/uio.h>
+#endif
+
+#if !defined(UTILS_ASYNC_IO_URING) && defined(__linux__) && defined(__has_include)
+	#if __has_include(<linux/io_uring.h>)
+		#define UTILS_ASYNC_IO_URING 1
+	#endif
+#endif
+
+// headers used by definition site
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#if defined(UTILS_SERIAL_POSIX)
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#if defined(UTILS_ASYNC_IO_URING)
+	#include <linux/io_uring.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+#endif
+
+#if defined(UTILS_SERIAL_POSIX)
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// Tuning parameters of an async_loader.
+	struct async_loader_options {
+		/// Bytes per chunk read.
+		size_t   chunk_size   = 1024 * 1024;
+		/// Maximum number of chunk reads in flight.
+		unsigned queue_depth  = 64;
+		/// Number of threads issuing pread if io_uring is not used.
+		unsigned threads      = 4;
+		/// Use io_uring if the kernel supports it.
+		bool     use_io_uring = true;
+	};
+
+	namespace detail {
+		/// A file being loaded into a dynarray. Guarded by the mutex of the loader.
+		struct load_job {
+			virtual ~load_job() = default;
+
+			/// Verifies the loaded elements and reports the outcome to the caller.
+			virtual void complete(std::exception_ptr error) = 0;
+
+			int                fd          = -1;
+			unsigned char *    destination = nullptr;
+			size_t             bytes       = 0;
+			std::uint64_t      file_offset = 0;
+			size_t             issued      = 0;
+			size_t             inflight    = 0;
+			std::exception_ptr error;
+		};
+
+		/// A read of a contiguous part of a file.
+		struct load_chunk {
+			load_job *    job;
+			size_t        length;
+			std::uint64_t offset;
+			::iovec       target;
+		};
+
+	#if defined(UTILS_ASYNC_IO_URING)
+		/// Minimal io_uring submitting vectored reads.
+		class io_ring {
+		public:
+			io_ring() = default;
+			~io_ring();
+
+			io_ring(io_ring const&) = delete;
+			auto operator=(io_ring const&) -> io_ring & = delete;
+
+			/// Sets up a ring with \entries submission entries.
+			/// Returns `false` if io_uring is not available.
+			auto open(unsigned entries) -> bool;
+
+			/// Queues the read of the remaining target of \chunk.
+			void prepare_read(load_chunk & chunk);
+
+			/// Submits all queued reads and waits for at least \min_complete completions.
+			/// Throws a system_error exception if io_uring_enter fails; the reads
+			/// that were not submitted stay queued until withdrawn.
+			void submit_and_wait(unsigned min_complete);
+
+			/// Removes the queued reads that were not submitted and invokes \f(chunk) for them.
+			template<typename F>
+			void withdraw(F && f);
+
+			/// Invokes \f(chunk, result) for every completion.
+			template<typename F>
+			void reap(F && f);
+
+		private:
+			int             m_fd        = -1;
+			void *          m_sq_ring   = nullptr;
+			size_t          m_sq_size   = 0;
+			void *          m_cq_ring   = nullptr;
+			size_t          m_cq_size   = 0;
+			::io_uring_sqe *m_sqes      = nullptr;
+			size_t          m_sqes_size = 0;
+			unsigned *      m_sq_tail   = nullptr;
+			unsigned        m_sq_mask   = 0;
+			unsigned *      m_sq_array  = nullptr;
+			unsigned *      m_cq_head   = nullptr;
+			unsigned *      m_cq_tail   = nullptr;
+			unsigned        m_cq_mask   = 0;
+			::io_uring_cqe *m_cqes      = nullptr;
+			unsigned        m_pending   = 0;
+		};
+	#endif
+	}
+
+	/// Loads files into dynarrays asynchronously with overlapping chunked reads.
+	///
+	/// Callbacks are invoked on a thread of the loader and must not throw,
+	/// also for files that cannot be opened and for empty files.
+	/// The destructor waits until all issued loads completed.
+	class async_loader {
+	public:
+		/// Creates a loader and its threads.
+		explicit async_loader(async_loader_options options = async_loader_options{});
+
+		/// Waits for all issued loads and joins the threads of the loader.
+		~async_loader();
+
+		async_loader(async_loader const&) = delete;
+		auto operator=(async_loader const&) -> async_loader & = delete;
+
+		/// Loads the raw contents of the file at \path as elements of type T.
+		/// The future throws a system_error exception if the file cannot be read
+		/// and an invalid_argument exception if its size is not a multiple of sizeof(T).
+		template<typename T>
+		auto load(std::string const& path) -> std::future<dynarray<T>>;
+
+		/// Loads the raw contents of the file at \path as elements of type T and
+		/// invokes \on_complete(dynarray<T> && result, std::exception_ptr error).
+		/// On failure \result is empty and \error is set.
+		template<typename T, typename F>
+		void load(std::string const& path, F && on_complete);
+
+		/// Loads a dynarray serialized by serial::write from the file at \path and
+		/// verifies its checksum. The future throws the exceptions of serial::read.
+		template<typename T>
+		auto load_serialized(std::string const& path) -> std::future<dynarray<T>>;
+
+		/// Loads a dynarray serialized by serial::write from the file at \path and
+		/// invokes \on_complete like load.
+		template<typename T, typename F>
+		void load_serialized(std::string const& path, F && on_complete);
+
+		/// Blocks until all loads issued so far completed.
+		void wait_idle();
+
+		/// Returns `true` if the reads are issued through io_uring.
+		auto uses_io_uring() const -> bool;
+
+	private:
+		template<typename T, typename F>
+		void start(std::string const& path, bool serialized, F && on_complete);
+
+		/// Registers \job and wakes up the loader threads.
+		void submit(std::unique_ptr<detail::load_job> job);
+
+		/// Hands \job, which needs no reads, to the loader threads to report its outcome.
+		void defer(std::unique_ptr<detail::load_job> job);
+
+		/// Returns `true` if some job has bytes that have not been issued yet.
+		auto has_unissued() const -> bool;
+
+		/// Assigns the next chunk of the pending jobs in round-robin order to \chunk.
+		auto next_chunk(detail::load_chunk & chunk) -> bool;
+
+		/// Accounts the completed \chunk and returns its job if that finished.
+		/// \error is zero on success, an errno value or -1 for a premature end of file.
+		auto chunk_done(detail::load_chunk const& chunk, int error) -> std::unique_ptr<detail::load_job>;
+
+		/// Closes the file of \job and reports its outcome.
+		void finish(std::unique_ptr<detail::load_job> job);
+
+		void pread_loop();
+
+	#if defined(UTILS_ASYNC_IO_URING)
+		void ring_loop();
+	#endif
+
+		async_loader_options                           m_options;
+		std::mutex                                     m_mutex;
+		std::condition_variable                        m_wake;
+		std::condition_variable                        m_idle;
+		std::vector<std::unique_ptr<detail::load_job>> m_jobs;
+		std::vector<std::unique_ptr<detail::load_job>> m_deferred;
+		size_t                                         m_cursor;
+		size_t                                         m_finishing;
+		bool                                           m_stop;
+	#if defined(UTILS_ASYNC_IO_URING)
+		std::unique_ptr<detail::io_ring>               m_ring;
+	#endif
+		std::vector<std::thread>                       m_threads;
+	};
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace detail {
+		template<typename T, typename F>
+		struct typed_load_job final : load_job {
+			template<typename G>
+			typed_load_job(size_t count, G && on_complete_):
+				array(count),
+				on_complete(std::forward<G>(on_complete_))
+			{}
+
+			void complete(std::exception_ptr failure) override {
+				if (!failure && verify) {
+					try {
+						serial::detail::check_checksum(header, array.data(), bytes);
+					}
+					catch (...) {
+						failure = std::current_exception();
+					}
+				}
+				if (failure) {
+					on_complete(dynarray<T>(0), failure);
+				}
+				else {
+					on_complete(std::move(array), std::exception_ptr{});
+				}
+			}
+
+			dynarray<T>    array;
+			F              on_complete;
+			bool           verify = false;
+			serial::header header{};
+		};
+
+		inline auto load_error(int error) -> std::exception_ptr {
+			using namespace std::string_literals;
+			if (error < 0) {
+				return std::make_exception_ptr(std::invalid_argument{"cannot load dynarray: unexpected end of file"s});
+			}
+			return std::make_exception_ptr(std::system_error{error, std::generic_category(), "cannot load dynarray"});
+		}
+
+		/// Reads exactly \bytes at \offset. Returns zero or an error like async_loader::chunk_done.
+		inline auto pread_all(int fd, unsigned char * target, size_t bytes, std::uint64_t offset) -> int {
+			while (bytes != 0) {
+				auto const received = ::pread(fd, target, bytes, static_cast<off_t>(offset));
+				if (received < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					return errno;
+				}
+				if (received == 0) {
+					return -1;
+				}
+				target += received;
+				bytes -= static_cast<size_t>(received);
+				offset += static_cast<std::uint64_t>(received);
+			}
+			return 0;
+		}
+	}
+}
+
+#if defined(UTILS_ASYNC_IO_URING)
+
+//============================================================
+// io_uring
+//============================================================
+
+inline utils::detail::io_ring::~io_ring() {
+	if (m_sqes != nullptr) {
+		::munmap(m_sqes, m_sqes_size);
+	}
+	if (m_cq_ring != nullptr && m_cq_ring != m_sq_ring) {
+		::munmap(m_cq_ring, m_cq_size);
+	}
+	if (m_sq_ring != nullptr) {
+		::munmap(m_sq_ring, m_sq_size);
+	}
+	if (m_fd >= 0) {
+		::close(m_fd);
+	}
+}
+
+inline auto utils::detail::io_ring::open(unsigned entries) -> bool {
+	auto params = ::io_uring_params{};
+	auto const fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+	if (fd < 0) {
+		return false;
+	}
+	m_fd = fd;
+	m_sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	m_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(::io_uring_cqe);
+#if defined(IORING_FEAT_SINGLE_MMAP)
+	auto const single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+#else
+	auto const single_mmap = false;
+#endif
+	if (single_mmap) {
+		m_sq_size = m_cq_size = m_sq_size > m_cq_size ? m_sq_size : m_cq_size;
+	}
+	auto const map = [fd](size_t size, off_t offset) -> void * {
+		auto const result = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+		return result == MAP_FAILED ? nullptr : result;
+	};
+	m_sq_ring = map(m_sq_size, IORING_OFF_SQ_RING);
+	if (m_sq_ring == nullptr) {
+		return false;
+	}
+	m_cq_ring = single_mmap ? m_sq_ring : map(m_cq_size, IORING_OFF_CQ_RING);
+	if (m_cq_ring == nullptr) {
+		return false;
+	}
+	m_sqes_size = params.sq_entries * sizeof(::io_uring_sqe);
+	m_sqes = static_cast<::io_uring_sqe *>(map(m_sqes_size, IORING_OFF_SQES));
+	if (m_sqes == nullptr) {
+		return false;
+	}
+	auto const sq = static_cast<unsigned char *>(m_sq_ring);
+	auto const cq = static_cast<unsigned char *>(m_cq_ring);
+	m_sq_tail  = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+	m_sq_mask  = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+	m_sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+	m_cq_head  = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+	m_cq_tail  = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+	m_cq_mask  = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+	m_cqes     = reinterpret_cast<::io_uring_cqe *>(cq + params.cq_off.cqes);
+	return true;
+}
+
+inline void utils::detail::io_ring::prepare_read(load_chunk & chunk) {
+	// Only this thread writes the tail; the kernel reads it after the release store.
+	auto const tail = *m_sq_tail;
+	auto const index = tail & m_sq_mask;
+	auto & sqe = m_sqes[index];
+	sqe = ::io_uring_sqe{};
+	sqe.opcode    = IORING_OP_READV;
+	sqe.fd        = chunk.job->fd;
+	sqe.off       = chunk.offset + (chunk.length - chunk.target.iov_len);
+	sqe.addr      = reinterpret_cast<std::uint64_t>(&chunk.target);
+	sqe.len       = 1;
+	sqe.user_data = reinterpret_cast<std::uint64_t>(&chunk);
+	m_sq_array[index] = index;
+	__atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+	++m_pending;
+}
+
+inline void utils::detail::io_ring::submit_and_wait(unsigned min_complete) {
+	for (;;) {
+		auto const submitted = ::syscall(__NR_io_uring_enter, m_fd, m_pending, min_complete,
+			min_complete != 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+		if (submitted >= 0) {
+			m_pending -= static_cast<unsigned>(submitted);
+			if (m_pending == 0) {
+				return;
+			}
+			// Submit the rest without waiting again for completions that may not come.
+			min_complete = 0;
+			continue;
+		}
+		if (errno == EINTR) {
+			continue;
+		}
+		if (errno == EAGAIN || errno == EBUSY) {
+			// The kernel is short on resources or the completion queue is full:
+			// reap completions first and submit the rest on the next call.
+			return;
+		}
+		throw std::system_error{errno, std::generic_category(), "cannot submit reads to io_uring"};
+	}
+}
+
+template<typename F>
+void utils::detail::io_ring::withdraw(F && f) {
+	// Without SQPOLL the kernel consumes entries only within io_uring_enter,
+	// so the entries past the ones it consumed can be taken back.
+	auto tail = *m_sq_tail;
+	for (; m_pending != 0; --m_pending) {
+		--tail;
+		auto const& sqe = m_sqes[m_sq_array[tail & m_sq_mask]];
+		__atomic_store_n(m_sq_tail, tail, __ATOMIC_RELEASE);
+		f(*reinterpret_cast<load_chunk *>(sqe.user_data));
+	}
+}
+
+template<typename F>
+void utils::detail::io_ring::reap(F && f) {
+	auto head = *m_cq_head;
+	auto const tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+	for (; head != tail; ++head) {
+		auto const& cqe = m_cqes[head & m_cq_mask];
+		auto const chunk = reinterpret_cast<load_chunk *>(cqe.user_data);
+		auto const result = cqe.res;
+		// Release the entry before the callback as it may queue new reads.
+		__atomic_store_n(m_cq_head, head + 1, __ATOMIC_RELEASE);
+		f(*chunk, result);
+	}
+}
+
+#endif // UTILS_ASYNC_IO_URING
+
+//============================================================
+// Loader
+//============================================================
+
+inline utils::async_loader::async_loader(async_loader_options options):
+	m_options{options},
+	m_mutex{},
+	m_wake{},
+	m_idle{},
+	m_jobs{},
+	m_deferred{},
+	m_cursor{0},
+	m_finishing{0},
+	m_stop{false},
+#if defined(UTILS_ASYNC_IO_URING)
+	m_ring{},
+#endif
+	m_threads{}
+{
+	using namespace std::string_literals;
+	if (m_options.chunk_size == 0 || m_options.queue_depth == 0) {
+		throw std::invalid_argument{"cannot create async_loader with zero chunk size or queue depth"s};
+	}
+#if defined(UTILS_ASYNC_IO_URING)
+	if (m_options.use_io_uring) {
+		auto ring = std::make_unique<detail::io_ring>();
+		if (ring->open(m_options.queue_depth)) {
+			m_ring = std::move(ring);
+			m_threads.emplace_back([this] { ring_loop(); });
+			return;
+		}
+	}
+#endif
+	auto const threads = m_options.threads != 0 ? m_options.threads : 1u;
+	for (unsigned i = 0; i != threads; ++i) {
+		m_threads.emplace_back([this] { pread_loop(); });
+	}
+}
+
+inline utils::async_loader::~async_loader() {
+	wait_idle();
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (auto & thread : m_threads) {
+		thread.join();
+	}
+}
+
+inline auto utils::async_loader::uses_io_uring() const -> bool {
+#if defined(UTILS_ASYNC_IO_URING)
+	return m_ring != nullptr;
+#else
+	return false;
+#endif
+}
+
+inline void utils::async_loader::wait_idle() {
+	std::unique_lock<std::mutex> lock{m_mutex};
+	m_idle.wait(lock, [this] { return m_jobs.empty() && m_finishing == 0; });
+}
+
+template<typename T>
+auto utils::async_loader::load(std::string const& path) -> std::future<dynarray<T>> {
+	auto promise = std::promise<dynarray<T>>{};
+	auto future = promise.get_future();
+	start<T>(path, false, [promise = std::move(promise)](dynarray<T> && result, std::exception_ptr error) mutable {
+		if (error) {
+			promise.set_exception(error);
+		}
+		else {
+			promise.set_value(std::move(result));
+		}
+	});
+	return future;
+}
+
+template<typename T, typename F>
+void utils::async_loader::load(std::string const& path, F && on_complete) {
+	start<T>(path, false, std::forward<F>(on_complete));
+}
+
+template<typename T>
+auto utils::async_loader::load_serialized(std::string const& path) -> std::future<dynarray<T>> {
+	auto promise = std::promise<dynarray<T>>{};
+	auto future = promise.get_future();
+	start<T>(path, true, [promise = std::move(promise)](dynarray<T> && result, std::exception_ptr error) mutable {
+		if (error) {
+			promise.set_exception(error);
+		}
+		else {
+			promise.set_value(std::move(result));
+		}
+	});
+	return future;
+}
+
+template<typename T, typename F>
+void utils::async_loader::load_serialized(std::string const& path, F && on_complete) {
+	start<T>(path, true, std::forward<F>(on_complete));
+}
+
+template<typename T, typename F>
+void utils::async_loader::start(std::string const& path, bool serialized, F && on_complete) {
+	static_assert(std::is_trivially_copyable<T>::value,
+		"async_loader can only load dynarrays of trivially copyable elements");
+	using callback = std::decay_t<F>;
+	auto fail = [this, &on_complete](std::exception_ptr error) {
+		auto job = std::make_unique<detail::typed_load_job<T, callback>>(0, std::forward<F>(on_complete));
+		job->error = error;
+		defer(std::move(job));
+	};
+
+	// Opening the file and reading the header are cheap compared to the
+	// payload and happen on the calling thread; their errors are reported
+	// through the completion on a loader thread like all others.
+	auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		fail(std::make_exception_ptr(std::system_error{errno, std::generic_category(), "cannot open " + path}));
+		return;
+	}
+	std::unique_ptr<detail::typed_load_job<T, callback>> job;
+	try {
+		struct ::stat status;
+		if (::fstat(fd, &status) != 0) {
+			throw std::system_error{errno, std::generic_category(), "cannot stat " + path};
+		}
+		auto const file_size = static_cast<std::uint64_t>(status.st_size);
+		auto h = serial::header{};
+		auto payload_offset = std::uint64_t{0};
+		auto count = size_t{0};
+		if (serialized) {
+			if (auto const error = detail::pread_all(fd, reinterpret_cast<unsigned char *>(&h), sizeof(h), 0)) {
+				std::rethrow_exception(detail::load_error(error));
+			}
+			auto const bytes = serial::detail::check_header<T>(h);
+			if (file_size - sizeof(h) < bytes) {
+				serial::detail::malformed("unexpected end of file");
+			}
+			payload_offset = sizeof(h);
+			count = static_cast<size_t>(h.size);
+		}
+		else {
+			if (file_size % sizeof(T) != 0) {
+				using namespace std::string_literals;
+				throw std::invalid_argument{
+					"cannot load dynarray of elements with size "s + std::to_string(sizeof(T)) +
+					" from file of size " + std::to_string(file_size)
+				};
+			}
+			count = static_cast<size_t>(file_size / sizeof(T));
+		}
+#if defined(POSIX_FADV_SEQUENTIAL)
+		// Widens the readahead window of the kernel for the chunked reads.
+		::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+		// Trivially copyable elements are left uninitialized until their chunk arrives.
+		job = std::make_unique<detail::typed_load_job<T, callback>>(count, std::forward<F>(on_complete));
+		job->fd          = fd;
+		job->destination = reinterpret_cast<unsigned char *>(job->array.data());
+		job->bytes       = count * sizeof(T);
+		job->file_offset = payload_offset;
+		job->verify      = serialized;
+		job->header      = h;
+	}
+	catch (...) {
+		::close(fd);
+		fail(std::current_exception());
+		return;
+	}
+	if (job->bytes == 0) {
+		defer(std::move(job));
+		return;
+	}
+	submit(std::move(job));
+}
+
+inline void utils::async_loader::submit(std::unique_ptr<detail::load_job> job) {
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_jobs.push_back(std::move(job));
+	}
+	m_wake.notify_all();
+}
+
+inline void utils::async_loader::defer(std::unique_ptr<detail::load_job> job) {
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_deferred.push_back(std::move(job));
+		// Counted as finishing so that wait_idle waits for its report.
+		++m_finishing;
+	}
+	m_wake.notify_all();
+}
+
+inline auto utils::async_loader::has_unissued() const -> bool {
+	for (auto const& job : m_jobs) {
+		if (!job->error && job->issued != job->bytes) {
+			return true;
+		}
+	}
+	return false;
+}
+
+inline auto utils::async_loader::next_chunk(detail::load_chunk & chunk) -> bool {
+	auto const count = m_jobs.size();
+	for (size_t i = 0; i != count; ++i) {
+		auto const index = (m_cursor + i) % count;
+		auto & job = *m_jobs[index];
+		if (job.error || job.issued == job.bytes) {
+			continue;
+		}
+		auto const length = std::min(m_options.chunk_size, job.bytes - job.issued);
+		chunk.job    = &job;
+		chunk.length = length;
+		chunk.offset = job.file_offset + job.issued;
+		chunk.target = ::iovec{job.destination + job.issued, length};
+		job.issued += length;
+		++job.inflight;
+		// Continue with the next file to overlap the reads of all files.
+		m_cursor = (index + 1) % count;
+		return true;
+	}
+	return false;
+}
+
+inline auto utils::async_loader::chunk_done(detail::load_chunk const& chunk, int error)
+	-> std::unique_ptr<detail::load_job>
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	auto & job = *chunk.job;
+	--job.inflight;
+	if (error != 0 && !job.error) {
+		job.error = detail::load_error(error);
+	}
+	if (job.inflight != 0 || (!job.error && job.issued != job.bytes)) {
+		return nullptr;
+	}
+	auto const position = std::find_if(m_jobs.begin(), m_jobs.end(),
+		[&job](std::unique_ptr<detail::load_job> const& j) { return j.get() == &job; });
+	auto result = std::move(*position);
+	m_jobs.erase(position);
+	m_cursor = m_jobs.empty() ? 0 : m_cursor % m_jobs.size();
+	++m_finishing;
+	return result;
+}
+
+inline void utils::async_loader::finish(std::unique_ptr<detail::load_job> job) {
+	if (job->fd >= 0) {
+		::close(job->fd);
+	}
+	job->complete(job->error);
+	job.reset();
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		--m_finishing;
+	}
+	m_idle.notify_all();
+}
+
+inline void utils::async_loader::pread_loop() {
+	for (;;) {
+		auto chunk = detail::load_chunk{};
+		auto deferred = std::unique_ptr<detail::load_job>{};
+		{
+			std::unique_lock<std::mutex> lock{m_mutex};
+			m_wake.wait(lock, [this] { return m_stop || !m_deferred.empty() || has_unissued(); });
+			if (!m_deferred.empty()) {
+				deferred = std::move(m_deferred.back());
+				m_deferred.pop_back();
+			}
+			else if (!next_chunk(chunk)) {
+				return;
+			}
+		}
+		if (deferred) {
+			finish(std::move(deferred));
+			continue;
+		}
+		auto const error = detail::pread_all(chunk.job->fd,
+			static_cast<unsigned char *>(chunk.target.iov_base), chunk.length, chunk.offset);
+		if (auto job = chunk_done(chunk, error)) {
+			finish(std::move(job));
+		}
+	}
+}
+
+#if defined(UTILS_ASYNC_IO_URING)
+inline void utils::async_loader::ring_loop() {
+	auto slots = std::vector<detail::load_chunk>(m_options.queue_depth);
+	auto free_slots = std::vector<detail::load_chunk *>{};
+	for (auto & slot : slots) {
+		free_slots.push_back(&slot);
+	}
+	unsigned inflight = 0;
+	auto const retire = [&](detail::load_chunk & chunk, int error) {
+		free_slots.push_back(&chunk);
+		--inflight;
+		if (auto job = chunk_done(chunk, error)) {
+			finish(std::move(job));
+		}
+	};
+	for (;;) {
+		auto deferred = std::vector<std::unique_ptr<detail::load_job>>{};
+		{
+			std::unique_lock<std::mutex> lock{m_mutex};
+			if (inflight == 0) {
+				m_wake.wait(lock, [this] { return m_stop || !m_deferred.empty() || has_unissued(); });
+				if (m_deferred.empty() && !has_unissued()) {
+					return;
+				}
+			}
+			deferred.swap(m_deferred);
+			// New files are picked up here, i.e. at the latest after the next completion.
+			while (!free_slots.empty() && next_chunk(*free_slots.back())) {
+				m_ring->prepare_read(*free_slots.back());
+				free_slots.pop_back();
+				++inflight;
+			}
+		}
+		for (auto & job : deferred) {
+			finish(std::move(job));
+		}
+		if (inflight == 0) {
+			continue;
+		}
+		try {
+			m_ring->submit_and_wait(1);
+		}
+		catch (std::system_error const& error) {
+			// The reads that did not reach the kernel fail their files. Reads
+			// submitted before are still reaped, so their buffers stay owned by
+			// their jobs until the kernel is done with them.
+			m_ring->withdraw([&](detail::load_chunk & chunk) {
+				retire(chunk, error.code().value());
+			});
+		}
+		m_ring->reap([&](detail::load_chunk & chunk, int result) {
+			if (result == -EINTR || result == -EAGAIN) {
+				m_ring->prepare_read(chunk);
+				return;
+			}
+			auto error = 0;
+			if (result < 0) {
+				error = -result;
+			}
+			else if (result == 0) {
+				error = -1;
+			}
+			else if (static_cast<size_t>(result) < chunk.target.iov_len) {
+				// Short read: queue the rest of the chunk.
+				chunk.target.iov_base = static_cast<unsigned char *>(chunk.target.iov_base) + result;
+				chunk.target.iov_len -= static_cast<size_t>(result);
+				m_ring->prepare_read(chunk);
+				return;
+			}
+			retire(chunk, error);
+		});
+	}
+}
+#endif
+
+#endif // UTILS_SERIAL_POSIX
+
+#endif // UTILS_ASYNC_LOADER_HPP
@@ -0,0 +1,566 @@
+//===---------------------------------------------------------
+//                       COMPRESSED_DYNARRAY
+//===---------------------------------------------------------
+//
+// Immutable block-compressed dynarray of integers with
+// random access.
+//
+// The elements are split into blocks of 128 elements. Every
+// block is encoded by whichever of two schemes is smaller:
+//
+// - Frame of reference: the offsets of the elements to the
+//   minimum of the block are bit-packed with the width of the
+//   largest offset.
+//
+// - Delta: for non-decreasing blocks the differences between
+//   consecutive elements, minus the smallest difference, are
+//   bit-packed. Sorted identifiers and timestamps compress to
+//   a few bits per element this way.
+//
+// The packed values are interleaved over four 64-bit lanes,
+// i.e. element j lives in lane j % 4, such that all four
+// lanes are unpacked with the same shifts. This lets blocks
+// be decoded with AVX2 (see cpu_dispatch.hpp) four elements
+// at a time, while an element can still be extracted on its
+// own with a few shifts.
+//
+// Blocks are located in constant time through a table of
+// per-block descriptors. Element access decodes a single
+// value for frame of reference blocks and the block prefix
+// for delta blocks; iteration decodes whole blocks.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_COMPRESSED_DYNARRAY_HPP
+#define UTILS_COMPRESSED_DYNARRAY_HPP
+
+// headers used by declaration site
+#include "cpu_dispatch.hpp"
+#include "dynarray.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+// headers used by definition site
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// Immutable dynarray of integers stored in bit-packed blocks.
+	template<typename T>
+	class compressed_dynarray {
+		static_assert(std::is_integral<T>::value && !std::is_same<T, bool>::value,
+			"compressed_dynarray requires integral element types");
+
+	public:
+		using value_type = T;
+		using size_type  = size_t;
+
+		/// The number of elements per block.
+		static constexpr size_type block_size = 128;
+
+		/// Encodings of a block.
+		enum class encoding : std::uint8_t {
+			frame_of_reference,
+			delta
+		};
+
+		/// Forward iterator decoding one block at a time.
+		/// Holds the decoded block, hence it is rather large to copy.
+		class const_iterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type        = T;
+			using difference_type   = std::ptrdiff_t;
+			using reference         = T const&;
+			using pointer           = T const*;
+
+			const_iterator(compressed_dynarray const& owner, size_type pos);
+
+			auto operator*() const -> reference { return m_block[m_pos % block_size]; }
+			auto operator->() const -> pointer { return &m_block[m_pos % block_size]; }
+
+			auto operator++() -> const_iterator &;
+			auto operator++(int) -> const_iterator { auto it = *this; ++*this; return it; }
+
+			auto operator==(const_iterator const& rhs) const -> bool { return m_pos == rhs.m_pos; }
+			auto operator!=(const_iterator const& rhs) const -> bool { return m_pos != rhs.m_pos; }
+
+		private:
+			compressed_dynarray const* m_owner;
+			size_type                  m_pos;
+			T                          m_block[block_size];
+		};
+
+		using iterator = const_iterator;
+
+	//============================================================
+	// Constructors
+	//============================================================
+
+		/// Compresses the elements of \values.
+		explicit compressed_dynarray(dynarray<T> const& values);
+
+	//============================================================
+	// Access API
+	//============================================================
+
+		/// Returns the element at position \pos with bounds checking.
+		/// Throws out_of_range exception if \pos was illegal.
+		auto at(size_type pos) const -> T;
+
+		/// Returns the element at position \pos without bounds checking.
+		auto operator[](size_type pos) const -> T;
+
+		/// Decodes all elements of block \block into \out which must have room for
+		/// block_size elements. Elements past the end are unspecified.
+		void decode_block(size_type block, T * out) const;
+
+		/// Returns a dynarray of all elements.
+		auto decompress() const -> dynarray<T>;
+
+	//============================================================
+	// Capacity API
+	//============================================================
+
+		/// Returns `true` if this compressed_dynarray is empty and `false` otherwise.
+		auto empty() const -> bool;
+
+		/// Returns the count of elements.
+		auto size() const -> size_type;
+
+		/// Returns the count of blocks.
+		auto block_count() const -> size_type;
+
+		/// Returns the encoding of block \block.
+		auto block_encoding(size_type block) const -> encoding;
+
+		/// Returns the number of bytes allocated for the compressed elements.
+		auto memory_usage() const -> size_type;
+
+		/// Returns the size of the uncompressed elements divided by memory_usage().
+		auto compression_ratio() const -> double;
+
+	//============================================================
+	// Iterator API
+	//============================================================
+
+		auto begin() const  -> const_iterator;
+		auto cbegin() const -> const_iterator;
+		auto end() const    -> const_iterator;
+		auto cend() const   -> const_iterator;
+
+	private:
+		using unsigned_type = std::make_unsigned_t<T>;
+
+		struct block_descriptor {
+			/// Minimum for frame of reference, first element for delta blocks.
+			std::uint64_t reference;
+			/// Smallest difference of delta blocks.
+			std::uint64_t delta_base;
+			/// Position of the first packed word of the block.
+			size_type     offset;
+			std::uint8_t  bits;
+			encoding      scheme;
+		};
+
+		/// Returns the unpacked value at \index of block \b.
+		auto extract(block_descriptor const& b, size_type index) const -> std::uint64_t;
+
+		size_type                  m_size;
+		dynarray<block_descriptor> m_blocks;
+		dynarray<std::uint64_t>    m_words;
+	};
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace detail {
+		/// Number of interleaved lanes of packed blocks.
+		constexpr size_t packed_lanes = 4;
+
+		/// Returns the number of 64-bit words of a block of 128 values with \bits bits each.
+		inline auto packed_words(unsigned bits) -> size_t {
+			return packed_lanes * ((32 * bits + 63) / 64);
+		}
+
+		inline auto packed_mask(unsigned bits) -> std::uint64_t {
+			return bits >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << bits) - 1;
+		}
+
+		inline auto bit_width(std::uint64_t value) -> unsigned {
+			unsigned result = 0;
+			for (; value != 0; value >>= 1) {
+				++result;
+			}
+			return result;
+		}
+
+		/// Packs the 128 values \in with \bits bits each into \out.
+		inline void pack_block(std::uint64_t const* in, unsigned bits, std::uint64_t * out) {
+			std::fill(out, out + packed_words(bits), std::uint64_t{0});
+			for (size_t k = 0; bits != 0 && k != 32; ++k) {
+				auto const position = k * bits;
+				auto const word = position / 64;
+				auto const shift = position % 64;
+				for (size_t lane = 0; lane != packed_lanes; ++lane) {
+					auto const value = in[k * packed_lanes + lane];
+					out[word * packed_lanes + lane] |= value << shift;
+					if (shift + bits > 64) {
+						out[(word + 1) * packed_lanes + lane] |= value >> (64 - shift);
+					}
+				}
+			}
+		}
+
+		/// Returns value \index of the block packed with \bits bits per value at \in.
+		inline auto unpack_value(std::uint64_t const* in, unsigned bits, size_t index) -> std::uint64_t {
+			if (bits == 0) {
+				return 0;
+			}
+			auto const lane = index % packed_lanes;
+			auto const position = (index / packed_lanes) * bits;
+			auto const word = position / 64;
+			auto const shift = position % 64;
+			auto value = in[word * packed_lanes + lane] >> shift;
+			if (shift + bits > 64) {
+				value |= in[(word + 1) * packed_lanes + lane] << (64 - shift);
+			}
+			return value & packed_mask(bits);
+		}
+
+		/// Returns the sum of the first \count values of the block packed with \bits bits per value at \in.
+		inline auto packed_prefix_sum(std::uint64_t const* in, unsigned bits, size_t count) -> std::uint64_t {
+			if (bits == 0) {
+				return 0;
+			}
+			auto const mask = packed_mask(bits);
+			auto sum = std::uint64_t{0};
+			for (size_t k = 0; k * packed_lanes < count; ++k) {
+				auto const position = k * bits;
+				auto const word = position / 64;
+				auto const shift = position % 64;
+				auto const crosses = shift + bits > 64;
+				auto const lanes = std::min(packed_lanes, count - k * packed_lanes);
+				for (size_t lane = 0; lane != lanes; ++lane) {
+					auto value = in[word * packed_lanes + lane] >> shift;
+					if (crosses) {
+						value |= in[(word + 1) * packed_lanes + lane] << (64 - shift);
+					}
+					sum += value & mask;
+				}
+			}
+			return sum;
+		}
+
+		/// Unpacks the 128 values packed with \bits bits each at \in and adds \base to each.
+		inline void unpack_block_scalar(std::uint64_t const* in, unsigned bits, std::uint64_t base, std::uint64_t * out) {
+			if (bits == 0) {
+				std::fill(out, out + 128, base);
+				return;
+			}
+			auto const mask = packed_mask(bits);
+			for (size_t k = 0; k != 32; ++k) {
+				auto const position = k * bits;
+				auto const word = position / 64;
+				auto const shift = position % 64;
+				auto const crosses = shift + bits > 64;
+				for (size_t lane = 0; lane != packed_lanes; ++lane) {
+					auto value = in[word * packed_lanes + lane] >> shift;
+					if (crosses) {
+						value |= in[(word + 1) * packed_lanes + lane] << (64 - shift);
+					}
+					out[k * packed_lanes + lane] = base + (value & mask);
+				}
+			}
+		}
+
+	#if defined(UTILS_SIMD_X86)
+		UTILS_SIMD_TARGET("avx2")
+		inline void unpack_block_avx2(std::uint64_t const* in, unsigned bits, std::uint64_t base, std::uint64_t * out) {
+			auto const offset = _mm256_set1_epi64x(static_cast<long long>(base));
+			if (bits == 0) {
+				for (size_t k = 0; k != 32; ++k) {
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k * packed_lanes), offset);
+				}
+				return;
+			}
+			auto const mask = _mm256_set1_epi64x(static_cast<long long>(packed_mask(bits)));
+			// The shifts are the same for all four lanes.
+			for (size_t k = 0; k != 32; ++k) {
+				auto const position = k * bits;
+				auto const word = position / 64;
+				auto const shift = static_cast<int>(position % 64);
+				auto value = _mm256_srl_epi64(
+					_mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + word * packed_lanes)),
+					_mm_cvtsi32_si128(shift));
+				if (shift + static_cast<int>(bits) > 64) {
+					auto const high = _mm256_sll_epi64(
+						_mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + (word + 1) * packed_lanes)),
+						_mm_cvtsi32_si128(64 - shift));
+					value = _mm256_or_si256(value, high);
+				}
+				value = _mm256_add_epi64(_mm256_and_si256(value, mask), offset);
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k * packed_lanes), value);
+			}
+		}
+	#endif
+
+		inline void unpack_block(std::uint64_t const* in, unsigned bits, std::uint64_t base, std::uint64_t * out) {
+	#if defined(UTILS_SIMD_X86)
+			if (cpu::active_isa() >= cpu::isa::avx2) {
+				unpack_block_avx2(in, bits, base, out);
+				return;
+			}
+	#endif
+			unpack_block_scalar(in, bits, base, out);
+		}
+	}
+}
+
+template<typename T>
+constexpr typename utils::compressed_dynarray<T>::size_type utils::compressed_dynarray<T>::block_size;
+
+//============================================================
+// Constructors
+//============================================================
+
+template<typename T>
+utils::compressed_dynarray<T>::compressed_dynarray(dynarray<T> const& values):
+	m_size{values.size()},
+	m_blocks((values.size() + block_size - 1) / block_size),
+	m_words(0)
+{
+	// First pass: choose the encoding and width of every block.
+	std::uint64_t scratch[block_size];
+	size_type total_words = 0;
+	for (size_type b = 0; b != m_blocks.size(); ++b) {
+		auto const first = b * block_size;
+		auto const count = std::min(block_size, m_size - first);
+		auto minimum = values[first];
+		auto sorted = true;
+		for (size_type i = 1; i != count; ++i) {
+			minimum = std::min(minimum, values[first + i]);
+			sorted = sorted && !(values[first + i] < values[first + i - 1]);
+		}
+		auto max_offset = std::uint64_t{0};
+		for (size_type i = 0; i != count; ++i) {
+			auto const offset = static_cast<unsigned_type>(static_cast<unsigned_type>(values[first + i]) - static_cast<unsigned_type>(minimum));
+			max_offset = std::max(max_offset, static_cast<std::uint64_t>(offset));
+		}
+		auto & block = m_blocks[b];
+		block.scheme     = encoding::frame_of_reference;
+		block.reference  = static_cast<unsigned_type>(minimum);
+		block.delta_base = 0;
+		block.bits       = static_cast<std::uint8_t>(detail::bit_width(max_offset));
+		if (sorted && count > 1) {
+			auto min_delta = ~std::uint64_t{0};
+			auto max_delta = std::uint64_t{0};
+			for (size_type i = 1; i != count; ++i) {
+				auto const delta = static_cast<std::uint64_t>(static_cast<unsigned_type>(
+					static_cast<unsigned_type>(values[first + i]) - static_cast<unsigned_type>(values[first + i - 1])));
+				min_delta = std::min(min_delta, delta);
+				max_delta = std::max(max_delta, delta);
+			}
+			auto const delta_bits = detail::bit_width(max_delta - min_delta);
+			if (delta_bits < block.bits) {
+				block.scheme     = encoding::delta;
+				block.reference  = static_cast<unsigned_type>(values[first]);
+				block.delta_base = min_delta;
+				block.bits       = static_cast<std::uint8_t>(delta_bits);
+			}
+		}
+		block.offset = total_words;
+		total_words += detail::packed_words(block.bits);
+	}
+
+	// Second pass: pack. The trailing word lets unpack_value read one word past
+	// the last block without a bounds check.
+	m_words = dynarray<std::uint64_t>(total_words + detail::packed_lanes, std::uint64_t{0});
+	for (size_type b = 0; b != m_blocks.size(); ++b) {
+		auto const first = b * block_size;
+		auto const count = std::min(block_size, m_size - first);
+		auto const& block = m_blocks[b];
+		std::fill(scratch, scratch + block_size, std::uint64_t{0});
+		for (size_type i = 0; i != count; ++i) {
+			auto const value = static_cast<std::uint64_t>(static_cast<unsigned_type>(values[first + i]));
+			if (block.scheme == encoding::frame_of_reference) {
+				scratch[i] = static_cast<unsigned_type>(value - block.reference);
+			}
+			else if (i != 0) {
+				auto const previous = static_cast<std::uint64_t>(static_cast<unsigned_type>(values[first + i - 1]));
+				scratch[i] = static_cast<unsigned_type>(value - previous) - block.delta_base;
+			}
+		}
+		detail::pack_block(scratch, block.bits, m_words.data() + block.offset);
+	}
+}
+
+//============================================================
+// Access API
+//============================================================
+
+template<typename T>
+auto utils::compressed_dynarray<T>::extract(block_descriptor const& b, size_type index) const -> std::uint64_t {
+	return detail::unpack_value(m_words.data() + b.offset, b.bits, index);
+}
+
+template<typename T>
+auto utils::compressed_dynarray<T>::operator[](size_type pos) const -> T {
+	auto const& block = m_blocks[pos / block_size];
+	auto const index = pos % block_size;
+	if (block.scheme == encoding::frame_of_reference) {
+		return static_cast<T>(static_cast<unsigned_type>(block.reference + extract(block, index)));
+	}
+	// The packed difference of the first element is zero.
+	auto const sum = detail::packed_prefix_sum(m_words.data() + block.offset, block.bits, index + 1);
+	return static_cast<T>(static_cast<unsigned_type>(block.reference + index * block.delta_base + sum));
+}
+
+template<typename T>
+auto utils::compressed_dynarray<T>::at(size_type pos) const -> T {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access element at position "s +
+			std::to_string(pos) +
+			" from a compressed_dynarray with size " +
+			std::to_string(size())
+		};
+	}
+	return (*this)[pos];
+}
+
+template<typename T>
+void utils::compressed_dynarray<T>::decode_block(size_type block, T * out) const {
+	auto const& b = m_blocks[block];
+	std::uint64_t values[block_size];
+	if (b.scheme == encoding::frame_of_reference) {
+		detail::unpack_block(m_words.data() + b.offset, b.bits, b.reference, values);
+		for (size_type i = 0; i != block_size; ++i) {
+			out[i] = static_cast<T>(static_cast<unsigned_type>(values[i]));
+		}
+		return;
+	}
+	detail::unpack_block(m_words.data() + b.offset, b.bits, b.delta_base, values);
+	auto value = b.reference;
+	out[0] = static_cast<T>(static_cast<unsigned_type>(value));
+	for (size_type i = 1; i != block_size; ++i) {
+		value += values[i];
+		out[i] = static_cast<T>(static_cast<unsigned_type>(value));
+	}
+}
+
+template<typename T>
+auto utils::compressed_dynarray<T>::decompress() const -> dynarray<T> {
+	auto result = dynarray<T>(m_size);
+	T buffer[block_size];
+	for (size_type b = 0; b != m_blocks.size(); ++b) {
+		auto const first = b * block_size;
+		auto const count = std::min(block_size, m_size - first);
+		if (count == block_size) {
+			decode_block(b, result.data() + first);
+		}
+		else {
+			decode_block(b, buffer);
+			std::copy(buffer, buffer + count, result.data() + first);
+		}
+	}
+	return result;
+}
+
+//============================================================
+// Capacity API
+//============================================================
+
+template<typename T>
+auto utils::compressed_dynarray<T>::empty() const -> bool {
+	return m_size == 0;
+}
+
+template<typename T>
+auto utils::compressed_dynarray<T>::size() const -> size_type {
+	return m_size;
+}
+
+template<typename T>
+auto utils::compressed_dynarray<T>::block_count() const -> size_type {
+	return m_blocks.size();
+}
+
+template<typename T>
+auto utils::compressed_dynarray<T>::block_encoding(size_type block) const -> encoding {
+	return m_blocks[block].scheme;
+}
+
+template<typename T>
+auto utils::compressed_dynarray<T>::memory_usage() const -> size_type {
+	return m_blocks.size() * sizeof(block_descriptor) + m_words.size() * sizeof(std::uint64_t);
+}
+
+template<typename T>
+auto utils::compressed_dynarray<T>::compression_ratio() const -> double {
+	return static_cast<double>(m_size * sizeof(T)) / static_cast<double>(memory_usage());
+}
+
+//============================================================
+// Iterator API
+//============================================================
+
+template<typename T>
+utils::compressed_dynarray<T>::const_iterator::const_iterator(compressed_dynarray const& owner, size_type pos):
+	m_owner{&owner},
+	m_pos{pos}
+{
+	if (m_pos < m_owner->size()) {
+		m_owner->decode_block(m_pos / block_size, m_block);
+	}
+}
+
+template<typename T>
+auto utils::compressed_dynarray<T>::const_iterator::operator++() -> const_iterator & {
+	++m_pos;
+	if (m_pos % block_size == 0 && m_pos < m_owner->size()) {
+		m_owner->decode_block(m_pos / block_size, m_block);
+	}
+	return *this;
+}
+
+template<typename T>
+auto utils::compressed_dynarray<T>::begin() const -> const_iterator {
+	return const_iterator{*this, 0};
+}
+
+template<typename T>
+auto utils::compressed_dynarray<T>::cbegin() const -> const_iterator {
+	return begin();
+}
+
+template<typename T>
+auto utils::compressed_dynarray<T>::end() const -> const_iterator {
+	return const_iterator{*this, m_size};
+}
+
+template<typename T>
+auto utils::compressed_dynarray<T>::cend() const -> const_iterator {
+	return end();
+}
+
+#endif // UTILS_COMPRESSED_DYNARRAY_HPP
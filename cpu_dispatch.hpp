@@ -0,0 +1,182 @@
+//===---------------------------------------------------------
+//                       CPU_DISPATCH
+//===---------------------------------------------------------
+//
+// Runtime detection of the instruction set extensions of the
+// executing CPU and selection of the kernel path used by the
+// vectorized dynarray operations.
+//
+// The features are queried once via cpuid and xgetbv, which
+// also verifies that the operating system saves the wide
+// vector registers. Kernels are compiled per instruction set
+// with target attributes, hence a binary built with baseline
+// flags still runs on old CPUs and uses AVX2 or AVX-512 on
+// new ones.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_CPU_DISPATCH_HPP
+#define UTILS_CPU_DISPATCH_HPP
+
+// headers used by declaration site
+#include <cstddef>
+
+// headers used by definition site
+#include <atomic>
+
+// The vector kernels require GCC or Clang on x86 for the target
+// attribute and inline assembly.
+#if !defined(UTILS_SIMD_X86) && (defined(__GNUC__) || defined(__clang__)) \
+	&& (defined(__x86_64__) || defined(__i386__))
+	#define UTILS_SIMD_X86 1
+#endif
+
+#if defined(UTILS_SIMD_X86)
+	#include <cpuid.h>
+	#include <immintrin.h>
+	#define UTILS_SIMD_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	namespace cpu {
+		/// Instruction set extensions relevant for the dynarray kernels
+		/// that are supported by the executing CPU and operating system.
+		struct features {
+			bool sse2;
+			bool sse42;
+			bool popcnt;
+			bool avx;
+			bool avx2;
+			bool fma;
+			bool avx512f;
+			bool avx512bw;
+		};
+
+		/// Kernel paths, ordered from least to most capable.
+		enum class isa {
+			scalar,
+			sse2,
+			avx2,
+			/// Requires AVX-512F and AVX-512BW.
+			avx512
+		};
+
+		/// Returns the features of the executing CPU. Detected on first use.
+		auto detected_features() -> features const&;
+
+		/// Returns the most capable isa supported by the executing CPU.
+		auto detected_isa() -> isa;
+
+		/// Returns the isa currently used by all dispatched kernels.
+		/// Defaults to detected_isa().
+		auto active_isa() -> isa;
+
+		/// Restricts all dispatched kernels to \requested or to detected_isa(),
+		/// whichever is less capable. Returns the isa that is active afterwards.
+		/// Intended for benchmarking, testing and as an operational fallback.
+		auto set_active_isa(isa requested) -> isa;
+
+		/// Returns a human readable name of \path for logging, e.g. "avx2".
+		auto name(isa path) -> char const*;
+	}
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace cpu {
+		namespace detail {
+			inline auto detect_features() -> features {
+				auto result = features{false, false, false, false, false, false, false, false};
+#if defined(UTILS_SIMD_X86)
+				unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+				if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) {
+					return result;
+				}
+				result.sse2   = (edx & (1u << 26)) != 0;
+				result.sse42  = (ecx & (1u << 20)) != 0;
+				result.popcnt = (ecx & (1u << 23)) != 0;
+				auto const has_fma     = (ecx & (1u << 12)) != 0;
+				auto const has_osxsave = (ecx & (1u << 27)) != 0;
+				auto const has_avx     = (ecx & (1u << 28)) != 0;
+				if (!has_osxsave || !has_avx) {
+					return result;
+				}
+				// The operating system must save the XMM and YMM state (bits 1, 2)
+				// and for AVX-512 also the opmask and ZMM state (bits 5, 6, 7).
+				unsigned xcr0_low = 0, xcr0_high = 0;
+				__asm__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+				if ((xcr0_low & 0x06u) != 0x06u) {
+					return result;
+				}
+				result.avx = true;
+				result.fma = has_fma;
+				if (__get_cpuid_max(0, nullptr) < 7) {
+					return result;
+				}
+				__cpuid_count(7, 0, eax, ebx, ecx, edx);
+				result.avx2 = (ebx & (1u << 5)) != 0;
+				if ((xcr0_low & 0xE6u) == 0xE6u) {
+					result.avx512f  = (ebx & (1u << 16)) != 0;
+					result.avx512bw = (ebx & (1u << 30)) != 0;
+				}
+#endif
+				return result;
+			}
+
+			inline auto active_isa_storage() -> std::atomic<isa> & {
+				static std::atomic<isa> active{detected_isa()};
+				return active;
+			}
+		}
+	}
+}
+
+inline auto utils::cpu::detected_features() -> features const& {
+	static auto const detected = detail::detect_features();
+	return detected;
+}
+
+inline auto utils::cpu::detected_isa() -> isa {
+	auto const& f = detected_features();
+	if (f.avx512f && f.avx512bw) { return isa::avx512; }
+	if (f.avx2)                  { return isa::avx2; }
+	if (f.sse2)                  { return isa::sse2; }
+	return isa::scalar;
+}
+
+inline auto utils::cpu::active_isa() -> isa {
+	return detail::active_isa_storage().load(std::memory_order_relaxed);
+}
+
+inline auto utils::cpu::set_active_isa(isa requested) -> isa {
+	auto const detected = detected_isa();
+	auto const selected = requested < detected ? requested : detected;
+	detail::active_isa_storage().store(selected, std::memory_order_relaxed);
+	return selected;
+}
+
+inline auto utils::cpu::name(isa path) -> char const* {
+	switch (path) {
+		case isa::scalar: return "scalar";
+		case isa::sse2:   return "sse2";
+		case isa::avx2:   return "avx2";
+		case isa::avx512: return "avx512";
+	}
+	return "unknown";
+}
+
+#endif // UTILS_CPU_DISPATCH_HPP
@@ -0,0 +1,504 @@
+//===---------------------------------------------------------
+//                       DELTA_DYNARRAY
+//===---------------------------------------------------------
+//
+// Immutable delta-encoded dynarray of sorted 32-bit integers
+// for posting lists and sorted identifier sets, with a skip
+// table for searching and intersecting without decoding
+// every block.
+//
+// The elements are split into blocks of 128 elements which
+// are stored as bit-packed differences with a stride of
+// eight: the difference of an element is taken to the
+// element eight positions before it, or to the first element
+// of its block for the first eight. With the packed values
+// interleaved over eight 32-bit lanes, decoding a block is
+// a running vector sum over sixteen groups of eight, which
+// AVX2 (see cpu_dispatch.hpp) computes one group at a time.
+//
+// The skip table holds the first and last element of every
+// block. lower_bound searches it before decoding the single
+// block that may contain the key, and intersect skips the
+// blocks ending before the next element of the other side.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_DELTA_DYNARRAY_HPP
+#define UTILS_DELTA_DYNARRAY_HPP
+
+// headers used by declaration site
+#include "cpu_dispatch.hpp"
+#include "dynarray.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+// headers used by definition site
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// Immutable dynarray of non-decreasing 32-bit integers stored as bit-packed differences.
+	class delta_dynarray {
+	public:
+		using value_type = std::uint32_t;
+		using size_type  = size_t;
+
+		/// The number of elements per block.
+		static constexpr size_type block_size = 128;
+
+	//============================================================
+	// Constructors
+	//============================================================
+
+		/// Compresses the elements of \sorted.
+		/// Throws an invalid_argument exception if \sorted is not sorted.
+		explicit delta_dynarray(dynarray<value_type> const& sorted);
+
+	//============================================================
+	// Access API
+	//============================================================
+
+		/// Returns the element at position \pos with bounds checking.
+		/// Throws out_of_range exception if \pos was illegal.
+		auto at(size_type pos) const -> value_type;
+
+		/// Returns the element at position \pos without bounds checking.
+		auto operator[](size_type pos) const -> value_type;
+
+		/// Returns the position of the first element not less than \key
+		/// or size() if there is no such element.
+		auto lower_bound(value_type key) const -> size_type;
+
+		/// Returns `true` if \key is an element and `false` otherwise.
+		auto contains(value_type key) const -> bool;
+
+		/// Returns a dynarray of all elements.
+		auto decompress() const -> dynarray<value_type>;
+
+	//============================================================
+	// Block API
+	//============================================================
+
+		/// Returns the count of blocks.
+		auto block_count() const -> size_type;
+
+		/// Returns the first element of block \block.
+		auto block_first(size_type block) const -> value_type;
+
+		/// Returns the last element of block \block.
+		auto block_last(size_type block) const -> value_type;
+
+		/// Returns the first block from \from onward whose last element is not
+		/// less than \key or block_count() if there is no such block.
+		auto find_block(value_type key, size_type from = 0) const -> size_type;
+
+		/// Decodes block \block into \out which must have room for block_size
+		/// elements and returns the count of elements of the block.
+		auto decode_block(size_type block, value_type * out) const -> size_type;
+
+	//============================================================
+	// Capacity API
+	//============================================================
+
+		/// Returns `true` if this delta_dynarray is empty and `false` otherwise.
+		auto empty() const -> bool;
+
+		/// Returns the count of elements.
+		auto size() const -> size_type;
+
+		/// Returns the number of bytes allocated for the compressed elements and skip table.
+		auto memory_usage() const -> size_type;
+
+		/// Returns the size of the uncompressed elements divided by memory_usage().
+		auto compression_ratio() const -> double;
+
+	private:
+		struct block_descriptor {
+			/// Position of the first packed word of the block.
+			size_type    offset;
+			std::uint8_t bits;
+		};
+
+		size_type                  m_size;
+		dynarray<value_type>       m_first;
+		dynarray<value_type>       m_last;
+		dynarray<block_descriptor> m_blocks;
+		dynarray<std::uint32_t>    m_words;
+	};
+
+	/// Returns the elements common to \lhs and \rhs in ascending order.
+	/// Blocks ending before the next element of the other side are skipped without being decoded.
+	auto intersect(delta_dynarray const& lhs, delta_dynarray const& rhs) -> dynarray<std::uint32_t>;
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace detail {
+		/// Number of interleaved lanes and stride of the differences.
+		constexpr size_t delta_lanes = 8;
+
+		/// Number of groups of delta_lanes values per block.
+		constexpr size_t delta_groups = delta_dynarray::block_size / delta_lanes;
+
+		/// Returns the number of 32-bit words of a block with \bits bits per value.
+		inline auto delta_packed_words(unsigned bits) -> size_t {
+			return delta_lanes * ((delta_groups * bits + 31) / 32);
+		}
+
+		inline auto delta_mask(unsigned bits) -> std::uint32_t {
+			return bits >= 32 ? ~std::uint32_t{0} : (std::uint32_t{1} << bits) - 1;
+		}
+
+		/// Returns the value of \lane in \group of the block packed with \bits bits per value at \in.
+		inline auto delta_unpack_value(std::uint32_t const* in, unsigned bits, size_t group, size_t lane) -> std::uint32_t {
+			auto const position = group * bits;
+			auto const word = position / 32;
+			auto const shift = position % 32;
+			auto value = in[word * delta_lanes + lane] >> shift;
+			if (shift + bits > 32) {
+				value |= in[(word + 1) * delta_lanes + lane] << (32 - shift);
+			}
+			return value & delta_mask(bits);
+		}
+
+		/// Decodes the 128 differences packed with \bits bits each at \in
+		/// by a running sum per lane starting at \first.
+		inline void delta_decode_scalar(std::uint32_t const* in, unsigned bits, std::uint32_t first, std::uint32_t * out) {
+			std::uint32_t running[delta_lanes];
+			std::fill(running, running + delta_lanes, first);
+			auto const mask = delta_mask(bits);
+			for (size_t group = 0; group != delta_groups; ++group) {
+				auto const position = group * bits;
+				auto const word = position / 32;
+				auto const shift = position % 32;
+				auto const crosses = shift + bits > 32;
+				for (size_t lane = 0; lane != delta_lanes; ++lane) {
+					auto value = bits == 0 ? 0 : in[word * delta_lanes + lane] >> shift;
+					if (crosses) {
+						value |= in[(word + 1) * delta_lanes + lane] << (32 - shift);
+					}
+					running[lane] += value & mask;
+					out[group * delta_lanes + lane] = running[lane];
+				}
+			}
+		}
+
+	#if defined(UTILS_SIMD_X86)
+		UTILS_SIMD_TARGET("avx2")
+		inline void delta_decode_avx2(std::uint32_t const* in, unsigned bits, std::uint32_t first, std::uint32_t * out) {
+			auto running = _mm256_set1_epi32(static_cast<int>(first));
+			if (bits == 0) {
+				for (size_t group = 0; group != delta_groups; ++group) {
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + group * delta_lanes), running);
+				}
+				return;
+			}
+			auto const mask = _mm256_set1_epi32(static_cast<int>(delta_mask(bits)));
+			// The shifts are the same for all eight lanes.
+			for (size_t group = 0; group != delta_groups; ++group) {
+				auto const position = group * bits;
+				auto const word = position / 32;
+				auto const shift = static_cast<int>(position % 32);
+				auto value = _mm256_srl_epi32(
+					_mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + word * delta_lanes)),
+					_mm_cvtsi32_si128(shift));
+				if (shift + static_cast<int>(bits) > 32) {
+					auto const high = _mm256_sll_epi32(
+						_mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + (word + 1) * delta_lanes)),
+						_mm_cvtsi32_si128(32 - shift));
+					value = _mm256_or_si256(value, high);
+				}
+				running = _mm256_add_epi32(running, _mm256_and_si256(value, mask));
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + group * delta_lanes), running);
+			}
+		}
+	#endif
+
+		inline void delta_decode(std::uint32_t const* in, unsigned bits, std::uint32_t first, std::uint32_t * out) {
+	#if defined(UTILS_SIMD_X86)
+			if (cpu::active_isa() >= cpu::isa::avx2) {
+				delta_decode_avx2(in, bits, first, out);
+				return;
+			}
+	#endif
+			delta_decode_scalar(in, bits, first, out);
+		}
+	}
+}
+
+constexpr utils::delta_dynarray::size_type utils::delta_dynarray::block_size;
+
+//============================================================
+// Constructors
+//============================================================
+
+inline utils::delta_dynarray::delta_dynarray(dynarray<value_type> const& sorted):
+	m_size{sorted.size()},
+	m_first((sorted.size() + block_size - 1) / block_size),
+	m_last((sorted.size() + block_size - 1) / block_size),
+	m_blocks((sorted.size() + block_size - 1) / block_size),
+	m_words(0)
+{
+	if (!std::is_sorted(sorted.begin(), sorted.end())) {
+		using namespace std::string_literals;
+		throw std::invalid_argument{"cannot build delta_dynarray from unsorted elements"s};
+	}
+
+	// The difference of element j is taken to element j - 8, or to the first element
+	// of the block for the first group. Padding past the end repeats the last element.
+	auto const difference = [&](size_type first, size_type j) {
+		auto const element = [&](size_type i) { return sorted[std::min(first + i, m_size - 1)]; };
+		return element(j) - (j < detail::delta_lanes ? element(0) : element(j - detail::delta_lanes));
+	};
+
+	// First pass: fill the skip table and choose the width of every block.
+	size_type total_words = 0;
+	for (size_type b = 0; b != m_blocks.size(); ++b) {
+		auto const first = b * block_size;
+		auto const count = std::min(block_size, m_size - first);
+		auto max_difference = value_type{0};
+		for (size_type j = 0; j != block_size; ++j) {
+			max_difference = std::max(max_difference, difference(first, j));
+		}
+		unsigned bits = 0;
+		for (; bits < 32 && (max_difference >> bits) != 0; ++bits) {}
+		m_first[b] = sorted[first];
+		m_last[b] = sorted[first + count - 1];
+		m_blocks[b].offset = total_words;
+		m_blocks[b].bits = static_cast<std::uint8_t>(bits);
+		total_words += detail::delta_packed_words(bits);
+	}
+
+	// Second pass: pack.
+	m_words = dynarray<std::uint32_t>(total_words, std::uint32_t{0});
+	for (size_type b = 0; b != m_blocks.size(); ++b) {
+		auto const first = b * block_size;
+		auto const bits = m_blocks[b].bits;
+		auto const out = m_words.data() + m_blocks[b].offset;
+		for (size_type j = 0; bits != 0 && j != block_size; ++j) {
+			auto const value = difference(first, j);
+			auto const lane = j % detail::delta_lanes;
+			auto const position = (j / detail::delta_lanes) * bits;
+			auto const word = position / 32;
+			auto const shift = position % 32;
+			out[word * detail::delta_lanes + lane] |= value << shift;
+			if (shift + bits > 32) {
+				out[(word + 1) * detail::delta_lanes + lane] |= value >> (32 - shift);
+			}
+		}
+	}
+}
+
+//============================================================
+// Access API
+//============================================================
+
+inline auto utils::delta_dynarray::operator[](size_type pos) const -> value_type {
+	auto const b = pos / block_size;
+	auto const index = pos % block_size;
+	auto const& block = m_blocks[b];
+	auto value = m_first[b];
+	if (block.bits == 0) {
+		return value;
+	}
+	// Only the differences of the element's own lane contribute.
+	auto const in = m_words.data() + block.offset;
+	auto const lane = index % detail::delta_lanes;
+	for (size_type group = 0; group <= index / detail::delta_lanes; ++group) {
+		value += detail::delta_unpack_value(in, block.bits, group, lane);
+	}
+	return value;
+}
+
+inline auto utils::delta_dynarray::at(size_type pos) const -> value_type {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access element at position "s +
+			std::to_string(pos) +
+			" from a delta_dynarray with size " +
+			std::to_string(size())
+		};
+	}
+	return (*this)[pos];
+}
+
+inline auto utils::delta_dynarray::lower_bound(value_type key) const -> size_type {
+	auto const b = find_block(key);
+	if (b == block_count()) {
+		return m_size;
+	}
+	if (key <= m_first[b]) {
+		return b * block_size;
+	}
+	value_type values[block_size];
+	auto const count = decode_block(b, values);
+	auto position = size_type{0};
+	for (size_type i = 0; i != count; ++i) {
+		position += values[i] < key;
+	}
+	return b * block_size + position;
+}
+
+inline auto utils::delta_dynarray::contains(value_type key) const -> bool {
+	auto const pos = lower_bound(key);
+	return pos != m_size && (*this)[pos] == key;
+}
+
+inline auto utils::delta_dynarray::decompress() const -> dynarray<value_type> {
+	auto result = dynarray<value_type>(m_size);
+	value_type buffer[block_size];
+	for (size_type b = 0; b != block_count(); ++b) {
+		auto const first = b * block_size;
+		if (m_size - first >= block_size) {
+			decode_block(b, result.data() + first);
+		}
+		else {
+			auto const count = decode_block(b, buffer);
+			std::copy(buffer, buffer + count, result.data() + first);
+		}
+	}
+	return result;
+}
+
+//============================================================
+// Block API
+//============================================================
+
+inline auto utils::delta_dynarray::block_count() const -> size_type {
+	return m_blocks.size();
+}
+
+inline auto utils::delta_dynarray::block_first(size_type block) const -> value_type {
+	return m_first[block];
+}
+
+inline auto utils::delta_dynarray::block_last(size_type block) const -> value_type {
+	return m_last[block];
+}
+
+inline auto utils::delta_dynarray::find_block(value_type key, size_type from) const -> size_type {
+	if (from >= block_count() || m_last[block_count() - 1] < key) {
+		return block_count();
+	}
+	// Branchless search for the first block whose last element is not less than key.
+	auto first = from;
+	auto length = block_count() - from;
+	while (length > 1) {
+		auto const half = length / 2;
+		first = m_last[first + half - 1] < key ? first + half : first;
+		length -= half;
+	}
+	return first;
+}
+
+inline auto utils::delta_dynarray::decode_block(size_type block, value_type * out) const -> size_type {
+	auto const& b = m_blocks[block];
+	detail::delta_decode(m_words.data() + b.offset, b.bits, m_first[block], out);
+	return std::min(block_size, m_size - block * block_size);
+}
+
+//============================================================
+// Capacity API
+//============================================================
+
+inline auto utils::delta_dynarray::empty() const -> bool {
+	return m_size == 0;
+}
+
+inline auto utils::delta_dynarray::size() const -> size_type {
+	return m_size;
+}
+
+inline auto utils::delta_dynarray::memory_usage() const -> size_type {
+	return m_first.size() * sizeof(value_type)
+		+ m_last.size() * sizeof(value_type)
+		+ m_blocks.size() * sizeof(block_descriptor)
+		+ m_words.size() * sizeof(std::uint32_t);
+}
+
+inline auto utils::delta_dynarray::compression_ratio() const -> double {
+	return static_cast<double>(m_size * sizeof(value_type)) / static_cast<double>(memory_usage());
+}
+
+//============================================================
+// Intersection
+//============================================================
+
+inline auto utils::intersect(delta_dynarray const& lhs, delta_dynarray const& rhs) -> dynarray<std::uint32_t> {
+	using size_type = delta_dynarray::size_type;
+	constexpr auto block_size = delta_dynarray::block_size;
+
+	auto common = dynarray<std::uint32_t>(std::min(lhs.size(), rhs.size()));
+	auto found = size_type{0};
+
+	std::uint32_t lhs_values[block_size];
+	std::uint32_t rhs_values[block_size];
+	// Block indices, positions inside the decoded blocks and their sizes.
+	auto lb = size_type{0}, rb = size_type{0};
+	auto li = size_type{0}, ri = size_type{0};
+	auto ln = size_type{0}, rn = size_type{0};
+	while (lb != lhs.block_count() && rb != rhs.block_count()) {
+		// Skip by the smallest remaining element of either side, which lets a
+		// sparse list skip most blocks of a dense one.
+		auto const lhs_next = ln != 0 ? lhs_values[li] : lhs.block_first(lb);
+		auto const rhs_next = rn != 0 ? rhs_values[ri] : rhs.block_first(rb);
+		if (lhs.block_last(lb) < rhs_next) {
+			lb = lhs.find_block(rhs_next, lb + 1);
+			ln = 0;
+			continue;
+		}
+		if (rhs.block_last(rb) < lhs_next) {
+			rb = rhs.find_block(lhs_next, rb + 1);
+			rn = 0;
+			continue;
+		}
+		if (ln == 0) {
+			ln = lhs.decode_block(lb, lhs_values);
+			li = 0;
+		}
+		if (rn == 0) {
+			rn = rhs.decode_block(rb, rhs_values);
+			ri = 0;
+		}
+		while (li != ln && ri != rn) {
+			auto const l = lhs_values[li];
+			auto const r = rhs_values[ri];
+			if (l == r) {
+				common[found++] = l;
+			}
+			li += l <= r;
+			ri += r <= l;
+		}
+		if (li == ln) {
+			++lb;
+			ln = 0;
+		}
+		if (ri == rn) {
+			++rb;
+			rn = 0;
+		}
+	}
+
+	auto result = dynarray<std::uint32_t>(found);
+	std::copy(common.data(), common.data() + found, result.data());
+	return result;
+}
+
+#endif // UTILS_DELTA_DYNARRAY_HPP
@@ -0,0 +1,324 @@
+//===---------------------------------------------------------
+//                       DICT_DYNARRAY
+//===---------------------------------------------------------
+//
+// Immutable dictionary-encoded dynarray for columns with few
+// distinct values, such as strings or wide enumerations.
+//
+// At construction every distinct value is stored once in a
+// dictionary, ordered by first appearance, and the elements
+// are replaced by their positions in the dictionary, the
+// codes. Codes are 1, 2 or 4 bytes wide, the narrowest width
+// that fits the number of distinct values.
+//
+// Equality predicates look the value up in the dictionary
+// once and then compare codes only: count and find_all run
+// the count and find kernels of dynarray_bulk.hpp over the
+// code array, whose vector width is picked at runtime.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_DICT_DYNARRAY_HPP
+#define UTILS_DICT_DYNARRAY_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+// headers used by definition site
+#include "dynarray_bulk.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// Immutable dynarray storing a dictionary of distinct values and a code per element.
+	/// T must be default constructible, copy assignable and hashable by \Hash.
+	/// Holds at most 2^32 distinct values.
+	template<typename T, typename Hash = std::hash<T>>
+	class dict_dynarray {
+	public:
+		using value_type = T;
+		using size_type  = size_t;
+		using code_type  = std::uint32_t;
+
+	//============================================================
+	// Constructors
+	//============================================================
+
+		/// Encodes the elements of \values.
+		explicit dict_dynarray(dynarray<T> const& values);
+
+	//============================================================
+	// Access API
+	//============================================================
+
+		/// Returns the element at position \pos with bounds checking.
+		/// Throws out_of_range exception if \pos was illegal.
+		auto at(size_type pos) const -> T const&;
+
+		/// Returns the element at position \pos without bounds checking.
+		auto operator[](size_type pos) const -> T const&;
+
+		/// Returns the code of the element at position \pos without bounds checking.
+		auto code_at(size_type pos) const -> code_type;
+
+		/// Returns the code of \value or cardinality() if \value is not in the dictionary.
+		auto code_of(T const& value) const -> code_type;
+
+		/// Returns a dynarray of all elements.
+		auto decompress() const -> dynarray<T>;
+
+	//============================================================
+	// Search API
+	//============================================================
+
+		/// Returns the number of elements equal to \value.
+		auto count(T const& value) const -> size_type;
+
+		/// Returns the ascending positions of all elements equal to \value.
+		auto find_all(T const& value) const -> dynarray<size_type>;
+
+	//============================================================
+	// Capacity API
+	//============================================================
+
+		/// Returns `true` if this dict_dynarray is empty and `false` otherwise.
+		auto empty() const -> bool;
+
+		/// Returns the count of elements.
+		auto size() const -> size_type;
+
+		/// Returns the distinct values in order of their first appearance.
+		/// The code of a value is its position in the dictionary.
+		auto dictionary() const -> dynarray<T> const&;
+
+		/// Returns the count of distinct values.
+		auto cardinality() const -> size_type;
+
+		/// Returns the width of the codes in bytes: 1, 2 or 4.
+		auto code_width() const -> size_type;
+
+		/// Returns the number of bytes of the codes and dictionary entries,
+		/// excluding memory owned by the values and the lookup table.
+		auto memory_usage() const -> size_type;
+
+	private:
+		/// Returns the index of the bulk kernels for the code width.
+		auto kernel_index() const -> size_t;
+
+		size_type                              m_size;
+		size_type                              m_width;
+		dynarray<T>                            m_dictionary;
+		std::unordered_map<T, code_type, Hash> m_lookup;
+		dynarray<unsigned char>                m_codes;
+	};
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace detail {
+		/// Returns the narrowest code width in bytes for \cardinality distinct values.
+		inline auto dict_code_width(size_t cardinality) -> size_t {
+			return cardinality <= 0x100 ? 1 : cardinality <= 0x10000 ? 2 : 4;
+		}
+
+		/// A code narrowed to the code width, as pointed to by the bulk kernels.
+		struct dict_needle {
+			explicit dict_needle(std::uint32_t code):
+				narrow8{static_cast<std::uint8_t>(code)},
+				narrow16{static_cast<std::uint16_t>(code)},
+				narrow32{code}
+			{}
+
+			auto get(size_t width) const -> void const* {
+				return width == 1 ? static_cast<void const*>(&narrow8)
+				     : width == 2 ? static_cast<void const*>(&narrow16)
+				     : static_cast<void const*>(&narrow32);
+			}
+
+			std::uint8_t  narrow8;
+			std::uint16_t narrow16;
+			std::uint32_t narrow32;
+		};
+	}
+}
+
+//============================================================
+// Constructors
+//============================================================
+
+template<typename T, typename Hash>
+utils::dict_dynarray<T, Hash>::dict_dynarray(dynarray<T> const& values):
+	m_size{values.size()},
+	m_width{1},
+	m_dictionary(0),
+	m_lookup{},
+	m_codes(0)
+{
+	// Codes are collected wide first since the width depends on the cardinality.
+	auto wide = dynarray<code_type>(m_size);
+	for (size_type i = 0; i != m_size; ++i) {
+		// Most elements repeat a value, so look up before emplace allocates a node.
+		auto const entry = m_lookup.find(values[i]);
+		if (entry != m_lookup.end()) {
+			wide[i] = entry->second;
+			continue;
+		}
+		auto const next = static_cast<code_type>(m_lookup.size());
+		m_lookup.emplace(values[i], next);
+		wide[i] = next;
+	}
+
+	m_dictionary = dynarray<T>(m_lookup.size());
+	for (auto const& entry : m_lookup) {
+		m_dictionary[entry.second] = entry.first;
+	}
+
+	m_width = detail::dict_code_width(m_lookup.size());
+	m_codes = dynarray<unsigned char>(m_size * m_width);
+	for (size_type i = 0; i != m_size; ++i) {
+		detail::dict_needle const code{wide[i]};
+		std::memcpy(m_codes.data() + i * m_width, code.get(m_width), m_width);
+	}
+}
+
+//============================================================
+// Access API
+//============================================================
+
+template<typename T, typename Hash>
+auto utils::dict_dynarray<T, Hash>::at(size_type pos) const -> T const& {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access element at position "s +
+			std::to_string(pos) +
+			" from a dict_dynarray with size " +
+			std::to_string(size())
+		};
+	}
+	return (*this)[pos];
+}
+
+template<typename T, typename Hash>
+auto utils::dict_dynarray<T, Hash>::operator[](size_type pos) const -> T const& {
+	return m_dictionary[code_at(pos)];
+}
+
+template<typename T, typename Hash>
+auto utils::dict_dynarray<T, Hash>::code_at(size_type pos) const -> code_type {
+	auto const code = m_codes.data() + pos * m_width;
+	switch (m_width) {
+		case 1: return bulk::detail::load_element<1>(code);
+		case 2: return static_cast<code_type>(bulk::detail::load_element<2>(code));
+	}
+	return static_cast<code_type>(bulk::detail::load_element<4>(code));
+}
+
+template<typename T, typename Hash>
+auto utils::dict_dynarray<T, Hash>::code_of(T const& value) const -> code_type {
+	auto const entry = m_lookup.find(value);
+	return entry != m_lookup.end() ? entry->second : static_cast<code_type>(cardinality());
+}
+
+template<typename T, typename Hash>
+auto utils::dict_dynarray<T, Hash>::decompress() const -> dynarray<T> {
+	auto result = dynarray<T>(m_size);
+	for (size_type i = 0; i != m_size; ++i) {
+		result[i] = (*this)[i];
+	}
+	return result;
+}
+
+//============================================================
+// Search API
+//============================================================
+
+template<typename T, typename Hash>
+auto utils::dict_dynarray<T, Hash>::kernel_index() const -> size_t {
+	return m_width == 1 ? 0 : m_width == 2 ? 1 : 2;
+}
+
+template<typename T, typename Hash>
+auto utils::dict_dynarray<T, Hash>::count(T const& value) const -> size_type {
+	auto const code = code_of(value);
+	if (code == cardinality()) {
+		return 0;
+	}
+	detail::dict_needle const needle{code};
+	return bulk::kernels().count[kernel_index()](m_codes.data(), m_size, needle.get(m_width));
+}
+
+template<typename T, typename Hash>
+auto utils::dict_dynarray<T, Hash>::find_all(T const& value) const -> dynarray<size_type> {
+	auto const code = code_of(value);
+	if (code == cardinality()) {
+		return dynarray<size_type>(0);
+	}
+	detail::dict_needle const needle{code};
+	auto const& kernels = bulk::kernels();
+	auto const find = kernels.find[kernel_index()];
+	auto result = dynarray<size_type>(kernels.count[kernel_index()](m_codes.data(), m_size, needle.get(m_width)));
+	auto pos = size_type{0};
+	for (auto & position : result) {
+		pos += find(m_codes.data() + pos * m_width, m_size - pos, needle.get(m_width));
+		position = pos++;
+	}
+	return result;
+}
+
+//============================================================
+// Capacity API
+//============================================================
+
+template<typename T, typename Hash>
+auto utils::dict_dynarray<T, Hash>::empty() const -> bool {
+	return m_size == 0;
+}
+
+template<typename T, typename Hash>
+auto utils::dict_dynarray<T, Hash>::size() const -> size_type {
+	return m_size;
+}
+
+template<typename T, typename Hash>
+auto utils::dict_dynarray<T, Hash>::dictionary() const -> dynarray<T> const& {
+	return m_dictionary;
+}
+
+template<typename T, typename Hash>
+auto utils::dict_dynarray<T, Hash>::cardinality() const -> size_type {
+	return m_dictionary.size();
+}
+
+template<typename T, typename Hash>
+auto utils::dict_dynarray<T, Hash>::code_width() const -> size_type {
+	return m_width;
+}
+
+template<typename T, typename Hash>
+auto utils::dict_dynarray<T, Hash>::memory_usage() const -> size_type {
+	return m_codes.size() + m_dictionary.size() * sizeof(T);
+}
+
+#endif // UTILS_DICT_DYNARRAY_HPP
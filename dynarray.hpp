@@ -25,14 +25,22 @@
 
 // headers used by declaration site
 #include <cstddef>
+#include <functional>
 #include <memory>
 #include <iterator>
 #include <initializer_list>
 
+#if defined(__cpp_impl_three_way_comparison) && __cplusplus > 201703L
+	#include <compare>
+#endif
+
 // headers used by definition site
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 
 //============================================================
 // DECLARATION
@@ -246,6 +254,48 @@ namespace utils {
 		std::unique_ptr<T[]> m_data;
 		size_type            m_size;
 	};
+
+	//============================================================
+	// Comparison API
+	//============================================================
+
+	/// Returns `true` if \lhs and \rhs have equal sizes and equal elements.
+	/// Compares the memory of integral, enum and pointer elements with memcmp.
+	template<typename T>
+	auto operator==(dynarray<T> const& lhs, dynarray<T> const& rhs) -> bool;
+
+	template<typename T>
+	auto operator!=(dynarray<T> const& lhs, dynarray<T> const& rhs) -> bool;
+
+	/// Returns `true` if \lhs is lexicographically less than \rhs.
+	/// Skips equal prefixes of integral, enum and pointer elements with memcmp.
+	template<typename T>
+	auto operator<(dynarray<T> const& lhs, dynarray<T> const& rhs) -> bool;
+
+	template<typename T>
+	auto operator<=(dynarray<T> const& lhs, dynarray<T> const& rhs) -> bool;
+
+	template<typename T>
+	auto operator>(dynarray<T> const& lhs, dynarray<T> const& rhs) -> bool;
+
+	template<typename T>
+	auto operator>=(dynarray<T> const& lhs, dynarray<T> const& rhs) -> bool;
+
+#if defined(__cpp_lib_three_way_comparison)
+	/// Compares \lhs and \rhs lexicographically.
+	template<typename T>
+	auto operator<=>(dynarray<T> const& lhs, dynarray<T> const& rhs)
+		-> decltype(std::declval<T const&>() <=> std::declval<T const&>());
+#endif
+}
+
+namespace std {
+	/// Hashes the memory of dynarrays of integral, enum and pointer elements in
+	/// bulk and combines std::hash of the elements for all other element types.
+	template<typename T>
+	struct hash<utils::dynarray<T>> {
+		auto operator()(utils::dynarray<T> const& array) const -> size_t;
+	};
 }
 
 //============================================================
@@ -535,4 +585,177 @@ auto utils::dynarray<T>::crend() const -> const_reverse_iterator {
 	return reverse_iterator{cbegin()};
 }
 
+//============================================================
+// Comparison API
+//============================================================
+
+namespace utils {
+	namespace detail {
+		/// Element types whose equality is the equality of their memory.
+		template<typename T>
+		struct is_bitwise_comparable : std::integral_constant<bool,
+			std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value> {};
+
+		/// Returns the position of the first unequal pair of elements or \size.
+		template<typename T>
+		auto dynarray_mismatch(T const* lhs, T const* rhs, size_t size, std::true_type) -> size_t {
+			// memcmp compares whole blocks with vector instructions; only the
+			// block holding the first difference is compared elementwise.
+			constexpr size_t block = 256 / sizeof(T) > 0 ? 256 / sizeof(T) : 1;
+			size_t i = 0;
+			while (size - i >= block && std::memcmp(lhs + i, rhs + i, block * sizeof(T)) == 0) {
+				i += block;
+			}
+			while (i != size && lhs[i] == rhs[i]) {
+				++i;
+			}
+			return i;
+		}
+
+		template<typename T>
+		auto dynarray_mismatch(T const* lhs, T const* rhs, size_t size, std::false_type) -> size_t {
+			return static_cast<size_t>(std::mismatch(lhs, lhs + size, rhs).first - lhs);
+		}
+
+		template<typename T>
+		auto dynarray_equal(dynarray<T> const& lhs, dynarray<T> const& rhs, std::true_type) -> bool {
+			return lhs.empty() || std::memcmp(lhs.data(), rhs.data(), lhs.size() * sizeof(T)) == 0;
+		}
+
+		template<typename T>
+		auto dynarray_equal(dynarray<T> const& lhs, dynarray<T> const& rhs, std::false_type) -> bool {
+			return std::equal(lhs.begin(), lhs.end(), rhs.begin());
+		}
+
+		/// 64-bit xxHash (XXH64) of \size bytes at \data. Its four independent
+		/// lanes process 32 bytes per iteration.
+		inline auto hash_bytes(void const* data, size_t size, std::uint64_t seed) -> std::uint64_t {
+			constexpr std::uint64_t prime1 = 0x9E3779B185EBCA87ull;
+			constexpr std::uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+			constexpr std::uint64_t prime3 = 0x165667B19E3779F9ull;
+			constexpr std::uint64_t prime4 = 0x85EBCA77C2B2AE63ull;
+			constexpr std::uint64_t prime5 = 0x27D4EB2F165667C5ull;
+			auto const rotl = [](std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+			auto const read64 = [](unsigned char const* p) { std::uint64_t v; std::memcpy(&v, p, 8); return v; };
+			auto const read32 = [](unsigned char const* p) { std::uint32_t v; std::memcpy(&v, p, 4); return v; };
+			auto const round = [&](std::uint64_t acc, std::uint64_t input) {
+				return rotl(acc + input * prime2, 31) * prime1;
+			};
+			auto const merge = [&](std::uint64_t acc, std::uint64_t lane) {
+				return (acc ^ round(0, lane)) * prime1 + prime4;
+			};
+
+			auto p = static_cast<unsigned char const*>(data);
+			auto const last = p + size;
+			std::uint64_t h;
+			if (size >= 32) {
+				std::uint64_t v1 = seed + prime1 + prime2;
+				std::uint64_t v2 = seed + prime2;
+				std::uint64_t v3 = seed;
+				std::uint64_t v4 = seed - prime1;
+				for (; last - p >= 32; p += 32) {
+					v1 = round(v1, read64(p));
+					v2 = round(v2, read64(p + 8));
+					v3 = round(v3, read64(p + 16));
+					v4 = round(v4, read64(p + 24));
+				}
+				h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+				h = merge(h, v1);
+				h = merge(h, v2);
+				h = merge(h, v3);
+				h = merge(h, v4);
+			}
+			else {
+				h = seed + prime5;
+			}
+			h += static_cast<std::uint64_t>(size);
+			for (; last - p >= 8; p += 8) {
+				h = rotl(h ^ round(0, read64(p)), 27) * prime1 + prime4;
+			}
+			if (last - p >= 4) {
+				h = rotl(h ^ (static_cast<std::uint64_t>(read32(p)) * prime1), 23) * prime2 + prime3;
+				p += 4;
+			}
+			for (; p != last; ++p) {
+				h = rotl(h ^ (*p * prime5), 11) * prime1;
+			}
+			h ^= h >> 33;
+			h *= prime2;
+			h ^= h >> 29;
+			h *= prime3;
+			h ^= h >> 32;
+			return h;
+		}
+
+		template<typename T>
+		auto dynarray_hash(utils::dynarray<T> const& array, std::true_type) -> size_t {
+			return static_cast<size_t>(hash_bytes(array.data(), array.size() * sizeof(T), 0));
+		}
+
+		template<typename T>
+		auto dynarray_hash(utils::dynarray<T> const& array, std::false_type) -> size_t {
+			auto result = static_cast<size_t>(array.size());
+			auto const element_hash = std::hash<T>{};
+			for (auto const& element : array) {
+				result ^= element_hash(element) + static_cast<size_t>(0x9E3779B97F4A7C15ull) + (result << 6) + (result >> 2);
+			}
+			return result;
+		}
+	}
+}
+
+template<typename T>
+auto utils::operator==(dynarray<T> const& lhs, dynarray<T> const& rhs) -> bool {
+	return lhs.size() == rhs.size() && detail::dynarray_equal(lhs, rhs, detail::is_bitwise_comparable<T>{});
+}
+
+template<typename T>
+auto utils::operator!=(dynarray<T> const& lhs, dynarray<T> const& rhs) -> bool {
+	return !(lhs == rhs);
+}
+
+template<typename T>
+auto utils::operator<(dynarray<T> const& lhs, dynarray<T> const& rhs) -> bool {
+	auto const common = std::min(lhs.size(), rhs.size());
+	auto const i = detail::dynarray_mismatch(lhs.data(), rhs.data(), common, detail::is_bitwise_comparable<T>{});
+	if (i != common) {
+		return lhs[i] < rhs[i];
+	}
+	return lhs.size() < rhs.size();
+}
+
+template<typename T>
+auto utils::operator<=(dynarray<T> const& lhs, dynarray<T> const& rhs) -> bool {
+	return !(rhs < lhs);
+}
+
+template<typename T>
+auto utils::operator>(dynarray<T> const& lhs, dynarray<T> const& rhs) -> bool {
+	return rhs < lhs;
+}
+
+template<typename T>
+auto utils::operator>=(dynarray<T> const& lhs, dynarray<T> const& rhs) -> bool {
+	return !(lhs < rhs);
+}
+
+#if defined(__cpp_lib_three_way_comparison)
+template<typename T>
+auto utils::operator<=>(dynarray<T> const& lhs, dynarray<T> const& rhs)
+	-> decltype(std::declval<T const&>() <=> std::declval<T const&>())
+{
+	auto const common = std::min(lhs.size(), rhs.size());
+	auto const i = detail::dynarray_mismatch(lhs.data(), rhs.data(), common, detail::is_bitwise_comparable<T>{});
+	if (i != common) {
+		return lhs[i] <=> rhs[i];
+	}
+	return lhs.size() <=> rhs.size();
+}
+#endif
+
+template<typename T>
+auto std::hash<utils::dynarray<T>>::operator()(utils::dynarray<T> const& array) const -> size_t {
+	return utils::detail::dynarray_hash(array, utils::detail::is_bitwise_comparable<T>{});
+}
+
 #endif // UTILS_DYNARRAY_HPP
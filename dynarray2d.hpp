@@ -0,0 +1,535 @@
+//===---------------------------------------------------------
+//                       DYNARRAY2D
+//===---------------------------------------------------------
+//
+// Two-dimensional companion of the dynarray container.
+// The extents are fixed at construction just like the
+// element count of a dynarray, while the mapping of
+// (row, column) coordinates to the underlying storage is
+// defined by an exchangeable layout policy.
+//
+// Provided layouts are plain row-major, blocked (tiled)
+// and Z-order (Morton). The latter two keep elements that
+// are close in two dimensions close in memory so that
+// column-wise passes do not touch a new cache line and
+// page for every single element. In exchange they compute a
+// more expensive index per element, so row-wise passes stay
+// fastest with row-major storage.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_DYNARRAY2D_HPP
+#define UTILS_DYNARRAY2D_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+// headers used by definition site
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	namespace layout {
+		/// Classic row-major layout: all elements of a row are stored
+		/// contiguously and rows follow each other without padding.
+		///
+		/// Cheap to index but every step along a column advances
+		/// by a full row in memory.
+		class row_major {
+		public:
+			using size_type = size_t;
+
+			row_major(size_type rows, size_type cols);
+
+			/// Returns the number of elements required to store the matrix.
+			auto storage_size() const -> size_type;
+
+			/// Returns the storage offset of the element at \row and \col.
+			auto index(size_type row, size_type col) const -> size_type;
+
+		private:
+			size_type m_rows;
+			size_type m_cols;
+		};
+
+		/// Blocked layout that stores the matrix as a row-major grid of
+		/// \TileRows x \TileCols tiles where each tile itself is stored row-major.
+		///
+		/// The extents are padded up to whole tiles. Tile extents must be
+		/// powers of two so that indexing reduces to shifts and masks.
+		/// A tile of 8x8 doubles or 16x16 floats spans 8 cache lines and
+		/// therefore fits comfortably into the L1 cache.
+		template<size_t TileRows, size_t TileCols = TileRows>
+		class tiled {
+			static_assert(TileRows > 0 && (TileRows & (TileRows - 1)) == 0,
+				"tile row extent must be a power of two");
+			static_assert(TileCols > 0 && (TileCols & (TileCols - 1)) == 0,
+				"tile column extent must be a power of two");
+		public:
+			using size_type = size_t;
+
+			static constexpr size_type tile_rows = TileRows;
+			static constexpr size_type tile_cols = TileCols;
+
+			tiled(size_type rows, size_type cols);
+
+			/// Returns the number of elements required to store the matrix
+			/// including the padding of incomplete border tiles.
+			auto storage_size() const -> size_type;
+
+			/// Returns the storage offset of the element at \row and \col.
+			auto index(size_type row, size_type col) const -> size_type;
+
+		private:
+			size_type m_tiles_per_row;
+			size_type m_tiles_per_col;
+		};
+
+		/// Z-order (Morton) layout that interleaves the bits of the row
+		/// and column coordinate. It is recursively blocked on every scale
+		/// and thus cache-friendly without knowledge of the cache sizes.
+		///
+		/// Both extents are padded to the next power of two. For non-square
+		/// matrices only the low bits up to the smaller extent are interleaved
+		/// while the remaining high bits of the larger extent select one of
+		/// several square Z-order blocks. This keeps the padding overhead
+		/// below a factor of four even for skinny matrices.
+		class morton {
+		public:
+			using size_type = size_t;
+
+			morton(size_type rows, size_type cols);
+
+			/// Returns the number of elements required to store the matrix
+			/// including the padding to power-of-two extents.
+			auto storage_size() const -> size_type;
+
+			/// Returns the storage offset of the element at \row and \col.
+			auto index(size_type row, size_type col) const -> size_type;
+
+		private:
+			unsigned m_row_bits;
+			unsigned m_col_bits;
+			unsigned m_interleaved_bits;
+		};
+	}
+
+	/// Matrix container with extents that are fixed at construction
+	/// and an element storage order defined by the \Layout policy.
+	///
+	/// All layouts provide the same element accessors so that code can
+	/// switch between them by changing a single template argument.
+	/// Elements are stored in a single dynarray that is accessible through
+	/// data() and storage_size() for bulk operations that do not care
+	/// about the element order, e.g. filling or elementwise arithmetic.
+	template<typename T, typename Layout = layout::row_major>
+	class dynarray2d {
+	public:
+
+	//============================================================
+	// Type aliases
+	//============================================================
+
+		using value_type      = T;
+		using layout_type     = Layout;
+		using size_type       = size_t;
+		using reference       = value_type &;
+		using const_reference = value_type const&;
+		using pointer         = value_type *;
+		using const_pointer   = value_type const*;
+
+	//============================================================
+	// Constructors
+	//============================================================
+
+		/// Constructs a matrix of \rows x \cols default-initialized elements.
+		dynarray2d(size_type rows, size_type cols);
+
+		/// Constructs a matrix of \rows x \cols elements equal to \value.
+		dynarray2d(size_type rows, size_type cols, T const& value);
+
+	//============================================================
+	// Access API
+	//============================================================
+
+		/// Access the element at \row and \col with bounds checking.
+		/// Throws out_of_range exception if either coordinate was illegal.
+		auto at(size_type row, size_type col) -> reference;
+
+		/// Read-only access the element at \row and \col with bounds checking.
+		/// Throws out_of_range exception if either coordinate was illegal.
+		auto at(size_type row, size_type col) const -> const_reference;
+
+		/// Access the element at \row and \col without bounds checking.
+		auto operator()(size_type row, size_type col) -> reference;
+
+		/// Read-only access the element at \row and \col without bounds checking.
+		auto operator()(size_type row, size_type col) const -> const_reference;
+
+		/// Returns a raw-pointer to the underlying storage in layout order.
+		auto data() -> pointer;
+
+		/// Returns a read-only raw-pointer to the underlying storage in layout order.
+		auto data() const -> const_pointer;
+
+		/// Returns the layout policy instance used for index computations.
+		auto layout() const -> layout_type const&;
+
+	//============================================================
+	// Capacity API
+	//============================================================
+
+		/// Returns the number of rows.
+		auto rows() const -> size_type;
+
+		/// Returns the number of columns.
+		auto cols() const -> size_type;
+
+		/// Returns the number of logical elements, i.e. rows() * cols().
+		auto size() const -> size_type;
+
+		/// Returns the number of stored elements including layout padding.
+		auto storage_size() const -> size_type;
+
+		/// Returns `true` if this matrix has no elements and `false` otherwise.
+		auto empty() const -> bool;
+
+	//============================================================
+	// Mutate API
+	//============================================================
+
+		/// Fills all elements (including padding) with the specified \value.
+		void fill(T const& value);
+
+	//============================================================
+	// Member Variables
+	//============================================================
+
+	private:
+		layout_type m_layout;
+		size_type   m_rows;
+		size_type   m_cols;
+		dynarray<T> m_storage;
+	};
+
+	/// Writes the transpose of \src into \dst which may use a different layout.
+	/// Throws an invalid_argument exception if the extents of \dst are not
+	/// the swapped extents of \src.
+	///
+	/// The traversal recursively halves the larger extent until a block
+	/// fits into the L1 cache which makes it cache-oblivious: both the
+	/// reads and the writes stay within a small working set regardless
+	/// of the layouts involved.
+	template<typename T, typename SrcLayout, typename DstLayout>
+	void transpose(dynarray2d<T, SrcLayout> const& src, dynarray2d<T, DstLayout> & dst);
+
+	/// Returns the transpose of \src stored in the \DstLayout.
+	template<typename DstLayout, typename T, typename SrcLayout>
+	auto transposed(dynarray2d<T, SrcLayout> const& src) -> dynarray2d<T, DstLayout>;
+
+	/// Returns the transpose of \src stored in the same layout.
+	template<typename T, typename Layout>
+	auto transposed(dynarray2d<T, Layout> const& src) -> dynarray2d<T, Layout>;
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace detail {
+		/// Returns the number of bits required to address \count positions.
+		inline auto ceil_log2(size_t count) -> unsigned {
+			unsigned bits = 0;
+			while ((size_t{1} << bits) < count) {
+				++bits;
+			}
+			return bits;
+		}
+
+		/// Spreads the lower 32 bits of \x so that a zero bit is
+		/// inserted between each pair of adjacent bits.
+		inline auto morton_spread(std::uint64_t x) -> std::uint64_t {
+			x &= 0x00000000ffffffffull;
+			x = (x | (x << 16)) & 0x0000ffff0000ffffull;
+			x = (x | (x <<  8)) & 0x00ff00ff00ff00ffull;
+			x = (x | (x <<  4)) & 0x0f0f0f0f0f0f0f0full;
+			x = (x | (x <<  2)) & 0x3333333333333333ull;
+			x = (x | (x <<  1)) & 0x5555555555555555ull;
+			return x;
+		}
+
+		/// Block extent below which the transpose recursion switches
+		/// to a plain double loop. 32x32 elements of 8 bytes occupy 8KiB
+		/// for the source and the destination block each.
+		constexpr size_t transpose_block_extent = 32;
+
+		template<typename T, typename SrcLayout, typename DstLayout>
+		void transpose_recursive(
+			dynarray2d<T, SrcLayout> const& src,
+			dynarray2d<T, DstLayout> & dst,
+			size_t row_begin, size_t row_end,
+			size_t col_begin, size_t col_end
+		) {
+			auto const row_extent = row_end - row_begin;
+			auto const col_extent = col_end - col_begin;
+			if (row_extent <= transpose_block_extent && col_extent <= transpose_block_extent) {
+				for (auto row = row_begin; row != row_end; ++row) {
+					for (auto col = col_begin; col != col_end; ++col) {
+						dst(col, row) = src(row, col);
+					}
+				}
+				return;
+			}
+			if (row_extent >= col_extent) {
+				auto const row_mid = row_begin + row_extent / 2;
+				transpose_recursive(src, dst, row_begin, row_mid, col_begin, col_end);
+				transpose_recursive(src, dst, row_mid, row_end, col_begin, col_end);
+			}
+			else {
+				auto const col_mid = col_begin + col_extent / 2;
+				transpose_recursive(src, dst, row_begin, row_end, col_begin, col_mid);
+				transpose_recursive(src, dst, row_begin, row_end, col_mid, col_end);
+			}
+		}
+	}
+}
+
+//============================================================
+// Layout: row_major
+//============================================================
+
+inline utils::layout::row_major::row_major(size_type rows, size_type cols):
+	m_rows{rows},
+	m_cols{cols}
+{}
+
+inline auto utils::layout::row_major::storage_size() const -> size_type {
+	return m_rows * m_cols;
+}
+
+inline auto utils::layout::row_major::index(size_type row, size_type col) const -> size_type {
+	return row * m_cols + col;
+}
+
+//============================================================
+// Layout: tiled
+//============================================================
+
+template<size_t TileRows, size_t TileCols>
+constexpr typename utils::layout::tiled<TileRows, TileCols>::size_type
+	utils::layout::tiled<TileRows, TileCols>::tile_rows;
+
+template<size_t TileRows, size_t TileCols>
+constexpr typename utils::layout::tiled<TileRows, TileCols>::size_type
+	utils::layout::tiled<TileRows, TileCols>::tile_cols;
+
+template<size_t TileRows, size_t TileCols>
+utils::layout::tiled<TileRows, TileCols>::tiled(size_type rows, size_type cols):
+	m_tiles_per_row{(cols + TileCols - 1) / TileCols},
+	m_tiles_per_col{(rows + TileRows - 1) / TileRows}
+{}
+
+template<size_t TileRows, size_t TileCols>
+auto utils::layout::tiled<TileRows, TileCols>::storage_size() const -> size_type {
+	return m_tiles_per_row * m_tiles_per_col * TileRows * TileCols;
+}
+
+template<size_t TileRows, size_t TileCols>
+auto utils::layout::tiled<TileRows, TileCols>::index(size_type row, size_type col) const -> size_type {
+	auto const tile  = (row / TileRows) * m_tiles_per_row + col / TileCols;
+	auto const inner = (row % TileRows) * TileCols + col % TileCols;
+	return tile * (TileRows * TileCols) + inner;
+}
+
+//============================================================
+// Layout: morton
+//============================================================
+
+inline utils::layout::morton::morton(size_type rows, size_type cols):
+	m_row_bits{detail::ceil_log2(rows)},
+	m_col_bits{detail::ceil_log2(cols)},
+	m_interleaved_bits{std::min(m_row_bits, m_col_bits)}
+{
+	if (m_interleaved_bits > 32) {
+		using namespace std::string_literals;
+		throw std::invalid_argument{
+			"cannot use morton layout for matrix of extents "s +
+			std::to_string(rows) + "x" + std::to_string(cols)
+		};
+	}
+}
+
+inline auto utils::layout::morton::storage_size() const -> size_type {
+	return size_type{1} << (m_row_bits + m_col_bits);
+}
+
+inline auto utils::layout::morton::index(size_type row, size_type col) const -> size_type {
+	auto const low_mask = (size_type{1} << m_interleaved_bits) - 1;
+	auto const z = (detail::morton_spread(row & low_mask) << 1)
+	             |  detail::morton_spread(col & low_mask);
+	auto const high = (row >> m_interleaved_bits) | (col >> m_interleaved_bits);
+	return static_cast<size_type>(z) | (high << (2 * m_interleaved_bits));
+}
+
+//============================================================
+// Constructors
+//============================================================
+
+template<typename T, typename Layout>
+utils::dynarray2d<T, Layout>::dynarray2d(size_type rows, size_type cols):
+	m_layout{rows, cols},
+	m_rows{rows},
+	m_cols{cols},
+	m_storage(m_layout.storage_size())
+{}
+
+template<typename T, typename Layout>
+utils::dynarray2d<T, Layout>::dynarray2d(size_type rows, size_type cols, T const& value):
+	m_layout{rows, cols},
+	m_rows{rows},
+	m_cols{cols},
+	m_storage(m_layout.storage_size(), value)
+{}
+
+//============================================================
+// Access API
+//============================================================
+
+template<typename T, typename Layout>
+auto utils::dynarray2d<T, Layout>::at(size_type row, size_type col) -> reference {
+	if (row >= rows() || col >= cols()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access element at position ("s +
+			std::to_string(row) + ", " + std::to_string(col) +
+			") from a dynarray2d with extents " +
+			std::to_string(rows()) + "x" + std::to_string(cols())
+		};
+	}
+	return (*this)(row, col);
+}
+
+template<typename T, typename Layout>
+auto utils::dynarray2d<T, Layout>::at(size_type row, size_type col) const -> const_reference {
+	if (row >= rows() || col >= cols()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access element at position ("s +
+			std::to_string(row) + ", " + std::to_string(col) +
+			") from a dynarray2d with extents " +
+			std::to_string(rows()) + "x" + std::to_string(cols())
+		};
+	}
+	return (*this)(row, col);
+}
+
+template<typename T, typename Layout>
+auto utils::dynarray2d<T, Layout>::operator()(size_type row, size_type col) -> reference {
+	return m_storage[m_layout.index(row, col)];
+}
+
+template<typename T, typename Layout>
+auto utils::dynarray2d<T, Layout>::operator()(size_type row, size_type col) const -> const_reference {
+	return m_storage[m_layout.index(row, col)];
+}
+
+template<typename T, typename Layout>
+auto utils::dynarray2d<T, Layout>::data() -> pointer {
+	return m_storage.data();
+}
+
+template<typename T, typename Layout>
+auto utils::dynarray2d<T, Layout>::data() const -> const_pointer {
+	return m_storage.data();
+}
+
+template<typename T, typename Layout>
+auto utils::dynarray2d<T, Layout>::layout() const -> layout_type const& {
+	return m_layout;
+}
+
+//============================================================
+// Capacity API
+//============================================================
+
+template<typename T, typename Layout>
+auto utils::dynarray2d<T, Layout>::rows() const -> size_type {
+	return m_rows;
+}
+
+template<typename T, typename Layout>
+auto utils::dynarray2d<T, Layout>::cols() const -> size_type {
+	return m_cols;
+}
+
+template<typename T, typename Layout>
+auto utils::dynarray2d<T, Layout>::size() const -> size_type {
+	return m_rows * m_cols;
+}
+
+template<typename T, typename Layout>
+auto utils::dynarray2d<T, Layout>::storage_size() const -> size_type {
+	return m_storage.size();
+}
+
+template<typename T, typename Layout>
+auto utils::dynarray2d<T, Layout>::empty() const -> bool {
+	return size() == 0;
+}
+
+//============================================================
+// Mutate API
+//============================================================
+
+template<typename T, typename Layout>
+void utils::dynarray2d<T, Layout>::fill(T const& value) {
+	m_storage.fill(value);
+}
+
+//============================================================
+// Transpose
+//============================================================
+
+template<typename T, typename SrcLayout, typename DstLayout>
+void utils::transpose(dynarray2d<T, SrcLayout> const& src, dynarray2d<T, DstLayout> & dst) {
+	if (src.rows() != dst.cols() || src.cols() != dst.rows()) {
+		using namespace std::string_literals;
+		throw std::invalid_argument{
+			"cannot transpose dynarray2d with extents "s +
+			std::to_string(src.rows()) + "x" + std::to_string(src.cols()) +
+			" into dynarray2d with extents " +
+			std::to_string(dst.rows()) + "x" + std::to_string(dst.cols())
+		};
+	}
+	detail::transpose_recursive(src, dst, 0, src.rows(), 0, src.cols());
+}
+
+template<typename DstLayout, typename T, typename SrcLayout>
+auto utils::transposed(dynarray2d<T, SrcLayout> const& src) -> dynarray2d<T, DstLayout> {
+	auto result = dynarray2d<T, DstLayout>(src.cols(), src.rows());
+	transpose(src, result);
+	return result;
+}
+
+template<typename T, typename Layout>
+auto utils::transposed(dynarray2d<T, Layout> const& src) -> dynarray2d<T, Layout> {
+	return transposed<Layout>(src);
+}
+
+#endif // UTILS_DYNARRAY2D_HPP
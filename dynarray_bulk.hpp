@@ -0,0 +1,632 @@
+//===---------------------------------------------------------
+//                       DYNARRAY_BULK
+//===---------------------------------------------------------
+//
+// Runtime dispatched bulk operations over dynarrays of
+// trivially copyable elements: fill, copy, equal, find and
+// count.
+//
+// Every operation is implemented once per kernel path of
+// cpu_dispatch.hpp. The implementations are gathered in
+// tables of function pointers, one table per path, and the
+// table of the active path is looked up on every call. The
+// kernels operate on raw bytes or on elements of 1, 2, 4 or
+// 8 bytes, so the tables are shared by all element types.
+// Element types the kernels do not apply to fall back to
+// the standard algorithms.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_DYNARRAY_BULK_HPP
+#define UTILS_DYNARRAY_BULK_HPP
+
+// headers used by declaration site
+#include "cpu_dispatch.hpp"
+#include "dynarray.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+// headers used by definition site
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	namespace bulk {
+		/// Function pointers to the kernels of one path of cpu_dispatch.hpp.
+		struct kernel_table {
+			/// The path the kernels are implemented for.
+			cpu::isa path;
+
+			/// Writes \bytes bytes to \dst repeating the 64 byte \pattern.
+			/// \bytes must be a multiple of the period of the pattern which
+			/// must divide 16.
+			void (*fill)(void * dst, size_t bytes, unsigned char const* pattern);
+
+			/// Copies \bytes bytes from \src to the non-overlapping \dst.
+			void (*copy)(void * dst, void const* src, size_t bytes);
+
+			/// Returns `true` if the \bytes bytes at \lhs and \rhs are equal.
+			auto (*equal)(void const* lhs, void const* rhs, size_t bytes) -> bool;
+
+			/// Returns the position of the first of \count elements of 1, 2, 4
+			/// and 8 bytes that equals the element at \value, or \count if there
+			/// is none. Indexed by the binary logarithm of the element size.
+			size_t (*find[4])(void const* data, size_t count, void const* value);
+
+			/// Returns the number of the \count elements of 1, 2, 4 and 8 bytes
+			/// that equal the element at \value. Indexed like find.
+			size_t (*count[4])(void const* data, size_t count, void const* value);
+		};
+
+		/// Returns the kernels of the active path, see cpu::active_isa().
+		/// The chosen path can be logged via `cpu::name(kernels().path)`.
+		auto kernels() -> kernel_table const&;
+
+		/// Returns the kernels of \path. Paths that are not supported by the
+		/// executing CPU must not be used.
+		auto kernels(cpu::isa path) -> kernel_table const&;
+
+		/// Assigns \value to every element of \array.
+		/// Uses the vector kernels if T is trivially copyable and its
+		/// size is 1, 2, 4, 8 or 16 bytes.
+		template<typename T>
+		void fill(dynarray<T> & array, T const& value);
+
+		/// Copies all elements of \src into \dst.
+		/// Throws an invalid_argument exception when the sizes are unequal.
+		/// Uses the vector kernels if T is trivially copyable.
+		template<typename T>
+		void copy(dynarray<T> const& src, dynarray<T> & dst);
+
+		/// Returns `true` if \lhs and \rhs have the same size and equal elements.
+		/// Compares bytes with the vector kernels for integral, enumeration and
+		/// pointer types whose equality matches their object representation.
+		template<typename T>
+		auto equal(dynarray<T> const& lhs, dynarray<T> const& rhs) -> bool;
+
+		/// Returns the position of the first element of \array equal to \value
+		/// or `array.size()` if there is none.
+		/// Uses the vector kernels for integral, enumeration and pointer types.
+		template<typename T>
+		auto find(dynarray<T> const& array, T const& value) -> size_t;
+
+		/// Returns the number of elements of \array equal to \value.
+		/// Uses the vector kernels for integral, enumeration and pointer types.
+		template<typename T>
+		auto count(dynarray<T> const& array, T const& value) -> size_t;
+	}
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace bulk {
+		namespace detail {
+			using utils::detail::is_bitwise_comparable;
+
+			/// Loads the element of \Width bytes at \data as an unsigned integer.
+			template<size_t Width>
+			auto load_element(void const* data) -> std::uint64_t {
+				using word = std::conditional_t<Width == 1, std::uint8_t,
+				             std::conditional_t<Width == 2, std::uint16_t,
+				             std::conditional_t<Width == 4, std::uint32_t, std::uint64_t>>>;
+				word result;
+				std::memcpy(&result, data, sizeof(word));
+				return result;
+			}
+
+		//============================================================
+		// Scalar
+		//============================================================
+
+			inline void fill_scalar(void * dst, size_t bytes, unsigned char const* pattern) {
+				auto out = static_cast<unsigned char *>(dst);
+				for (; bytes >= 64; bytes -= 64, out += 64) {
+					std::memcpy(out, pattern, 64);
+				}
+				std::memcpy(out, pattern, bytes);
+			}
+
+			inline void copy_scalar(void * dst, void const* src, size_t bytes) {
+				std::memcpy(dst, src, bytes);
+			}
+
+			inline auto equal_scalar(void const* lhs, void const* rhs, size_t bytes) -> bool {
+				return std::memcmp(lhs, rhs, bytes) == 0;
+			}
+
+			template<size_t Width>
+			auto find_scalar(void const* data, size_t count, void const* value) -> size_t {
+				auto const bytes = static_cast<unsigned char const*>(data);
+				auto const needle = load_element<Width>(value);
+				for (size_t i = 0; i != count; ++i) {
+					if (load_element<Width>(bytes + i * Width) == needle) {
+						return i;
+					}
+				}
+				return count;
+			}
+
+			template<size_t Width>
+			auto count_scalar(void const* data, size_t count, void const* value) -> size_t {
+				auto const bytes = static_cast<unsigned char const*>(data);
+				auto const needle = load_element<Width>(value);
+				size_t result = 0;
+				for (size_t i = 0; i != count; ++i) {
+					result += load_element<Width>(bytes + i * Width) == needle;
+				}
+				return result;
+			}
+
+#if defined(UTILS_SIMD_X86)
+		//============================================================
+		// SSE2
+		//============================================================
+
+			UTILS_SIMD_TARGET("sse2")
+			inline void fill_sse2(void * dst, size_t bytes, unsigned char const* pattern) {
+				auto out = static_cast<unsigned char *>(dst);
+				auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pattern));
+				for (; bytes >= 64; bytes -= 64, out += 64) {
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out +  0), v);
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16), v);
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 32), v);
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 48), v);
+				}
+				for (; bytes >= 16; bytes -= 16, out += 16) {
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out), v);
+				}
+				std::memcpy(out, pattern, bytes);
+			}
+
+			UTILS_SIMD_TARGET("sse2")
+			inline void copy_sse2(void * dst, void const* src, size_t bytes) {
+				auto out = static_cast<unsigned char *>(dst);
+				auto in = static_cast<unsigned char const*>(src);
+				for (; bytes >= 64; bytes -= 64, out += 64, in += 64) {
+					auto const v0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in +  0));
+					auto const v1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + 16));
+					auto const v2 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + 32));
+					auto const v3 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + 48));
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out +  0), v0);
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16), v1);
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 32), v2);
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 48), v3);
+				}
+				std::memcpy(out, in, bytes);
+			}
+
+			UTILS_SIMD_TARGET("sse2")
+			inline auto equal_sse2(void const* lhs, void const* rhs, size_t bytes) -> bool {
+				auto l = static_cast<unsigned char const*>(lhs);
+				auto r = static_cast<unsigned char const*>(rhs);
+				for (; bytes >= 64; bytes -= 64, l += 64, r += 64) {
+					auto const e0 = _mm_cmpeq_epi8(
+						_mm_loadu_si128(reinterpret_cast<__m128i const*>(l +  0)),
+						_mm_loadu_si128(reinterpret_cast<__m128i const*>(r +  0)));
+					auto const e1 = _mm_cmpeq_epi8(
+						_mm_loadu_si128(reinterpret_cast<__m128i const*>(l + 16)),
+						_mm_loadu_si128(reinterpret_cast<__m128i const*>(r + 16)));
+					auto const e2 = _mm_cmpeq_epi8(
+						_mm_loadu_si128(reinterpret_cast<__m128i const*>(l + 32)),
+						_mm_loadu_si128(reinterpret_cast<__m128i const*>(r + 32)));
+					auto const e3 = _mm_cmpeq_epi8(
+						_mm_loadu_si128(reinterpret_cast<__m128i const*>(l + 48)),
+						_mm_loadu_si128(reinterpret_cast<__m128i const*>(r + 48)));
+					auto const all = _mm_and_si128(_mm_and_si128(e0, e1), _mm_and_si128(e2, e3));
+					if (_mm_movemask_epi8(all) != 0xFFFF) {
+						return false;
+					}
+				}
+				return std::memcmp(l, r, bytes) == 0;
+			}
+
+			/// Compares the elements of \Width bytes in \lhs and \rhs for equality.
+			template<size_t Width>
+			UTILS_SIMD_TARGET("sse2")
+			inline auto compare_sse2(__m128i lhs, __m128i rhs) -> __m128i {
+				switch (Width) {
+					case 1: return _mm_cmpeq_epi8(lhs, rhs);
+					case 2: return _mm_cmpeq_epi16(lhs, rhs);
+					case 4: return _mm_cmpeq_epi32(lhs, rhs);
+				}
+				// SSE2 lacks a 64-bit comparison: both 32-bit halves must match.
+				auto const halves = _mm_cmpeq_epi32(lhs, rhs);
+				return _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+			}
+
+			template<size_t Width>
+			UTILS_SIMD_TARGET("sse2")
+			inline auto broadcast_sse2(std::uint64_t value) -> __m128i {
+				switch (Width) {
+					case 1: return _mm_set1_epi8(static_cast<char>(value));
+					case 2: return _mm_set1_epi16(static_cast<short>(value));
+					case 4: return _mm_set1_epi32(static_cast<int>(value));
+				}
+				return _mm_set1_epi64x(static_cast<long long>(value));
+			}
+
+			template<size_t Width>
+			UTILS_SIMD_TARGET("sse2")
+			inline auto find_sse2(void const* data, size_t count, void const* value) -> size_t {
+				auto const bytes = static_cast<unsigned char const*>(data);
+				auto const needle = broadcast_sse2<Width>(load_element<Width>(value));
+				constexpr auto per_vector = 16 / Width;
+				size_t i = 0;
+				for (; i + per_vector <= count; i += per_vector) {
+					auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(bytes + i * Width));
+					auto const mask = _mm_movemask_epi8(compare_sse2<Width>(v, needle));
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask))) / Width;
+					}
+				}
+				return i + find_scalar<Width>(bytes + i * Width, count - i, value);
+			}
+
+			template<size_t Width>
+			UTILS_SIMD_TARGET("sse2")
+			inline auto count_sse2(void const* data, size_t count, void const* value) -> size_t {
+				auto const bytes = static_cast<unsigned char const*>(data);
+				auto const needle = broadcast_sse2<Width>(load_element<Width>(value));
+				constexpr auto per_vector = 16 / Width;
+				// Every equal element sets \Width bits of the byte mask.
+				size_t bits = 0;
+				size_t i = 0;
+				for (; i + per_vector <= count; i += per_vector) {
+					auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(bytes + i * Width));
+					bits += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(compare_sse2<Width>(v, needle)))));
+				}
+				return bits / Width + count_scalar<Width>(bytes + i * Width, count - i, value);
+			}
+
+		//============================================================
+		// AVX2
+		//============================================================
+
+			UTILS_SIMD_TARGET("avx2")
+			inline void fill_avx2(void * dst, size_t bytes, unsigned char const* pattern) {
+				auto out = static_cast<unsigned char *>(dst);
+				auto const v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(pattern));
+				for (; bytes >= 128; bytes -= 128, out += 128) {
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out +  0), v);
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 32), v);
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 64), v);
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 96), v);
+				}
+				for (; bytes >= 32; bytes -= 32, out += 32) {
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out), v);
+				}
+				std::memcpy(out, pattern, bytes);
+			}
+
+			UTILS_SIMD_TARGET("avx2")
+			inline void copy_avx2(void * dst, void const* src, size_t bytes) {
+				auto out = static_cast<unsigned char *>(dst);
+				auto in = static_cast<unsigned char const*>(src);
+				for (; bytes >= 128; bytes -= 128, out += 128, in += 128) {
+					auto const v0 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(in +  0));
+					auto const v1 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + 32));
+					auto const v2 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + 64));
+					auto const v3 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + 96));
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out +  0), v0);
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 32), v1);
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 64), v2);
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 96), v3);
+				}
+				std::memcpy(out, in, bytes);
+			}
+
+			UTILS_SIMD_TARGET("avx2")
+			inline auto equal_avx2(void const* lhs, void const* rhs, size_t bytes) -> bool {
+				auto l = static_cast<unsigned char const*>(lhs);
+				auto r = static_cast<unsigned char const*>(rhs);
+				for (; bytes >= 128; bytes -= 128, l += 128, r += 128) {
+					auto const d0 = _mm256_xor_si256(
+						_mm256_loadu_si256(reinterpret_cast<__m256i const*>(l +  0)),
+						_mm256_loadu_si256(reinterpret_cast<__m256i const*>(r +  0)));
+					auto const d1 = _mm256_xor_si256(
+						_mm256_loadu_si256(reinterpret_cast<__m256i const*>(l + 32)),
+						_mm256_loadu_si256(reinterpret_cast<__m256i const*>(r + 32)));
+					auto const d2 = _mm256_xor_si256(
+						_mm256_loadu_si256(reinterpret_cast<__m256i const*>(l + 64)),
+						_mm256_loadu_si256(reinterpret_cast<__m256i const*>(r + 64)));
+					auto const d3 = _mm256_xor_si256(
+						_mm256_loadu_si256(reinterpret_cast<__m256i const*>(l + 96)),
+						_mm256_loadu_si256(reinterpret_cast<__m256i const*>(r + 96)));
+					auto const any = _mm256_or_si256(_mm256_or_si256(d0, d1), _mm256_or_si256(d2, d3));
+					if (!_mm256_testz_si256(any, any)) {
+						return false;
+					}
+				}
+				return std::memcmp(l, r, bytes) == 0;
+			}
+
+			template<size_t Width>
+			UTILS_SIMD_TARGET("avx2")
+			inline auto compare_avx2(__m256i lhs, __m256i rhs) -> __m256i {
+				switch (Width) {
+					case 1: return _mm256_cmpeq_epi8(lhs, rhs);
+					case 2: return _mm256_cmpeq_epi16(lhs, rhs);
+					case 4: return _mm256_cmpeq_epi32(lhs, rhs);
+				}
+				return _mm256_cmpeq_epi64(lhs, rhs);
+			}
+
+			template<size_t Width>
+			UTILS_SIMD_TARGET("avx2")
+			inline auto broadcast_avx2(std::uint64_t value) -> __m256i {
+				switch (Width) {
+					case 1: return _mm256_set1_epi8(static_cast<char>(value));
+					case 2: return _mm256_set1_epi16(static_cast<short>(value));
+					case 4: return _mm256_set1_epi32(static_cast<int>(value));
+				}
+				return _mm256_set1_epi64x(static_cast<long long>(value));
+			}
+
+			template<size_t Width>
+			UTILS_SIMD_TARGET("avx2")
+			inline auto find_avx2(void const* data, size_t count, void const* value) -> size_t {
+				auto const bytes = static_cast<unsigned char const*>(data);
+				auto const needle = broadcast_avx2<Width>(load_element<Width>(value));
+				constexpr auto per_vector = 32 / Width;
+				size_t i = 0;
+				for (; i + per_vector <= count; i += per_vector) {
+					auto const v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(bytes + i * Width));
+					auto const mask = _mm256_movemask_epi8(compare_avx2<Width>(v, needle));
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask))) / Width;
+					}
+				}
+				return i + find_scalar<Width>(bytes + i * Width, count - i, value);
+			}
+
+			template<size_t Width>
+			UTILS_SIMD_TARGET("avx2,popcnt")
+			inline auto count_avx2(void const* data, size_t count, void const* value) -> size_t {
+				auto const bytes = static_cast<unsigned char const*>(data);
+				auto const needle = broadcast_avx2<Width>(load_element<Width>(value));
+				constexpr auto per_vector = 32 / Width;
+				// Every equal element sets \Width bits of the byte mask.
+				size_t bits = 0;
+				size_t i = 0;
+				for (; i + per_vector <= count; i += per_vector) {
+					auto const v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(bytes + i * Width));
+					bits += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(compare_avx2<Width>(v, needle)))));
+				}
+				return bits / Width + count_scalar<Width>(bytes + i * Width, count - i, value);
+			}
+
+		//============================================================
+		// AVX-512
+		//============================================================
+
+			UTILS_SIMD_TARGET("avx512f,avx512bw")
+			inline void fill_avx512(void * dst, size_t bytes, unsigned char const* pattern) {
+				auto out = static_cast<unsigned char *>(dst);
+				auto const v = _mm512_loadu_si512(pattern);
+				for (; bytes >= 256; bytes -= 256, out += 256) {
+					_mm512_storeu_si512(out +   0, v);
+					_mm512_storeu_si512(out +  64, v);
+					_mm512_storeu_si512(out + 128, v);
+					_mm512_storeu_si512(out + 192, v);
+				}
+				for (; bytes >= 64; bytes -= 64, out += 64) {
+					_mm512_storeu_si512(out, v);
+				}
+				std::memcpy(out, pattern, bytes);
+			}
+
+			UTILS_SIMD_TARGET("avx512f,avx512bw")
+			inline void copy_avx512(void * dst, void const* src, size_t bytes) {
+				auto out = static_cast<unsigned char *>(dst);
+				auto in = static_cast<unsigned char const*>(src);
+				for (; bytes >= 256; bytes -= 256, out += 256, in += 256) {
+					auto const v0 = _mm512_loadu_si512(in +   0);
+					auto const v1 = _mm512_loadu_si512(in +  64);
+					auto const v2 = _mm512_loadu_si512(in + 128);
+					auto const v3 = _mm512_loadu_si512(in + 192);
+					_mm512_storeu_si512(out +   0, v0);
+					_mm512_storeu_si512(out +  64, v1);
+					_mm512_storeu_si512(out + 128, v2);
+					_mm512_storeu_si512(out + 192, v3);
+				}
+				std::memcpy(out, in, bytes);
+			}
+
+			UTILS_SIMD_TARGET("avx512f,avx512bw")
+			inline auto equal_avx512(void const* lhs, void const* rhs, size_t bytes) -> bool {
+				auto l = static_cast<unsigned char const*>(lhs);
+				auto r = static_cast<unsigned char const*>(rhs);
+				for (; bytes >= 256; bytes -= 256, l += 256, r += 256) {
+					auto const d0 = _mm512_xor_si512(_mm512_loadu_si512(l +   0), _mm512_loadu_si512(r +   0));
+					auto const d1 = _mm512_xor_si512(_mm512_loadu_si512(l +  64), _mm512_loadu_si512(r +  64));
+					auto const d2 = _mm512_xor_si512(_mm512_loadu_si512(l + 128), _mm512_loadu_si512(r + 128));
+					auto const d3 = _mm512_xor_si512(_mm512_loadu_si512(l + 192), _mm512_loadu_si512(r + 192));
+					auto const any = _mm512_or_si512(_mm512_or_si512(d0, d1), _mm512_or_si512(d2, d3));
+					if (_mm512_test_epi64_mask(any, any) != 0) {
+						return false;
+					}
+				}
+				return std::memcmp(l, r, bytes) == 0;
+			}
+
+			/// Returns a bit mask of the elements of \Width bytes in \lhs and \rhs that are equal.
+			template<size_t Width>
+			UTILS_SIMD_TARGET("avx512f,avx512bw")
+			inline auto compare_avx512(__m512i lhs, __m512i rhs) -> std::uint64_t {
+				switch (Width) {
+					case 1: return _mm512_cmpeq_epi8_mask(lhs, rhs);
+					case 2: return _mm512_cmpeq_epi16_mask(lhs, rhs);
+					case 4: return _mm512_cmpeq_epi32_mask(lhs, rhs);
+				}
+				return _mm512_cmpeq_epi64_mask(lhs, rhs);
+			}
+
+			template<size_t Width>
+			UTILS_SIMD_TARGET("avx512f,avx512bw")
+			inline auto broadcast_avx512(std::uint64_t value) -> __m512i {
+				switch (Width) {
+					case 1: return _mm512_set1_epi8(static_cast<char>(value));
+					case 2: return _mm512_set1_epi16(static_cast<short>(value));
+					case 4: return _mm512_set1_epi32(static_cast<int>(value));
+				}
+				return _mm512_set1_epi64(static_cast<long long>(value));
+			}
+
+			template<size_t Width>
+			UTILS_SIMD_TARGET("avx512f,avx512bw")
+			inline auto find_avx512(void const* data, size_t count, void const* value) -> size_t {
+				auto const bytes = static_cast<unsigned char const*>(data);
+				auto const needle = broadcast_avx512<Width>(load_element<Width>(value));
+				constexpr auto per_vector = 64 / Width;
+				size_t i = 0;
+				for (; i + per_vector <= count; i += per_vector) {
+					auto const mask = compare_avx512<Width>(_mm512_loadu_si512(bytes + i * Width), needle);
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctzll(mask));
+					}
+				}
+				return i + find_scalar<Width>(bytes + i * Width, count - i, value);
+			}
+
+			template<size_t Width>
+			UTILS_SIMD_TARGET("avx512f,avx512bw,popcnt")
+			inline auto count_avx512(void const* data, size_t count, void const* value) -> size_t {
+				auto const bytes = static_cast<unsigned char const*>(data);
+				auto const needle = broadcast_avx512<Width>(load_element<Width>(value));
+				constexpr auto per_vector = 64 / Width;
+				size_t result = 0;
+				size_t i = 0;
+				for (; i + per_vector <= count; i += per_vector) {
+					auto const mask = compare_avx512<Width>(_mm512_loadu_si512(bytes + i * Width), needle);
+					result += static_cast<size_t>(__builtin_popcountll(mask));
+				}
+				return result + count_scalar<Width>(bytes + i * Width, count - i, value);
+			}
+#endif
+
+			/// Replicates the \width bytes at \value into all 64 bytes of \pattern.
+			inline void make_pattern(void const* value, size_t width, unsigned char (&pattern)[64]) {
+				for (size_t offset = 0; offset != 64; offset += width) {
+					std::memcpy(pattern + offset, value, width);
+				}
+			}
+		}
+	}
+}
+
+//============================================================
+// Kernel tables
+//============================================================
+
+inline auto utils::bulk::kernels(cpu::isa path) -> kernel_table const& {
+	static kernel_table const tables[] = {
+		{cpu::isa::scalar, detail::fill_scalar, detail::copy_scalar, detail::equal_scalar, {
+			detail::find_scalar<1>, detail::find_scalar<2>, detail::find_scalar<4>, detail::find_scalar<8>}, {
+			detail::count_scalar<1>, detail::count_scalar<2>, detail::count_scalar<4>, detail::count_scalar<8>}},
+#if defined(UTILS_SIMD_X86)
+		{cpu::isa::sse2, detail::fill_sse2, detail::copy_sse2, detail::equal_sse2, {
+			detail::find_sse2<1>, detail::find_sse2<2>, detail::find_sse2<4>, detail::find_sse2<8>}, {
+			detail::count_sse2<1>, detail::count_sse2<2>, detail::count_sse2<4>, detail::count_sse2<8>}},
+		{cpu::isa::avx2, detail::fill_avx2, detail::copy_avx2, detail::equal_avx2, {
+			detail::find_avx2<1>, detail::find_avx2<2>, detail::find_avx2<4>, detail::find_avx2<8>}, {
+			detail::count_avx2<1>, detail::count_avx2<2>, detail::count_avx2<4>, detail::count_avx2<8>}},
+		{cpu::isa::avx512, detail::fill_avx512, detail::copy_avx512, detail::equal_avx512, {
+			detail::find_avx512<1>, detail::find_avx512<2>, detail::find_avx512<4>, detail::find_avx512<8>}, {
+			detail::count_avx512<1>, detail::count_avx512<2>, detail::count_avx512<4>, detail::count_avx512<8>}},
+#endif
+	};
+	auto const index = static_cast<size_t>(path);
+	return tables[index < sizeof(tables) / sizeof(tables[0]) ? index : 0];
+}
+
+inline auto utils::bulk::kernels() -> kernel_table const& {
+	return kernels(cpu::active_isa());
+}
+
+//============================================================
+// Bulk operations
+//============================================================
+
+template<typename T>
+void utils::bulk::fill(dynarray<T> & array, T const& value) {
+	if (std::is_trivially_copyable<T>::value && 16 % sizeof(T) == 0) {
+		unsigned char pattern[64];
+		detail::make_pattern(&value, sizeof(T), pattern);
+		kernels().fill(array.data(), array.size() * sizeof(T), pattern);
+	}
+	else {
+		std::fill(array.begin(), array.end(), value);
+	}
+}
+
+template<typename T>
+void utils::bulk::copy(dynarray<T> const& src, dynarray<T> & dst) {
+	if (src.size() != dst.size()) {
+		using namespace std::string_literals;
+		throw std::invalid_argument{
+			"cannot copy dynarray of size "s +
+			std::to_string(src.size()) +
+			" into dynarray of size " +
+			std::to_string(dst.size())
+		};
+	}
+	if (std::is_trivially_copyable<T>::value) {
+		if (src.data() != dst.data()) {
+			kernels().copy(dst.data(), src.data(), src.size() * sizeof(T));
+		}
+	}
+	else {
+		std::copy(src.begin(), src.end(), dst.begin());
+	}
+}
+
+template<typename T>
+auto utils::bulk::equal(dynarray<T> const& lhs, dynarray<T> const& rhs) -> bool {
+	if (lhs.size() != rhs.size()) {
+		return false;
+	}
+	if (detail::is_bitwise_comparable<T>::value) {
+		return kernels().equal(lhs.data(), rhs.data(), lhs.size() * sizeof(T));
+	}
+	return std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template<typename T>
+auto utils::bulk::find(dynarray<T> const& array, T const& value) -> size_t {
+	constexpr auto width_index =
+		sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1 : sizeof(T) == 4 ? 2 : sizeof(T) == 8 ? 3 : 4;
+	if (detail::is_bitwise_comparable<T>::value && width_index < 4) {
+		return kernels().find[width_index % 4](array.data(), array.size(), &value);
+	}
+	return static_cast<size_t>(std::find(array.begin(), array.end(), value) - array.begin());
+}
+
+template<typename T>
+auto utils::bulk::count(dynarray<T> const& array, T const& value) -> size_t {
+	constexpr auto width_index =
+		sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1 : sizeof(T) == 4 ? 2 : sizeof(T) == 8 ? 3 : 4;
+	if (detail::is_bitwise_comparable<T>::value && width_index < 4) {
+		return kernels().count[width_index % 4](array.data(), array.size(), &value);
+	}
+	return static_cast<size_t>(std::count(array.begin(), array.end(), value));
+}
+
+#endif // UTILS_DYNARRAY_BULK_HPP
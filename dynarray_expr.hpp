@@ -0,0 +1,351 @@
+//===---------------------------------------------------------
+//                       DYNARRAY_EXPR
+//===---------------------------------------------------------
+//
+// Opt-in expression templates for elementwise arithmetic on
+// dynarrays of arithmetic element types.
+//
+// After `using namespace utils::expr;` the operators +, -,
+// * and / on dynarrays and scalars no longer compute their
+// result immediately but return lightweight expression nodes
+// that merely reference their operands. Evaluating such an
+// expression into a dynarray computes every element of the
+// result in a single fused loop without any intermediate
+// dynarray, e.g.
+//
+//     using namespace utils::expr;
+//     auto r = evaluate(a * b + 2.0f * c);
+//     assign(r, r - a);
+//
+// Operand sizes are checked once when a node is created.
+// Expression nodes reference the dynarrays they were built
+// from, so these must outlive the expression.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_DYNARRAY_EXPR_HPP
+#define UTILS_DYNARRAY_EXPR_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// headers used by definition site
+#include <stdexcept>
+#include <string>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	namespace expr {
+		/// Size reported by scalar nodes which adapt to the size of any other operand.
+		constexpr size_t any_size = static_cast<size_t>(-1);
+
+		/// Base of all expression nodes. \E is the derived node type.
+		template<typename E>
+		struct expression {
+			auto self() const -> E const& { return static_cast<E const&>(*this); }
+		};
+
+		/// Leaf node referencing the elements of a dynarray.
+		template<typename T>
+		class terminal : public expression<terminal<T>> {
+		public:
+			using value_type = T;
+
+			explicit terminal(dynarray<T> const& array);
+
+			auto operator[](size_t pos) const -> value_type;
+			auto size() const -> size_t;
+
+		private:
+			T const* m_data;
+			size_t   m_size;
+		};
+
+		/// Leaf node that yields the same value for every position.
+		template<typename T>
+		class scalar : public expression<scalar<T>> {
+		public:
+			using value_type = T;
+
+			explicit scalar(T value);
+
+			auto operator[](size_t pos) const -> value_type;
+			auto size() const -> size_t;
+
+		private:
+			T m_value;
+		};
+
+		/// Node applying \Op to the elements of \E.
+		template<typename Op, typename E>
+		class unary : public expression<unary<Op, E>> {
+		public:
+			using value_type = decltype(Op{}(std::declval<typename E::value_type>()));
+
+			explicit unary(E operand);
+
+			auto operator[](size_t pos) const -> value_type;
+			auto size() const -> size_t;
+
+		private:
+			E m_operand;
+		};
+
+		/// Node combining the elements at equal positions of \L and \R with \Op.
+		template<typename Op, typename L, typename R>
+		class binary : public expression<binary<Op, L, R>> {
+		public:
+			using value_type = decltype(Op{}(
+				std::declval<typename L::value_type>(),
+				std::declval<typename R::value_type>()));
+
+			/// Throws an invalid_argument exception when the sizes are unequal.
+			binary(L lhs, R rhs);
+
+			auto operator[](size_t pos) const -> value_type;
+			auto size() const -> size_t;
+
+		private:
+			L      m_lhs;
+			R      m_rhs;
+			size_t m_size;
+		};
+
+		/// Returns a new dynarray holding the elements of \e.
+		template<typename E>
+		auto evaluate(expression<E> const& e) -> dynarray<typename E::value_type>;
+
+		/// Stores the elements of \e into \dst in a single pass.
+		/// \dst may be referenced by \e itself.
+		/// Throws an invalid_argument exception when the sizes are unequal.
+		template<typename T, typename E>
+		void assign(dynarray<T> & dst, expression<E> const& e);
+	}
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace expr {
+		namespace detail {
+			struct plus {
+				template<typename L, typename R>
+				auto operator()(L lhs, R rhs) const -> decltype(lhs + rhs) { return lhs + rhs; }
+			};
+
+			struct minus {
+				template<typename L, typename R>
+				auto operator()(L lhs, R rhs) const -> decltype(lhs - rhs) { return lhs - rhs; }
+			};
+
+			struct multiplies {
+				template<typename L, typename R>
+				auto operator()(L lhs, R rhs) const -> decltype(lhs * rhs) { return lhs * rhs; }
+			};
+
+			struct divides {
+				template<typename L, typename R>
+				auto operator()(L lhs, R rhs) const -> decltype(lhs / rhs) { return lhs / rhs; }
+			};
+
+			struct negate {
+				template<typename T>
+				auto operator()(T value) const -> decltype(-value) { return -value; }
+			};
+
+			/// Maps an operand to the node type that represents it.
+			template<typename T, typename = void>
+			struct node_of {};
+
+			template<typename T>
+			struct node_of<dynarray<T>, std::enable_if_t<std::is_arithmetic<T>::value>> {
+				using type = terminal<T>;
+				static auto make(dynarray<T> const& array) -> type { return type{array}; }
+			};
+
+			template<typename T>
+			struct node_of<T, std::enable_if_t<std::is_arithmetic<T>::value>> {
+				using type = scalar<T>;
+				static auto make(T value) -> type { return type{value}; }
+			};
+
+			template<typename E>
+			struct node_of<E, std::enable_if_t<std::is_base_of<expression<E>, E>::value>> {
+				using type = E;
+				static auto make(E const& e) -> E const& { return e; }
+			};
+
+			template<typename T, typename = void>
+			struct is_operand : std::false_type {};
+
+			template<typename T>
+			struct is_operand<T, decltype(void(std::declval<typename node_of<T>::type>()))> : std::true_type {};
+
+			/// Operands of the binary operators: at least one must not be a scalar.
+			template<typename L, typename R>
+			struct is_binary_operands : std::integral_constant<bool,
+				is_operand<L>::value && is_operand<R>::value &&
+				!(std::is_arithmetic<L>::value && std::is_arithmetic<R>::value)> {};
+
+			template<typename Op, typename L, typename R>
+			using binary_t = binary<Op, typename node_of<L>::type, typename node_of<R>::type>;
+
+			template<typename Op, typename L, typename R>
+			auto make_binary(L const& lhs, R const& rhs) -> binary_t<Op, L, R> {
+				return {node_of<L>::make(lhs), node_of<R>::make(rhs)};
+			}
+		}
+
+		template<typename L, typename R, typename = std::enable_if_t<detail::is_binary_operands<L, R>::value>>
+		auto operator+(L const& lhs, R const& rhs) -> detail::binary_t<detail::plus, L, R> {
+			return detail::make_binary<detail::plus>(lhs, rhs);
+		}
+
+		template<typename L, typename R, typename = std::enable_if_t<detail::is_binary_operands<L, R>::value>>
+		auto operator-(L const& lhs, R const& rhs) -> detail::binary_t<detail::minus, L, R> {
+			return detail::make_binary<detail::minus>(lhs, rhs);
+		}
+
+		template<typename L, typename R, typename = std::enable_if_t<detail::is_binary_operands<L, R>::value>>
+		auto operator*(L const& lhs, R const& rhs) -> detail::binary_t<detail::multiplies, L, R> {
+			return detail::make_binary<detail::multiplies>(lhs, rhs);
+		}
+
+		template<typename L, typename R, typename = std::enable_if_t<detail::is_binary_operands<L, R>::value>>
+		auto operator/(L const& lhs, R const& rhs) -> detail::binary_t<detail::divides, L, R> {
+			return detail::make_binary<detail::divides>(lhs, rhs);
+		}
+
+		template<typename E, typename = std::enable_if_t<
+			detail::is_operand<E>::value && !std::is_arithmetic<E>::value>>
+		auto operator-(E const& operand) -> unary<detail::negate, typename detail::node_of<E>::type> {
+			return unary<detail::negate, typename detail::node_of<E>::type>{detail::node_of<E>::make(operand)};
+		}
+	}
+}
+
+//============================================================
+// Nodes
+//============================================================
+
+template<typename T>
+utils::expr::terminal<T>::terminal(dynarray<T> const& array):
+	m_data{array.data()},
+	m_size{array.size()}
+{}
+
+template<typename T>
+auto utils::expr::terminal<T>::operator[](size_t pos) const -> value_type {
+	return m_data[pos];
+}
+
+template<typename T>
+auto utils::expr::terminal<T>::size() const -> size_t {
+	return m_size;
+}
+
+template<typename T>
+utils::expr::scalar<T>::scalar(T value):
+	m_value{value}
+{}
+
+template<typename T>
+auto utils::expr::scalar<T>::operator[](size_t) const -> value_type {
+	return m_value;
+}
+
+template<typename T>
+auto utils::expr::scalar<T>::size() const -> size_t {
+	return any_size;
+}
+
+template<typename Op, typename E>
+utils::expr::unary<Op, E>::unary(E operand):
+	m_operand{std::move(operand)}
+{}
+
+template<typename Op, typename E>
+auto utils::expr::unary<Op, E>::operator[](size_t pos) const -> value_type {
+	return Op{}(m_operand[pos]);
+}
+
+template<typename Op, typename E>
+auto utils::expr::unary<Op, E>::size() const -> size_t {
+	return m_operand.size();
+}
+
+template<typename Op, typename L, typename R>
+utils::expr::binary<Op, L, R>::binary(L lhs, R rhs):
+	m_lhs{std::move(lhs)},
+	m_rhs{std::move(rhs)},
+	m_size{m_lhs.size() == any_size ? m_rhs.size() : m_lhs.size()}
+{
+	if (m_lhs.size() != m_rhs.size() && m_lhs.size() != any_size && m_rhs.size() != any_size) {
+		using namespace std::string_literals;
+		throw std::invalid_argument{
+			"cannot combine dynarrays of sizes "s +
+			std::to_string(m_lhs.size()) + " and " + std::to_string(m_rhs.size()) +
+			" elementwise"
+		};
+	}
+}
+
+template<typename Op, typename L, typename R>
+auto utils::expr::binary<Op, L, R>::operator[](size_t pos) const -> value_type {
+	return Op{}(m_lhs[pos], m_rhs[pos]);
+}
+
+template<typename Op, typename L, typename R>
+auto utils::expr::binary<Op, L, R>::size() const -> size_t {
+	return m_size;
+}
+
+//============================================================
+// Evaluation
+//============================================================
+
+template<typename E>
+auto utils::expr::evaluate(expression<E> const& e) -> dynarray<typename E::value_type> {
+	auto result = dynarray<typename E::value_type>(e.self().size());
+	assign(result, e);
+	return result;
+}
+
+template<typename T, typename E>
+void utils::expr::assign(dynarray<T> & dst, expression<E> const& e) {
+	auto const& node = e.self();
+	if (node.size() != dst.size()) {
+		using namespace std::string_literals;
+		throw std::invalid_argument{
+			"cannot assign expression of size "s +
+			std::to_string(node.size()) +
+			" to dynarray of size " +
+			std::to_string(dst.size())
+		};
+	}
+	// Every element only depends on operand elements at the same position,
+	// hence a destination that is also an operand is safe to overwrite.
+	auto const out = dst.data();
+	auto const size = dst.size();
+	for (size_t i = 0; i != size; ++i) {
+		out[i] = static_cast<T>(node[i]);
+	}
+}
+
+#endif // UTILS_DYNARRAY_EXPR_HPP
@@ -0,0 +1,436 @@
+//===---------------------------------------------------------
+//                       DYNARRAY_PARALLEL
+//===---------------------------------------------------------
+//
+// Parallel algorithms over the contiguous storage of
+// dynarray: for_each, transform, reduce, inclusive_scan,
+// count_if, fill, copy and sort.
+//
+// The algorithms split the elements into chunks that span
+// whole pages, or whole cache lines for small element
+// counts, and process them on the default work-stealing
+// thread_pool together with the calling thread. They
+// neither require TBB nor a parallel backend of the
+// standard library.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_DYNARRAY_PARALLEL_HPP
+#define UTILS_DYNARRAY_PARALLEL_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+#include "padded_dynarray.hpp"
+#include "thread_pool.hpp"
+
+#include <cstddef>
+
+// headers used by definition site
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	namespace par {
+		/// Invokes \f for every element of \array in parallel.
+		template<typename T, typename F>
+		void for_each(dynarray<T> & array, F f);
+
+		/// Invokes \f for every element of \array in parallel.
+		template<typename T, typename F>
+		void for_each(dynarray<T> const& array, F f);
+
+		/// Stores `op(src[i])` into `dst[i]` for every position i in parallel.
+		/// Throws an invalid_argument exception when the sizes are unequal.
+		template<typename T, typename U, typename UnaryOp>
+		void transform(dynarray<T> const& src, dynarray<U> & dst, UnaryOp op);
+
+		/// Stores `op(lhs[i], rhs[i])` into `dst[i]` for every position i in parallel.
+		/// Throws an invalid_argument exception when the sizes are unequal.
+		template<typename T1, typename T2, typename U, typename BinaryOp>
+		void transform(dynarray<T1> const& lhs, dynarray<T2> const& rhs, dynarray<U> & dst, BinaryOp op);
+
+		/// Reduces all elements of \array and \init with the associative \op.
+		///
+		/// Every chunk is reduced from left to right and the chunk results
+		/// are combined from left to right afterwards. The chunks span a
+		/// fixed number of pages regardless of the thread count, so the
+		/// result only depends on the size and the element type and is
+		/// reproducible across machines even for floating point addition.
+		template<typename T, typename R, typename BinaryOp>
+		auto reduce(dynarray<T> const& array, R init, BinaryOp op) -> R;
+
+		/// Returns the sum of \init and all elements of \array.
+		template<typename T, typename R>
+		auto reduce(dynarray<T> const& array, R init) -> R;
+
+		/// Stores the inclusive prefix reduction of \src under the associative \op
+		/// into \dst. \src and \dst may be the same dynarray.
+		/// Throws an invalid_argument exception when the sizes are unequal.
+		///
+		/// Every chunk is scanned from left to right and then combined with the
+		/// carry of all preceding chunks. Like reduce the chunks span a fixed
+		/// number of pages regardless of the thread count, so the result is
+		/// reproducible across machines even for floating point addition.
+		template<typename T, typename BinaryOp>
+		void inclusive_scan(dynarray<T> const& src, dynarray<T> & dst, BinaryOp op);
+
+		/// Stores the inclusive prefix sum of \src into \dst.
+		template<typename T>
+		void inclusive_scan(dynarray<T> const& src, dynarray<T> & dst);
+
+		/// Returns the number of elements of \array that satisfy \pred.
+		template<typename T, typename Predicate>
+		auto count_if(dynarray<T> const& array, Predicate pred) -> size_t;
+
+		/// Assigns \value to every element of \array in parallel.
+		template<typename T>
+		void fill(dynarray<T> & array, T const& value);
+
+		/// Copies all elements of \src into \dst in parallel.
+		/// Throws an invalid_argument exception when the sizes are unequal.
+		template<typename T>
+		void copy(dynarray<T> const& src, dynarray<T> & dst);
+
+		/// Sorts \array with respect to \comp in parallel. Not stable.
+		///
+		/// Partitions recursively around a median-of-three pivot and sorts
+		/// both partitions as independent tasks. Partitions below a grain
+		/// size and degenerated recursions are sorted by std::sort.
+		template<typename T, typename Compare>
+		void sort(dynarray<T> & array, Compare comp);
+
+		/// Sorts \array in ascending order in parallel. Not stable.
+		template<typename T>
+		void sort(dynarray<T> & array);
+
+		/// Returns the number of threads the algorithms run on, including the caller.
+		auto concurrency() -> size_t;
+	}
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace par {
+		namespace detail {
+			/// Inputs smaller than this many bytes are processed serially
+			/// since waking up the workers costs more than the work itself.
+			constexpr size_t serial_threshold_bytes = 32 * 1024;
+
+			/// Granularity of chunks for large inputs.
+			constexpr size_t page_size = 4096;
+
+			/// Number of chunks per thread so that uneven chunks balance out.
+			constexpr size_t chunks_per_thread = 4;
+
+			/// Pages per chunk of partitions that must not depend on the machine.
+			constexpr size_t fixed_chunk_pages = 16;
+
+			/// Partition of [0, size) into equally sized chunks.
+			/// Chunks span a whole number of pages (or of cache lines for
+			/// inputs below a page per chunk) so that the chunks of
+			/// different threads do not share cache lines in the common case.
+			struct chunking {
+				size_t size;
+				size_t chunk_size;
+				size_t chunk_count;
+
+				auto first(size_t chunk) const -> size_t {
+					return chunk * chunk_size;
+				}
+
+				auto last(size_t chunk) const -> size_t {
+					return std::min(size, (chunk + 1) * chunk_size);
+				}
+			};
+
+			template<typename T>
+			auto make_chunking(size_t size) -> chunking {
+				if (size == 0) {
+					return chunking{0, 1, 0};
+				}
+				if (size * sizeof(T) < serial_threshold_bytes) {
+					return chunking{size, size, 1};
+				}
+				auto const unit_bytes = size * sizeof(T) >=
+					page_size * chunks_per_thread * thread_pool::instance().concurrency()
+					? page_size : cache_line_size;
+				auto const unit = std::max<size_t>(1, unit_bytes / sizeof(T));
+				auto const target_chunks = thread_pool::instance().concurrency() * chunks_per_thread;
+				auto const units = (size + unit - 1) / unit;
+				auto const chunk_size = std::max<size_t>(1, (units + target_chunks - 1) / target_chunks) * unit;
+				return chunking{size, chunk_size, (size + chunk_size - 1) / chunk_size};
+			}
+
+			/// Returns a partition into chunks of fixed_chunk_pages pages that, unlike
+			/// make_chunking, does not depend on the concurrency of the machine.
+			template<typename T>
+			auto make_fixed_chunking(size_t size) -> chunking {
+				if (size == 0) {
+					return chunking{0, 1, 0};
+				}
+				if (size * sizeof(T) < serial_threshold_bytes) {
+					return chunking{size, size, 1};
+				}
+				auto const chunk_size = std::max<size_t>(1, fixed_chunk_pages * page_size / sizeof(T));
+				return chunking{size, chunk_size, (size + chunk_size - 1) / chunk_size};
+			}
+
+			/// Invokes \f(i) for every i in [0, \tasks) in parallel on the default thread_pool.
+			template<typename F>
+			void run_tasks(size_t tasks, F && f) {
+				thread_pool::instance().parallel_for(0, tasks, 1, [&](size_t first, size_t last) {
+					for (auto task = first; task != last; ++task) {
+						f(task);
+					}
+				});
+			}
+
+			/// Invokes \f(first, last) for every chunk of the \chunks partition in parallel.
+			template<typename F>
+			void for_each_chunk(chunking const& chunks, F f) {
+				run_tasks(chunks.chunk_count, [&](size_t chunk) { f(chunks.first(chunk), chunks.last(chunk)); });
+			}
+
+			inline void ensure_same_size(size_t expected, size_t actual, char const* algorithm) {
+				if (expected != actual) {
+					using namespace std::string_literals;
+					throw std::invalid_argument{
+						"cannot "s + algorithm + " dynarray of size " +
+						std::to_string(expected) +
+						" into dynarray of size " +
+						std::to_string(actual)
+					};
+				}
+			}
+
+			/// Partitions with fewer elements are sorted serially.
+			constexpr size_t sort_grain = 16 * 1024;
+
+			template<typename T, typename Compare>
+			void parallel_quicksort(T * first, T * last, Compare & comp, unsigned depth_budget) {
+				auto const size = static_cast<size_t>(last - first);
+				if (size <= sort_grain || depth_budget == 0) {
+					std::sort(first, last, comp);
+					return;
+				}
+				auto const mid = first + size / 2;
+				auto const& a = *first;
+				auto const& b = *mid;
+				auto const& c = *(last - 1);
+				T const pivot =
+					comp(a, b) ? (comp(b, c) ? b : (comp(a, c) ? c : a))
+					           : (comp(a, c) ? a : (comp(b, c) ? c : b));
+				// Three-way partition: [less | equal | greater] so that many
+				// duplicates of the pivot do not degenerate the recursion.
+				auto const less_end = std::partition(first, last,
+					[&](T const& x) { return comp(x, pivot); });
+				auto const equal_end = std::partition(less_end, last,
+					[&](T const& x) { return !comp(pivot, x); });
+				thread_pool::instance().parallel_invoke(
+					[&] { parallel_quicksort(first, less_end, comp, depth_budget - 1); },
+					[&] { parallel_quicksort(equal_end, last, comp, depth_budget - 1); });
+			}
+
+			struct less {
+				template<typename L, typename R>
+				auto operator()(L const& lhs, R const& rhs) const -> bool {
+					return lhs < rhs;
+				}
+			};
+
+			struct plus {
+				template<typename L, typename R>
+				auto operator()(L const& lhs, R const& rhs) const -> decltype(lhs + rhs) {
+					return lhs + rhs;
+				}
+			};
+		}
+	}
+}
+
+template<typename T, typename F>
+void utils::par::for_each(dynarray<T> & array, F f) {
+	auto const data = array.data();
+	detail::for_each_chunk(detail::make_chunking<T>(array.size()), [&](size_t first, size_t last) {
+		std::for_each(data + first, data + last, f);
+	});
+}
+
+template<typename T, typename F>
+void utils::par::for_each(dynarray<T> const& array, F f) {
+	auto const data = array.data();
+	detail::for_each_chunk(detail::make_chunking<T>(array.size()), [&](size_t first, size_t last) {
+		std::for_each(data + first, data + last, f);
+	});
+}
+
+template<typename T, typename U, typename UnaryOp>
+void utils::par::transform(dynarray<T> const& src, dynarray<U> & dst, UnaryOp op) {
+	detail::ensure_same_size(src.size(), dst.size(), "transform");
+	auto const in = src.data();
+	auto const out = dst.data();
+	detail::for_each_chunk(detail::make_chunking<U>(dst.size()), [&](size_t first, size_t last) {
+		std::transform(in + first, in + last, out + first, op);
+	});
+}
+
+template<typename T1, typename T2, typename U, typename BinaryOp>
+void utils::par::transform(dynarray<T1> const& lhs, dynarray<T2> const& rhs, dynarray<U> & dst, BinaryOp op) {
+	detail::ensure_same_size(lhs.size(), rhs.size(), "transform");
+	detail::ensure_same_size(lhs.size(), dst.size(), "transform");
+	auto const in1 = lhs.data();
+	auto const in2 = rhs.data();
+	auto const out = dst.data();
+	detail::for_each_chunk(detail::make_chunking<U>(dst.size()), [&](size_t first, size_t last) {
+		std::transform(in1 + first, in1 + last, in2 + first, out + first, op);
+	});
+}
+
+template<typename T, typename R, typename BinaryOp>
+auto utils::par::reduce(dynarray<T> const& array, R init, BinaryOp op) -> R {
+	auto const chunks = detail::make_fixed_chunking<T>(array.size());
+	if (chunks.chunk_count == 0) {
+		return init;
+	}
+	auto const data = array.data();
+	auto partials = std::vector<R>(chunks.chunk_count, init);
+	auto task = [&](size_t chunk) {
+		auto const first = chunks.first(chunk);
+		auto const last = chunks.last(chunk);
+		R acc = data[first];
+		for (auto i = first + 1; i != last; ++i) {
+			acc = op(std::move(acc), data[i]);
+		}
+		partials[chunk] = std::move(acc);
+	};
+	detail::run_tasks(chunks.chunk_count, task);
+	for (auto & partial : partials) {
+		init = op(std::move(init), std::move(partial));
+	}
+	return init;
+}
+
+template<typename T, typename R>
+auto utils::par::reduce(dynarray<T> const& array, R init) -> R {
+	return reduce(array, std::move(init), detail::plus{});
+}
+
+template<typename T, typename BinaryOp>
+void utils::par::inclusive_scan(dynarray<T> const& src, dynarray<T> & dst, BinaryOp op) {
+	detail::ensure_same_size(src.size(), dst.size(), "inclusive_scan");
+	auto const chunks = detail::make_fixed_chunking<T>(src.size());
+	if (chunks.chunk_count == 0) {
+		return;
+	}
+	auto const in = src.data();
+	auto const out = dst.data();
+	// Pass 1: scan every chunk independently.
+	auto pass1 = [&](size_t chunk) {
+		auto const first = chunks.first(chunk);
+		auto const last = chunks.last(chunk);
+		T acc = in[first];
+		out[first] = acc;
+		for (auto i = first + 1; i != last; ++i) {
+			acc = op(acc, in[i]);
+			out[i] = acc;
+		}
+	};
+	detail::run_tasks(chunks.chunk_count, pass1);
+	if (chunks.chunk_count == 1) {
+		return;
+	}
+	// Serially compute the carry into every chunk from the chunk totals.
+	auto carries = std::vector<T>();
+	carries.reserve(chunks.chunk_count - 1);
+	carries.push_back(out[chunks.last(0) - 1]);
+	for (size_t chunk = 1; chunk + 1 < chunks.chunk_count; ++chunk) {
+		carries.push_back(op(carries.back(), out[chunks.last(chunk) - 1]));
+	}
+	// Pass 2: apply the carries to all chunks except the first.
+	auto pass2 = [&](size_t task) {
+		auto const chunk = task + 1;
+		auto const& carry = carries[task];
+		for (auto i = chunks.first(chunk); i != chunks.last(chunk); ++i) {
+			out[i] = op(carry, out[i]);
+		}
+	};
+	detail::run_tasks(chunks.chunk_count - 1, pass2);
+}
+
+template<typename T>
+void utils::par::inclusive_scan(dynarray<T> const& src, dynarray<T> & dst) {
+	inclusive_scan(src, dst, detail::plus{});
+}
+
+template<typename T, typename Predicate>
+auto utils::par::count_if(dynarray<T> const& array, Predicate pred) -> size_t {
+	auto const chunks = detail::make_chunking<T>(array.size());
+	auto const data = array.data();
+	auto counts = std::vector<size_t>(chunks.chunk_count, 0);
+	auto task = [&](size_t chunk) {
+		counts[chunk] = static_cast<size_t>(
+			std::count_if(data + chunks.first(chunk), data + chunks.last(chunk), pred));
+	};
+	detail::run_tasks(chunks.chunk_count, task);
+	size_t total = 0;
+	for (auto count : counts) {
+		total += count;
+	}
+	return total;
+}
+
+template<typename T>
+void utils::par::fill(dynarray<T> & array, T const& value) {
+	auto const data = array.data();
+	detail::for_each_chunk(detail::make_chunking<T>(array.size()), [&](size_t first, size_t last) {
+		std::fill(data + first, data + last, value);
+	});
+}
+
+template<typename T>
+void utils::par::copy(dynarray<T> const& src, dynarray<T> & dst) {
+	detail::ensure_same_size(src.size(), dst.size(), "copy");
+	auto const in = src.data();
+	auto const out = dst.data();
+	detail::for_each_chunk(detail::make_chunking<T>(dst.size()), [&](size_t first, size_t last) {
+		std::copy(in + first, in + last, out + first);
+	});
+}
+
+template<typename T, typename Compare>
+void utils::par::sort(dynarray<T> & array, Compare comp) {
+	unsigned depth_budget = 0;
+	for (auto size = array.size(); size > 1; size /= 2) {
+		depth_budget += 2;
+	}
+	detail::parallel_quicksort(array.data(), array.data() + array.size(), comp, depth_budget);
+}
+
+template<typename T>
+void utils::par::sort(dynarray<T> & array) {
+	sort(array, detail::less{});
+}
+
+inline auto utils::par::concurrency() -> size_t {
+	return thread_pool::instance().concurrency();
+}
+
+#endif // UTILS_DYNARRAY_PARALLEL_HPP
@@ -0,0 +1,609 @@
+//===---------------------------------------------------------
+//                       DYNARRAY_SERIALIZE
+//===---------------------------------------------------------
+//
+// Compact binary format for dynarrays of trivially copyable
+// elements.
+//
+// A serialized dynarray consists of a 64 byte header and the
+// raw memory of its elements. The header records the element
+// type, the element size and alignment, the element count,
+// the byte order of the writer and a checksum (XXH64) over
+// the payload. Since the payload starts 64 bytes into the
+// blob, it is suitably aligned for every element type
+// whenever the blob itself is, e.g. for mmapped files.
+//
+// Writing and reading transfer the payload with a single bulk
+// stream operation or system call (repeated only for partial
+// transfers) instead of streaming element by element.
+// from_buffer validates a blob in memory and views its
+// elements in place without copying them.
+//
+// Batches of dynarrays are written and read with vectored
+// I/O (writev/readv) that gathers the headers and payloads of
+// all dynarrays in a handful of system calls.
+//
+// Blobs are not converted between byte orders: reading a
+// blob written on a machine of the other byte order fails.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_DYNARRAY_SERIALIZE_HPP
+#define UTILS_DYNARRAY_SERIALIZE_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+#include "dynarray_view.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+#if !defined(UTILS_SERIAL_POSIX) && (defined(__unix__) || defined(__APPLE__))
+	#define UTILS_SERIAL_POSIX 1
+#endif
+
+// headers used by definition site
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ios>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if defined(UTILS_SERIAL_POSIX)
+	#include <climits>
+	#include <sys/stat.h>
+	#include <sys/uio.h>
+	#include <unistd.h>
+#endif
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	namespace serial {
+		/// Element type recorded in the header. Trivially copyable types other
+		/// than the arithmetic ones are recorded as opaque and identified by size
+		/// and alignment only.
+		enum class type_tag : std::uint8_t {
+			opaque,
+			boolean,
+			int8, uint8,
+			int16, uint16,
+			int32, uint32,
+			int64, uint64,
+			float32, float64
+		};
+
+		/// Byte order of the machine that wrote a blob.
+		enum class byte_order : std::uint8_t {
+			little = 1,
+			big    = 2
+		};
+
+		/// The header preceding the payload of every serialized dynarray.
+		/// All fields are stored in the byte order recorded in \endianness.
+		struct header {
+			char          magic[4];
+			std::uint8_t  version;
+			byte_order    endianness;
+			type_tag      type;
+			std::uint8_t  reserved0;
+			std::uint32_t element_size;
+			std::uint32_t alignment;
+			std::uint64_t size;
+			std::uint64_t checksum;
+			std::uint8_t  reserved[32];
+		};
+
+		static_assert(sizeof(header) == 64, "the serialized header must be 64 bytes");
+
+		/// The current format version.
+		constexpr std::uint8_t format_version = 1;
+
+		/// Returns the number of bytes of \array in serialized form.
+		template<typename T>
+		auto serialized_size(dynarray<T> const& array) -> size_t;
+
+		/// Writes \array to \stream.
+		/// Throws an ios_base::failure exception if the stream fails.
+		template<typename T>
+		void write(std::ostream & stream, dynarray<T> const& array);
+
+		/// Reads a dynarray from \stream.
+		/// Throws an invalid_argument exception if the blob is malformed, truncated,
+		/// was written for another element type or its checksum does not match.
+		/// The result is allocated up front only if the stream can seek and holds
+		/// the whole payload; otherwise the payload is staged in bounded chunks.
+		template<typename T>
+		auto read(std::istream & stream) -> dynarray<T>;
+
+	#if defined(UTILS_SERIAL_POSIX)
+		/// Writes \array to the file descriptor \fd at its current offset.
+		/// Throws a system_error exception if a system call fails.
+		template<typename T>
+		void write(int fd, dynarray<T> const& array);
+
+		/// Reads a dynarray from the file descriptor \fd at its current offset.
+		/// Throws a system_error exception if a system call fails and an
+		/// invalid_argument exception under the same conditions as read(istream).
+		/// Sizes exceeding the rest of a regular file are rejected before allocating.
+		template<typename T>
+		auto read(int fd) -> dynarray<T>;
+
+		/// Writes many dynarrays of any element types with as few writev calls as
+		/// possible, gathering headers and payloads without copying the elements.
+		/// The result is the same as calling write for each dynarray in order.
+		/// The added dynarrays must outlive the batch and stay unmodified.
+		class write_batch {
+		public:
+			/// Appends \array to the batch.
+			template<typename T>
+			void add(dynarray<T> const& array);
+
+			/// Writes all added dynarrays to \fd at its current offset.
+			/// Throws a system_error exception if a system call fails.
+			void write(int fd) const;
+
+			/// Writes all added dynarrays to \fd at \offset without moving its offset.
+			/// Throws a system_error exception if a system call fails.
+			void write(int fd, std::uint64_t offset) const;
+
+			/// Returns the number of bytes written by write.
+			auto size_bytes() const -> std::uint64_t;
+
+		private:
+			struct entry {
+				header       head;
+				void const*  payload;
+				size_t       bytes;
+			};
+
+			std::vector<entry> m_entries;
+		};
+
+		/// Reads many dynarrays written by write or write_batch in one go with as
+		/// few readv calls as possible, scattering the payloads directly into the
+		/// preallocated dynarrays. The added dynarrays must outlive the batch.
+		class read_batch {
+		public:
+			/// Appends \array to the batch. Its size must match the stored size.
+			template<typename T>
+			void add(dynarray<T> & array);
+
+			/// Reads all added dynarrays from \fd at its current offset.
+			/// Throws a system_error exception if a system call fails and an
+			/// invalid_argument exception under the conditions of read(istream)
+			/// or if a stored size differs from the size of its dynarray.
+			void read(int fd);
+
+			/// Reads all added dynarrays from \fd at \offset without moving its offset.
+			/// Throws like read(int).
+			void read(int fd, std::uint64_t offset);
+
+		private:
+			struct entry {
+				header  head;
+				void *  payload;
+				size_t  bytes;
+				size_t  size;
+				size_t  (*check)(header const&);
+			};
+
+			void verify() const;
+
+			std::vector<entry> m_entries;
+		};
+	#endif
+
+		/// Validates the blob of \size bytes at \data and returns a view onto its
+		/// elements without copying them. \data must stay valid as long as the view
+		/// is used. Verifies the checksum over the payload if \verify_checksum is set.
+		/// Throws an invalid_argument exception under the same conditions as read(istream)
+		/// or if the payload is not suitably aligned for T.
+		template<typename T>
+		auto from_buffer(void const* data, size_t size, bool verify_checksum = true) -> dynarray_view<T const>;
+	}
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace serial {
+		namespace detail {
+			template<typename T>
+			constexpr auto tag_of() -> type_tag {
+				return std::is_same<T, bool>::value ? type_tag::boolean
+					: std::is_integral<T>::value && sizeof(T) == 1 ? (std::is_signed<T>::value ? type_tag::int8  : type_tag::uint8)
+					: std::is_integral<T>::value && sizeof(T) == 2 ? (std::is_signed<T>::value ? type_tag::int16 : type_tag::uint16)
+					: std::is_integral<T>::value && sizeof(T) == 4 ? (std::is_signed<T>::value ? type_tag::int32 : type_tag::uint32)
+					: std::is_integral<T>::value && sizeof(T) == 8 ? (std::is_signed<T>::value ? type_tag::int64 : type_tag::uint64)
+					: std::is_floating_point<T>::value && sizeof(T) == 4 ? type_tag::float32
+					: std::is_floating_point<T>::value && sizeof(T) == 8 ? type_tag::float64
+					: type_tag::opaque;
+			}
+
+			inline auto native_byte_order() -> byte_order {
+				std::uint16_t const probe = 1;
+				unsigned char first;
+				std::memcpy(&first, &probe, 1);
+				return first == 1 ? byte_order::little : byte_order::big;
+			}
+
+			template<typename T>
+			void ensure_serializable() {
+				static_assert(std::is_trivially_copyable<T>::value,
+					"only dynarrays of trivially copyable elements can be serialized");
+				static_assert(alignof(T) <= sizeof(header),
+					"the payload of serialized dynarrays is aligned to at most 64 bytes");
+			}
+
+			template<typename T>
+			auto make_header(dynarray<T> const& array) -> header {
+				auto result = header{};
+				std::memcpy(result.magic, "DYNA", 4);
+				result.version      = format_version;
+				result.endianness   = native_byte_order();
+				result.type         = tag_of<T>();
+				result.element_size = static_cast<std::uint32_t>(sizeof(T));
+				result.alignment    = static_cast<std::uint32_t>(alignof(T));
+				result.size         = static_cast<std::uint64_t>(array.size());
+				result.checksum     = utils::detail::hash_bytes(array.data(), array.size() * sizeof(T), 0);
+				return result;
+			}
+
+			[[noreturn]] inline void malformed(char const* reason) {
+				using namespace std::string_literals;
+				throw std::invalid_argument{"cannot deserialize dynarray: "s + reason};
+			}
+
+			/// Validates \h for elements of type T and returns the payload size in bytes.
+			template<typename T>
+			auto check_header(header const& h) -> size_t {
+				if (std::memcmp(h.magic, "DYNA", 4) != 0) {
+					malformed("not a serialized dynarray");
+				}
+				if (h.endianness != native_byte_order()) {
+					malformed("written with a different byte order");
+				}
+				if (h.version != format_version) {
+					malformed("unsupported format version");
+				}
+				if (h.type != tag_of<T>() || h.element_size != sizeof(T) || h.alignment != alignof(T)) {
+					malformed("written for a different element type");
+				}
+				if (h.size > static_cast<std::uint64_t>(-1) / sizeof(T) || h.size * sizeof(T) > static_cast<size_t>(-1)) {
+					malformed("size exceeds the address space");
+				}
+				return static_cast<size_t>(h.size * sizeof(T));
+			}
+
+			inline void check_checksum(header const& h, void const* payload, size_t bytes) {
+				if (utils::detail::hash_bytes(payload, bytes, 0) != h.checksum) {
+					malformed("checksum mismatch");
+				}
+			}
+
+			/// Bytes read per step when the remaining length of the source is unknown.
+			constexpr size_t staging_chunk = 1 << 20;
+
+			/// Reads the \bytes bytes of a payload of T through \read_chunk, which
+			/// must read exactly the requested bytes or throw. The payload is staged
+			/// in a buffer that grows only as data arrives, so that a corrupt size
+			/// runs out of data before it can force a huge allocation.
+			template<typename T, typename ReadChunk>
+			auto read_staged(size_t bytes, ReadChunk && read_chunk) -> dynarray<T> {
+				auto staged = std::vector<unsigned char>{};
+				while (staged.size() != bytes) {
+					auto const offset = staged.size();
+					staged.resize(offset + std::min(bytes - offset, staging_chunk));
+					read_chunk(staged.data() + offset, staged.size() - offset);
+				}
+				auto result = dynarray<T>(bytes / sizeof(T));
+				if (bytes != 0) {
+					std::memcpy(result.data(), staged.data(), bytes);
+				}
+				return result;
+			}
+
+			/// Returns the number of bytes left in \stream or -1 if it cannot seek.
+			inline auto remaining_bytes(std::istream & stream) -> long long {
+				auto const position = stream.tellg();
+				if (position == std::istream::pos_type(-1)) {
+					stream.clear();
+					return -1;
+				}
+				stream.seekg(0, std::ios_base::end);
+				auto const end = stream.tellg();
+				stream.clear();
+				stream.seekg(position);
+				if (end == std::istream::pos_type(-1)) {
+					return -1;
+				}
+				return static_cast<long long>(end - position);
+			}
+
+		#if defined(UTILS_SERIAL_POSIX)
+			inline void write_all(int fd, void const* data, size_t bytes) {
+				auto p = static_cast<char const*>(data);
+				while (bytes != 0) {
+					auto const written = ::write(fd, p, bytes);
+					if (written < 0) {
+						if (errno == EINTR) {
+							continue;
+						}
+						throw std::system_error{errno, std::generic_category(), "cannot write dynarray"};
+					}
+					p += written;
+					bytes -= static_cast<size_t>(written);
+				}
+			}
+
+			/// Returns the number of bytes left in the regular file \fd from its
+			/// current offset or -1 for other kinds of files.
+			inline auto remaining_bytes(int fd) -> long long {
+				struct ::stat status;
+				if (::fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+					return -1;
+				}
+				auto const offset = ::lseek(fd, 0, SEEK_CUR);
+				if (offset < 0) {
+					return -1;
+				}
+				return offset < status.st_size ? static_cast<long long>(status.st_size - offset) : 0;
+			}
+
+			inline void read_all(int fd, void * data, size_t bytes) {
+				auto p = static_cast<char *>(data);
+				while (bytes != 0) {
+					auto const received = ::read(fd, p, bytes);
+					if (received < 0) {
+						if (errno == EINTR) {
+							continue;
+						}
+						throw std::system_error{errno, std::generic_category(), "cannot read dynarray"};
+					}
+					if (received == 0) {
+						malformed("unexpected end of file");
+					}
+					p += received;
+					bytes -= static_cast<size_t>(received);
+				}
+			}
+
+			/// Transfers all of \vectors to or from \fd, at \offset unless it is negative.
+			/// Splits the transfer into calls of at most IOV_MAX buffers and resumes
+			/// after partial transfers. Empty buffers must have been left out.
+			inline void transfer_vectors(int fd, std::vector<::iovec> & vectors, bool writing, long long offset) {
+				auto first = vectors.data();
+				auto const last = vectors.data() + vectors.size();
+				while (first != last) {
+					auto const count = static_cast<int>(last - first < IOV_MAX ? last - first : IOV_MAX);
+					auto const transferred = writing
+						? (offset < 0 ? ::writev(fd, first, count) : ::pwritev(fd, first, count, static_cast<off_t>(offset)))
+						: (offset < 0 ? ::readv(fd, first, count) : ::preadv(fd, first, count, static_cast<off_t>(offset)));
+					if (transferred < 0) {
+						if (errno == EINTR) {
+							continue;
+						}
+						throw std::system_error{errno, std::generic_category(),
+							writing ? "cannot write dynarrays" : "cannot read dynarrays"};
+					}
+					if (transferred == 0 && !writing) {
+						malformed("unexpected end of file");
+					}
+					if (offset >= 0) {
+						offset += transferred;
+					}
+					auto rest = static_cast<size_t>(transferred);
+					while (first != last && rest >= first->iov_len) {
+						rest -= first->iov_len;
+						++first;
+					}
+					if (rest != 0) {
+						first->iov_base = static_cast<char *>(first->iov_base) + rest;
+						first->iov_len -= rest;
+					}
+				}
+			}
+
+			template<typename T>
+			auto check_batch_header(header const& h) -> size_t {
+				check_header<T>(h);
+				return static_cast<size_t>(h.size);
+			}
+		#endif
+		}
+	}
+}
+
+template<typename T>
+auto utils::serial::serialized_size(dynarray<T> const& array) -> size_t {
+	detail::ensure_serializable<T>();
+	return sizeof(header) + array.size() * sizeof(T);
+}
+
+template<typename T>
+void utils::serial::write(std::ostream & stream, dynarray<T> const& array) {
+	detail::ensure_serializable<T>();
+	auto const h = detail::make_header(array);
+	stream.write(reinterpret_cast<char const*>(&h), sizeof(h));
+	stream.write(reinterpret_cast<char const*>(array.data()), static_cast<std::streamsize>(array.size() * sizeof(T)));
+	if (!stream) {
+		throw std::ios_base::failure{"cannot write dynarray to stream"};
+	}
+}
+
+template<typename T>
+auto utils::serial::read(std::istream & stream) -> dynarray<T> {
+	detail::ensure_serializable<T>();
+	auto h = header{};
+	if (!stream.read(reinterpret_cast<char *>(&h), sizeof(h))) {
+		detail::malformed("unexpected end of stream");
+	}
+	auto const bytes = detail::check_header<T>(h);
+	auto const read_chunk = [&stream](void * data, size_t count) {
+		if (!stream.read(static_cast<char *>(data), static_cast<std::streamsize>(count))) {
+			detail::malformed("unexpected end of stream");
+		}
+	};
+	// The size is only trusted to allocate the result up front if the stream
+	// can tell that it holds the payload.
+	auto const remaining = detail::remaining_bytes(stream);
+	if (remaining < 0) {
+		auto result = detail::read_staged<T>(bytes, read_chunk);
+		detail::check_checksum(h, result.data(), bytes);
+		return result;
+	}
+	if (static_cast<unsigned long long>(remaining) < bytes) {
+		detail::malformed("unexpected end of stream");
+	}
+	// Trivially copyable elements are left uninitialized until the payload arrives.
+	auto result = dynarray<T>(static_cast<size_t>(h.size));
+	read_chunk(result.data(), bytes);
+	detail::check_checksum(h, result.data(), bytes);
+	return result;
+}
+
+#if defined(UTILS_SERIAL_POSIX)
+template<typename T>
+void utils::serial::write(int fd, dynarray<T> const& array) {
+	detail::ensure_serializable<T>();
+	auto const h = detail::make_header(array);
+	detail::write_all(fd, &h, sizeof(h));
+	detail::write_all(fd, array.data(), array.size() * sizeof(T));
+}
+
+template<typename T>
+auto utils::serial::read(int fd) -> dynarray<T> {
+	detail::ensure_serializable<T>();
+	auto h = header{};
+	detail::read_all(fd, &h, sizeof(h));
+	auto const bytes = detail::check_header<T>(h);
+	auto const read_chunk = [fd](void * data, size_t count) { detail::read_all(fd, data, count); };
+	// Pipes and sockets cannot tell their remaining length up front.
+	auto const remaining = detail::remaining_bytes(fd);
+	if (remaining < 0) {
+		auto result = detail::read_staged<T>(bytes, read_chunk);
+		detail::check_checksum(h, result.data(), bytes);
+		return result;
+	}
+	if (static_cast<unsigned long long>(remaining) < bytes) {
+		detail::malformed("unexpected end of file");
+	}
+	auto result = dynarray<T>(static_cast<size_t>(h.size));
+	read_chunk(result.data(), bytes);
+	detail::check_checksum(h, result.data(), bytes);
+	return result;
+}
+
+template<typename T>
+void utils::serial::write_batch::add(dynarray<T> const& array) {
+	detail::ensure_serializable<T>();
+	m_entries.push_back(entry{detail::make_header(array), array.data(), array.size() * sizeof(T)});
+}
+
+inline void utils::serial::write_batch::write(int fd) const {
+	write(fd, static_cast<std::uint64_t>(-1));
+}
+
+inline void utils::serial::write_batch::write(int fd, std::uint64_t offset) const {
+	auto vectors = std::vector<::iovec>{};
+	vectors.reserve(2 * m_entries.size());
+	for (auto const& e : m_entries) {
+		vectors.push_back(::iovec{const_cast<header *>(&e.head), sizeof(header)});
+		if (e.bytes != 0) {
+			vectors.push_back(::iovec{const_cast<void *>(e.payload), e.bytes});
+		}
+	}
+	detail::transfer_vectors(fd, vectors, true,
+		offset == static_cast<std::uint64_t>(-1) ? -1 : static_cast<long long>(offset));
+}
+
+inline auto utils::serial::write_batch::size_bytes() const -> std::uint64_t {
+	auto result = std::uint64_t{0};
+	for (auto const& e : m_entries) {
+		result += sizeof(header) + e.bytes;
+	}
+	return result;
+}
+
+template<typename T>
+void utils::serial::read_batch::add(dynarray<T> & array) {
+	detail::ensure_serializable<T>();
+	m_entries.push_back(entry{header{}, array.data(), array.size() * sizeof(T), array.size(),
+		&detail::check_batch_header<T>});
+}
+
+inline void utils::serial::read_batch::read(int fd) {
+	read(fd, static_cast<std::uint64_t>(-1));
+}
+
+inline void utils::serial::read_batch::read(int fd, std::uint64_t offset) {
+	// The headers are read along with the payloads and validated afterwards;
+	// a payload of the wrong size is caught by the size check of its header.
+	auto vectors = std::vector<::iovec>{};
+	vectors.reserve(2 * m_entries.size());
+	for (auto & e : m_entries) {
+		vectors.push_back(::iovec{&e.head, sizeof(header)});
+		if (e.bytes != 0) {
+			vectors.push_back(::iovec{e.payload, e.bytes});
+		}
+	}
+	detail::transfer_vectors(fd, vectors, false,
+		offset == static_cast<std::uint64_t>(-1) ? -1 : static_cast<long long>(offset));
+	verify();
+}
+
+inline void utils::serial::read_batch::verify() const {
+	for (auto const& e : m_entries) {
+		if (e.check(e.head) != e.size) {
+			using namespace std::string_literals;
+			throw std::invalid_argument{
+				"cannot deserialize dynarray of size "s + std::to_string(e.size) +
+				" from blob of size " + std::to_string(e.head.size)
+			};
+		}
+		detail::check_checksum(e.head, e.payload, e.bytes);
+	}
+}
+#endif
+
+template<typename T>
+auto utils::serial::from_buffer(void const* data, size_t size, bool verify_checksum) -> dynarray_view<T const> {
+	detail::ensure_serializable<T>();
+	if (size < sizeof(header)) {
+		detail::malformed("buffer smaller than the header");
+	}
+	auto h = header{};
+	std::memcpy(&h, data, sizeof(h));
+	auto const bytes = detail::check_header<T>(h);
+	if (size - sizeof(header) < bytes) {
+		detail::malformed("buffer smaller than the payload");
+	}
+	auto const payload = static_cast<unsigned char const*>(data) + sizeof(header);
+	if (reinterpret_cast<std::uintptr_t>(payload) % alignof(T) != 0) {
+		detail::malformed("payload misaligned for the element type");
+	}
+	if (verify_checksum) {
+		detail::check_checksum(h, payload, bytes);
+	}
+	return dynarray_view<T const>{reinterpret_cast<T const*>(payload), static_cast<size_t>(h.size)};
+}
+
+#endif // UTILS_DYNARRAY_SERIALIZE_HPP
@@ -0,0 +1,1410 @@
+//===---------------------------------------------------------
+//                       DYNARRAY_SIMD
+//===---------------------------------------------------------
+//
+// Vectorized reductions over arithmetic dynarrays: sum, dot,
+// norm, min, max, minmax, argmin and argmax.
+//
+// Compilers do not vectorize floating point reductions on
+// their own since addition is not associative. The kernels
+// in this header therefore fix one reassociation order that
+// is independent of the instruction set: the elements are
+// distributed round-robin over a fixed number of lanes that
+// span 128 bytes, i.e. element i is accumulated into lane
+// `i % (128 / sizeof(T))` from left to right, and the lanes
+// are combined pairwise afterwards by repeatedly folding the
+// upper half onto the lower half. SSE2, AVX2 and AVX-512
+// hold these lanes in 8, 4 and 2 registers respectively
+// which hides the latency of the vector additions.
+//
+// All paths produce bit-identical results. The kernel for
+// the running CPU is selected at runtime so that a binary
+// compiled with baseline flags still uses AVX2 or AVX-512
+// (see cpu_dispatch.hpp).
+//
+// Integer sums (taken modulo 2^64), minima and maxima do not
+// depend on the order of the elements. 32-bit and 64-bit
+// integers therefore have vector kernels for sum, min, max
+// and the searches of argmin and argmax that are free to
+// process the elements in any order. All other element types
+// use the fixed order in portable scalar code.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_DYNARRAY_SIMD_HPP
+#define UTILS_DYNARRAY_SIMD_HPP
+
+// headers used by declaration site
+#include "cpu_dispatch.hpp"
+#include "dynarray.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+// headers used by definition site
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	namespace simd {
+		/// The kernels follow the process-wide selection of cpu_dispatch.hpp.
+		/// Since all paths produce identical results restricting it with
+		/// set_active_isa is only useful for benchmarking and testing.
+		using cpu::isa;
+		using cpu::detected_isa;
+		using cpu::active_isa;
+		using cpu::set_active_isa;
+
+		/// Result type of sum and dot: the element type for floating point
+		/// elements and a 64-bit integer of the same signedness otherwise.
+		/// Integer results wrap around modulo 2^64 instead of overflowing.
+		template<typename T>
+		using accumulate_t = std::conditional_t<
+			std::is_floating_point<T>::value,
+			T,
+			std::conditional_t<std::is_signed<T>::value, std::int64_t, std::uint64_t>>;
+
+		/// Returns the sum of all elements of \array. Returns zero if \array is empty.
+		template<typename T>
+		auto sum(dynarray<T> const& array) -> accumulate_t<T>;
+
+		/// Returns the sum of the elementwise products of \lhs and \rhs.
+		/// Throws an invalid_argument exception when the sizes are unequal.
+		///
+		/// Products are rounded before they are accumulated, i.e. they are not
+		/// fused into FMA instructions even if FMA is enabled globally.
+		template<typename T>
+		auto dot(dynarray<T> const& lhs, dynarray<T> const& rhs) -> accumulate_t<T>;
+
+		/// Returns the Euclidean norm of \array, i.e. `sqrt(dot(array, array))`.
+		template<typename T>
+		auto norm(dynarray<T> const& array) -> T;
+
+		/// Returns the smallest element of \array.
+		/// Throws an invalid_argument exception if \array is empty.
+		/// The result is unspecified if \array contains NaN.
+		template<typename T>
+		auto min(dynarray<T> const& array) -> T;
+
+		/// Returns the largest element of \array.
+		/// Throws an invalid_argument exception if \array is empty.
+		/// The result is unspecified if \array contains NaN.
+		template<typename T>
+		auto max(dynarray<T> const& array) -> T;
+
+		/// Returns the smallest and the largest element of \array in a single pass.
+		/// Throws an invalid_argument exception if \array is empty.
+		/// The result is unspecified if \array contains NaN.
+		template<typename T>
+		auto minmax(dynarray<T> const& array) -> std::pair<T, T>;
+
+		/// Returns the position of the first element that compares equal to min(\array).
+		/// Throws an invalid_argument exception if \array is empty.
+		/// If \array contains NaN and min(\array) is NaN the position of the first NaN is returned.
+		template<typename T>
+		auto argmin(dynarray<T> const& array) -> size_t;
+
+		/// Returns the position of the first element that compares equal to max(\array).
+		/// Throws an invalid_argument exception if \array is empty.
+		/// If \array contains NaN and max(\array) is NaN the position of the first NaN is returned.
+		template<typename T>
+		auto argmax(dynarray<T> const& array) -> size_t;
+	}
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace simd {
+		namespace detail {
+			/// Number of lanes of the reassociation order for elements of type T.
+			template<typename T>
+			struct lane_count : std::integral_constant<size_t,
+				sizeof(T) < 128 ? 128 / sizeof(T) : 1> {};
+
+			struct min_op {
+				template<typename T>
+				auto operator()(T const& acc, T const& value) const -> T {
+					// Same operand order as the minps instruction.
+					return acc < value ? acc : value;
+				}
+			};
+
+			struct max_op {
+				template<typename T>
+				auto operator()(T const& acc, T const& value) const -> T {
+					// Same operand order as the maxps instruction.
+					return acc > value ? acc : value;
+				}
+			};
+
+			/// Folds the upper half of \lanes onto the lower half until one lane is left.
+			template<typename A, size_t Lanes, typename BinaryOp>
+			auto combine_lanes(A (&lanes)[Lanes], BinaryOp op) -> A {
+				for (auto width = Lanes / 2; width != 0; width /= 2) {
+					for (size_t j = 0; j != width; ++j) {
+						lanes[j] = op(lanes[j], lanes[j + width]);
+					}
+				}
+				return lanes[0];
+			}
+
+			/// Accumulates \blocks whole blocks of Lanes elements into their lanes.
+			template<typename A, size_t Lanes, typename T>
+			void sum_lanes(A (&lanes)[Lanes], T const* data, size_t blocks) {
+				for (size_t b = 0; b != blocks; ++b, data += Lanes) {
+					for (size_t j = 0; j != Lanes; ++j) {
+						lanes[j] += static_cast<A>(data[j]);
+					}
+				}
+			}
+
+			/// Accumulates the elements [\first, \last) into their lanes.
+			/// \first must be a multiple of the lane count.
+			template<typename A, size_t Lanes, typename T>
+			void sum_tail(A (&lanes)[Lanes], T const* data, size_t first, size_t last) {
+				for (auto i = first; i != last; ++i) {
+					lanes[(i - first) % Lanes] += static_cast<A>(data[i]);
+				}
+			}
+
+			/// Returns \product. For float and double the value is passed through an
+			/// empty assembly statement which keeps the compiler from contracting
+			/// the multiplication with the following addition into an FMA.
+			template<typename A>
+			auto rounded(A product) -> A {
+				return product;
+			}
+
+#if defined(UTILS_SIMD_X86) && defined(__SSE2_MATH__)
+			inline auto rounded(float product) -> float {
+				__asm__("" : "+x"(product));
+				return product;
+			}
+
+			inline auto rounded(double product) -> double {
+				__asm__("" : "+x"(product));
+				return product;
+			}
+#endif
+
+			template<typename A, size_t Lanes, typename T>
+			void dot_lanes(A (&lanes)[Lanes], T const* lhs, T const* rhs, size_t blocks) {
+				for (size_t b = 0; b != blocks; ++b, lhs += Lanes, rhs += Lanes) {
+					for (size_t j = 0; j != Lanes; ++j) {
+						lanes[j] += rounded(static_cast<A>(lhs[j]) * static_cast<A>(rhs[j]));
+					}
+				}
+			}
+
+			template<typename A, size_t Lanes, typename T>
+			void dot_tail(A (&lanes)[Lanes], T const* lhs, T const* rhs, size_t first, size_t last) {
+				for (auto i = first; i != last; ++i) {
+					lanes[(i - first) % Lanes] += rounded(static_cast<A>(lhs[i]) * static_cast<A>(rhs[i]));
+				}
+			}
+
+			template<typename T, size_t Lanes>
+			void minmax_lanes(T (&mins)[Lanes], T (&maxs)[Lanes], T const* data, size_t blocks) {
+				for (size_t b = 0; b != blocks; ++b, data += Lanes) {
+					for (size_t j = 0; j != Lanes; ++j) {
+						mins[j] = min_op{}(mins[j], data[j]);
+						maxs[j] = max_op{}(maxs[j], data[j]);
+					}
+				}
+			}
+
+			template<typename T, size_t Lanes>
+			void minmax_tail(T (&mins)[Lanes], T (&maxs)[Lanes], T const* data, size_t first, size_t last) {
+				for (auto i = first; i != last; ++i) {
+					auto const lane = (i - first) % Lanes;
+					mins[lane] = min_op{}(mins[lane], data[i]);
+					maxs[lane] = max_op{}(maxs[lane], data[i]);
+				}
+			}
+
+			// Portable implementations used for all element types
+			// and as the scalar path of the vectorized ones.
+
+			/// Lane type of sum and dot: integers are accumulated unsigned so that they wrap around.
+			template<typename T>
+			using lane_t = std::conditional_t<std::is_integral<T>::value, std::uint64_t, accumulate_t<T>>;
+
+			template<typename T>
+			auto sum(T const* data, size_t size) -> accumulate_t<T> {
+				constexpr auto lane_total = lane_count<T>::value;
+				lane_t<T> lanes[lane_total] = {};
+				auto const blocks = size / lane_total;
+				sum_lanes(lanes, data, blocks);
+				sum_tail(lanes, data, blocks * lane_total, size);
+				return static_cast<accumulate_t<T>>(combine_lanes(lanes, [](lane_t<T> lhs, lane_t<T> rhs) { return lhs + rhs; }));
+			}
+
+			template<typename T>
+			auto dot(T const* lhs, T const* rhs, size_t size) -> accumulate_t<T> {
+				constexpr auto lane_total = lane_count<T>::value;
+				lane_t<T> lanes[lane_total] = {};
+				auto const blocks = size / lane_total;
+				dot_lanes(lanes, lhs, rhs, blocks);
+				dot_tail(lanes, lhs, rhs, blocks * lane_total, size);
+				return static_cast<accumulate_t<T>>(combine_lanes(lanes, [](lane_t<T> l, lane_t<T> r) { return l + r; }));
+			}
+
+			template<typename T>
+			auto minmax(T const* data, size_t size) -> std::pair<T, T> {
+				constexpr auto lane_total = lane_count<T>::value;
+				T mins[lane_total];
+				T maxs[lane_total];
+				std::fill(mins, mins + lane_total, data[0]);
+				std::fill(maxs, maxs + lane_total, data[0]);
+				auto const blocks = size / lane_total;
+				minmax_lanes(mins, maxs, data, blocks);
+				minmax_tail(mins, maxs, data, blocks * lane_total, size);
+				return {combine_lanes(mins, min_op{}), combine_lanes(maxs, max_op{})};
+			}
+
+			template<typename T>
+			auto find_equal(T const* data, size_t size, T const& value) -> size_t {
+				for (size_t i = 0; i != size; ++i) {
+					if (data[i] == value) {
+						return i;
+					}
+				}
+				return size;
+			}
+
+			inline void ensure_not_empty(size_t size, char const* algorithm) {
+				if (size == 0) {
+					using namespace std::string_literals;
+					throw std::invalid_argument{
+						"cannot compute "s + algorithm + " of an empty dynarray"};
+				}
+			}
+
+			/// Returns the position of the first NaN in \data or \size if there is none.
+			template<typename T>
+			auto find_nan(T const* data, size_t size, std::true_type) -> size_t {
+				using std::isnan;
+				return static_cast<size_t>(std::find_if(data, data + size, [](T value) { return isnan(value); }) - data);
+			}
+
+			template<typename T>
+			auto find_nan(T const*, size_t size, std::false_type) -> size_t {
+				return size;
+			}
+
+#if defined(UTILS_SIMD_X86)
+			// Kernels for float and double. Every kernel processes \blocks
+			// whole blocks of lane_count<T> elements and accumulates into
+			// the given lanes which are read at entry and written at exit.
+
+			struct sse2_tag {};
+			struct avx2_tag {};
+			struct avx512_tag {};
+
+		//============================================================
+		// SSE2
+		//============================================================
+
+			// The empty assembly statement materializes the rounded product
+			// and keeps the compiler from contracting the multiplication with
+			// the following addition into an FMA which would change the result.
+			UTILS_SIMD_TARGET("sse2")
+			inline auto mul_rounded(__m128 lhs, __m128 rhs) -> __m128 {
+				auto product = _mm_mul_ps(lhs, rhs);
+				__asm__("" : "+x"(product));
+				return product;
+			}
+
+			UTILS_SIMD_TARGET("sse2")
+			inline auto mul_rounded(__m128d lhs, __m128d rhs) -> __m128d {
+				auto product = _mm_mul_pd(lhs, rhs);
+				__asm__("" : "+x"(product));
+				return product;
+			}
+
+			UTILS_SIMD_TARGET("sse2")
+			inline void sum_blocks(sse2_tag, float const* data, size_t blocks, float * lanes) {
+				auto a0 = _mm_loadu_ps(lanes +  0), a1 = _mm_loadu_ps(lanes +  4);
+				auto a2 = _mm_loadu_ps(lanes +  8), a3 = _mm_loadu_ps(lanes + 12);
+				auto a4 = _mm_loadu_ps(lanes + 16), a5 = _mm_loadu_ps(lanes + 20);
+				auto a6 = _mm_loadu_ps(lanes + 24), a7 = _mm_loadu_ps(lanes + 28);
+				for (size_t b = 0; b != blocks; ++b, data += 32) {
+					a0 = _mm_add_ps(a0, _mm_loadu_ps(data +  0));
+					a1 = _mm_add_ps(a1, _mm_loadu_ps(data +  4));
+					a2 = _mm_add_ps(a2, _mm_loadu_ps(data +  8));
+					a3 = _mm_add_ps(a3, _mm_loadu_ps(data + 12));
+					a4 = _mm_add_ps(a4, _mm_loadu_ps(data + 16));
+					a5 = _mm_add_ps(a5, _mm_loadu_ps(data + 20));
+					a6 = _mm_add_ps(a6, _mm_loadu_ps(data + 24));
+					a7 = _mm_add_ps(a7, _mm_loadu_ps(data + 28));
+				}
+				_mm_storeu_ps(lanes +  0, a0); _mm_storeu_ps(lanes +  4, a1);
+				_mm_storeu_ps(lanes +  8, a2); _mm_storeu_ps(lanes + 12, a3);
+				_mm_storeu_ps(lanes + 16, a4); _mm_storeu_ps(lanes + 20, a5);
+				_mm_storeu_ps(lanes + 24, a6); _mm_storeu_ps(lanes + 28, a7);
+			}
+
+			UTILS_SIMD_TARGET("sse2")
+			inline void sum_blocks(sse2_tag, double const* data, size_t blocks, double * lanes) {
+				auto a0 = _mm_loadu_pd(lanes +  0), a1 = _mm_loadu_pd(lanes +  2);
+				auto a2 = _mm_loadu_pd(lanes +  4), a3 = _mm_loadu_pd(lanes +  6);
+				auto a4 = _mm_loadu_pd(lanes +  8), a5 = _mm_loadu_pd(lanes + 10);
+				auto a6 = _mm_loadu_pd(lanes + 12), a7 = _mm_loadu_pd(lanes + 14);
+				for (size_t b = 0; b != blocks; ++b, data += 16) {
+					a0 = _mm_add_pd(a0, _mm_loadu_pd(data +  0));
+					a1 = _mm_add_pd(a1, _mm_loadu_pd(data +  2));
+					a2 = _mm_add_pd(a2, _mm_loadu_pd(data +  4));
+					a3 = _mm_add_pd(a3, _mm_loadu_pd(data +  6));
+					a4 = _mm_add_pd(a4, _mm_loadu_pd(data +  8));
+					a5 = _mm_add_pd(a5, _mm_loadu_pd(data + 10));
+					a6 = _mm_add_pd(a6, _mm_loadu_pd(data + 12));
+					a7 = _mm_add_pd(a7, _mm_loadu_pd(data + 14));
+				}
+				_mm_storeu_pd(lanes +  0, a0); _mm_storeu_pd(lanes +  2, a1);
+				_mm_storeu_pd(lanes +  4, a2); _mm_storeu_pd(lanes +  6, a3);
+				_mm_storeu_pd(lanes +  8, a4); _mm_storeu_pd(lanes + 10, a5);
+				_mm_storeu_pd(lanes + 12, a6); _mm_storeu_pd(lanes + 14, a7);
+			}
+
+			UTILS_SIMD_TARGET("sse2")
+			inline void dot_blocks(sse2_tag, float const* lhs, float const* rhs, size_t blocks, float * lanes) {
+				auto a0 = _mm_loadu_ps(lanes +  0), a1 = _mm_loadu_ps(lanes +  4);
+				auto a2 = _mm_loadu_ps(lanes +  8), a3 = _mm_loadu_ps(lanes + 12);
+				auto a4 = _mm_loadu_ps(lanes + 16), a5 = _mm_loadu_ps(lanes + 20);
+				auto a6 = _mm_loadu_ps(lanes + 24), a7 = _mm_loadu_ps(lanes + 28);
+				for (size_t b = 0; b != blocks; ++b, lhs += 32, rhs += 32) {
+					a0 = _mm_add_ps(a0, mul_rounded(_mm_loadu_ps(lhs +  0), _mm_loadu_ps(rhs +  0)));
+					a1 = _mm_add_ps(a1, mul_rounded(_mm_loadu_ps(lhs +  4), _mm_loadu_ps(rhs +  4)));
+					a2 = _mm_add_ps(a2, mul_rounded(_mm_loadu_ps(lhs +  8), _mm_loadu_ps(rhs +  8)));
+					a3 = _mm_add_ps(a3, mul_rounded(_mm_loadu_ps(lhs + 12), _mm_loadu_ps(rhs + 12)));
+					a4 = _mm_add_ps(a4, mul_rounded(_mm_loadu_ps(lhs + 16), _mm_loadu_ps(rhs + 16)));
+					a5 = _mm_add_ps(a5, mul_rounded(_mm_loadu_ps(lhs + 20), _mm_loadu_ps(rhs + 20)));
+					a6 = _mm_add_ps(a6, mul_rounded(_mm_loadu_ps(lhs + 24), _mm_loadu_ps(rhs + 24)));
+					a7 = _mm_add_ps(a7, mul_rounded(_mm_loadu_ps(lhs + 28), _mm_loadu_ps(rhs + 28)));
+				}
+				_mm_storeu_ps(lanes +  0, a0); _mm_storeu_ps(lanes +  4, a1);
+				_mm_storeu_ps(lanes +  8, a2); _mm_storeu_ps(lanes + 12, a3);
+				_mm_storeu_ps(lanes + 16, a4); _mm_storeu_ps(lanes + 20, a5);
+				_mm_storeu_ps(lanes + 24, a6); _mm_storeu_ps(lanes + 28, a7);
+			}
+
+			UTILS_SIMD_TARGET("sse2")
+			inline void dot_blocks(sse2_tag, double const* lhs, double const* rhs, size_t blocks, double * lanes) {
+				auto a0 = _mm_loadu_pd(lanes +  0), a1 = _mm_loadu_pd(lanes +  2);
+				auto a2 = _mm_loadu_pd(lanes +  4), a3 = _mm_loadu_pd(lanes +  6);
+				auto a4 = _mm_loadu_pd(lanes +  8), a5 = _mm_loadu_pd(lanes + 10);
+				auto a6 = _mm_loadu_pd(lanes + 12), a7 = _mm_loadu_pd(lanes + 14);
+				for (size_t b = 0; b != blocks; ++b, lhs += 16, rhs += 16) {
+					a0 = _mm_add_pd(a0, mul_rounded(_mm_loadu_pd(lhs +  0), _mm_loadu_pd(rhs +  0)));
+					a1 = _mm_add_pd(a1, mul_rounded(_mm_loadu_pd(lhs +  2), _mm_loadu_pd(rhs +  2)));
+					a2 = _mm_add_pd(a2, mul_rounded(_mm_loadu_pd(lhs +  4), _mm_loadu_pd(rhs +  4)));
+					a3 = _mm_add_pd(a3, mul_rounded(_mm_loadu_pd(lhs +  6), _mm_loadu_pd(rhs +  6)));
+					a4 = _mm_add_pd(a4, mul_rounded(_mm_loadu_pd(lhs +  8), _mm_loadu_pd(rhs +  8)));
+					a5 = _mm_add_pd(a5, mul_rounded(_mm_loadu_pd(lhs + 10), _mm_loadu_pd(rhs + 10)));
+					a6 = _mm_add_pd(a6, mul_rounded(_mm_loadu_pd(lhs + 12), _mm_loadu_pd(rhs + 12)));
+					a7 = _mm_add_pd(a7, mul_rounded(_mm_loadu_pd(lhs + 14), _mm_loadu_pd(rhs + 14)));
+				}
+				_mm_storeu_pd(lanes +  0, a0); _mm_storeu_pd(lanes +  2, a1);
+				_mm_storeu_pd(lanes +  4, a2); _mm_storeu_pd(lanes +  6, a3);
+				_mm_storeu_pd(lanes +  8, a4); _mm_storeu_pd(lanes + 10, a5);
+				_mm_storeu_pd(lanes + 12, a6); _mm_storeu_pd(lanes + 14, a7);
+			}
+
+			UTILS_SIMD_TARGET("sse2")
+			inline void minmax_blocks(sse2_tag, float const* data, size_t blocks, float * mins, float * maxs) {
+				// Four registers per bound to stay within the eight
+				// registers available on 32-bit targets.
+				for (size_t half = 0; half != 2; ++half) {
+					auto const offset = half * 16;
+					auto n0 = _mm_loadu_ps(mins + offset +  0), x0 = _mm_loadu_ps(maxs + offset +  0);
+					auto n1 = _mm_loadu_ps(mins + offset +  4), x1 = _mm_loadu_ps(maxs + offset +  4);
+					auto n2 = _mm_loadu_ps(mins + offset +  8), x2 = _mm_loadu_ps(maxs + offset +  8);
+					auto n3 = _mm_loadu_ps(mins + offset + 12), x3 = _mm_loadu_ps(maxs + offset + 12);
+					auto it = data + offset;
+					for (size_t b = 0; b != blocks; ++b, it += 32) {
+						auto const v0 = _mm_loadu_ps(it +  0);
+						auto const v1 = _mm_loadu_ps(it +  4);
+						auto const v2 = _mm_loadu_ps(it +  8);
+						auto const v3 = _mm_loadu_ps(it + 12);
+						n0 = _mm_min_ps(n0, v0); x0 = _mm_max_ps(x0, v0);
+						n1 = _mm_min_ps(n1, v1); x1 = _mm_max_ps(x1, v1);
+						n2 = _mm_min_ps(n2, v2); x2 = _mm_max_ps(x2, v2);
+						n3 = _mm_min_ps(n3, v3); x3 = _mm_max_ps(x3, v3);
+					}
+					_mm_storeu_ps(mins + offset +  0, n0); _mm_storeu_ps(maxs + offset +  0, x0);
+					_mm_storeu_ps(mins + offset +  4, n1); _mm_storeu_ps(maxs + offset +  4, x1);
+					_mm_storeu_ps(mins + offset +  8, n2); _mm_storeu_ps(maxs + offset +  8, x2);
+					_mm_storeu_ps(mins + offset + 12, n3); _mm_storeu_ps(maxs + offset + 12, x3);
+				}
+			}
+
+			UTILS_SIMD_TARGET("sse2")
+			inline void minmax_blocks(sse2_tag, double const* data, size_t blocks, double * mins, double * maxs) {
+				for (size_t half = 0; half != 2; ++half) {
+					auto const offset = half * 8;
+					auto n0 = _mm_loadu_pd(mins + offset + 0), x0 = _mm_loadu_pd(maxs + offset + 0);
+					auto n1 = _mm_loadu_pd(mins + offset + 2), x1 = _mm_loadu_pd(maxs + offset + 2);
+					auto n2 = _mm_loadu_pd(mins + offset + 4), x2 = _mm_loadu_pd(maxs + offset + 4);
+					auto n3 = _mm_loadu_pd(mins + offset + 6), x3 = _mm_loadu_pd(maxs + offset + 6);
+					auto it = data + offset;
+					for (size_t b = 0; b != blocks; ++b, it += 16) {
+						auto const v0 = _mm_loadu_pd(it + 0);
+						auto const v1 = _mm_loadu_pd(it + 2);
+						auto const v2 = _mm_loadu_pd(it + 4);
+						auto const v3 = _mm_loadu_pd(it + 6);
+						n0 = _mm_min_pd(n0, v0); x0 = _mm_max_pd(x0, v0);
+						n1 = _mm_min_pd(n1, v1); x1 = _mm_max_pd(x1, v1);
+						n2 = _mm_min_pd(n2, v2); x2 = _mm_max_pd(x2, v2);
+						n3 = _mm_min_pd(n3, v3); x3 = _mm_max_pd(x3, v3);
+					}
+					_mm_storeu_pd(mins + offset + 0, n0); _mm_storeu_pd(maxs + offset + 0, x0);
+					_mm_storeu_pd(mins + offset + 2, n1); _mm_storeu_pd(maxs + offset + 2, x1);
+					_mm_storeu_pd(mins + offset + 4, n2); _mm_storeu_pd(maxs + offset + 4, x2);
+					_mm_storeu_pd(mins + offset + 6, n3); _mm_storeu_pd(maxs + offset + 6, x3);
+				}
+			}
+
+			UTILS_SIMD_TARGET("sse2")
+			inline auto find_equal(sse2_tag, float const* data, size_t size, float value) -> size_t {
+				auto const needle = _mm_set1_ps(value);
+				size_t i = 0;
+				for (; i + 4 <= size; i += 4) {
+					auto const mask = _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(data + i), needle));
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+					}
+				}
+				return i + find_equal(data + i, size - i, value);
+			}
+
+			UTILS_SIMD_TARGET("sse2")
+			inline auto find_equal(sse2_tag, double const* data, size_t size, double value) -> size_t {
+				auto const needle = _mm_set1_pd(value);
+				size_t i = 0;
+				for (; i + 2 <= size; i += 2) {
+					auto const mask = _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(data + i), needle));
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+					}
+				}
+				return i + find_equal(data + i, size - i, value);
+			}
+
+		//============================================================
+		// AVX2
+		//============================================================
+
+			UTILS_SIMD_TARGET("avx2")
+			inline auto mul_rounded(__m256 lhs, __m256 rhs) -> __m256 {
+				auto product = _mm256_mul_ps(lhs, rhs);
+				__asm__("" : "+x"(product));
+				return product;
+			}
+
+			UTILS_SIMD_TARGET("avx2")
+			inline auto mul_rounded(__m256d lhs, __m256d rhs) -> __m256d {
+				auto product = _mm256_mul_pd(lhs, rhs);
+				__asm__("" : "+x"(product));
+				return product;
+			}
+
+			UTILS_SIMD_TARGET("avx2")
+			inline void sum_blocks(avx2_tag, float const* data, size_t blocks, float * lanes) {
+				auto a0 = _mm256_loadu_ps(lanes +  0), a1 = _mm256_loadu_ps(lanes +  8);
+				auto a2 = _mm256_loadu_ps(lanes + 16), a3 = _mm256_loadu_ps(lanes + 24);
+				for (size_t b = 0; b != blocks; ++b, data += 32) {
+					a0 = _mm256_add_ps(a0, _mm256_loadu_ps(data +  0));
+					a1 = _mm256_add_ps(a1, _mm256_loadu_ps(data +  8));
+					a2 = _mm256_add_ps(a2, _mm256_loadu_ps(data + 16));
+					a3 = _mm256_add_ps(a3, _mm256_loadu_ps(data + 24));
+				}
+				_mm256_storeu_ps(lanes +  0, a0); _mm256_storeu_ps(lanes +  8, a1);
+				_mm256_storeu_ps(lanes + 16, a2); _mm256_storeu_ps(lanes + 24, a3);
+			}
+
+			UTILS_SIMD_TARGET("avx2")
+			inline void sum_blocks(avx2_tag, double const* data, size_t blocks, double * lanes) {
+				auto a0 = _mm256_loadu_pd(lanes + 0), a1 = _mm256_loadu_pd(lanes +  4);
+				auto a2 = _mm256_loadu_pd(lanes + 8), a3 = _mm256_loadu_pd(lanes + 12);
+				for (size_t b = 0; b != blocks; ++b, data += 16) {
+					a0 = _mm256_add_pd(a0, _mm256_loadu_pd(data +  0));
+					a1 = _mm256_add_pd(a1, _mm256_loadu_pd(data +  4));
+					a2 = _mm256_add_pd(a2, _mm256_loadu_pd(data +  8));
+					a3 = _mm256_add_pd(a3, _mm256_loadu_pd(data + 12));
+				}
+				_mm256_storeu_pd(lanes + 0, a0); _mm256_storeu_pd(lanes +  4, a1);
+				_mm256_storeu_pd(lanes + 8, a2); _mm256_storeu_pd(lanes + 12, a3);
+			}
+
+			UTILS_SIMD_TARGET("avx2")
+			inline void dot_blocks(avx2_tag, float const* lhs, float const* rhs, size_t blocks, float * lanes) {
+				auto a0 = _mm256_loadu_ps(lanes +  0), a1 = _mm256_loadu_ps(lanes +  8);
+				auto a2 = _mm256_loadu_ps(lanes + 16), a3 = _mm256_loadu_ps(lanes + 24);
+				for (size_t b = 0; b != blocks; ++b, lhs += 32, rhs += 32) {
+					a0 = _mm256_add_ps(a0, mul_rounded(_mm256_loadu_ps(lhs +  0), _mm256_loadu_ps(rhs +  0)));
+					a1 = _mm256_add_ps(a1, mul_rounded(_mm256_loadu_ps(lhs +  8), _mm256_loadu_ps(rhs +  8)));
+					a2 = _mm256_add_ps(a2, mul_rounded(_mm256_loadu_ps(lhs + 16), _mm256_loadu_ps(rhs + 16)));
+					a3 = _mm256_add_ps(a3, mul_rounded(_mm256_loadu_ps(lhs + 24), _mm256_loadu_ps(rhs + 24)));
+				}
+				_mm256_storeu_ps(lanes +  0, a0); _mm256_storeu_ps(lanes +  8, a1);
+				_mm256_storeu_ps(lanes + 16, a2); _mm256_storeu_ps(lanes + 24, a3);
+			}
+
+			UTILS_SIMD_TARGET("avx2")
+			inline void dot_blocks(avx2_tag, double const* lhs, double const* rhs, size_t blocks, double * lanes) {
+				auto a0 = _mm256_loadu_pd(lanes + 0), a1 = _mm256_loadu_pd(lanes +  4);
+				auto a2 = _mm256_loadu_pd(lanes + 8), a3 = _mm256_loadu_pd(lanes + 12);
+				for (size_t b = 0; b != blocks; ++b, lhs += 16, rhs += 16) {
+					a0 = _mm256_add_pd(a0, mul_rounded(_mm256_loadu_pd(lhs +  0), _mm256_loadu_pd(rhs +  0)));
+					a1 = _mm256_add_pd(a1, mul_rounded(_mm256_loadu_pd(lhs +  4), _mm256_loadu_pd(rhs +  4)));
+					a2 = _mm256_add_pd(a2, mul_rounded(_mm256_loadu_pd(lhs +  8), _mm256_loadu_pd(rhs +  8)));
+					a3 = _mm256_add_pd(a3, mul_rounded(_mm256_loadu_pd(lhs + 12), _mm256_loadu_pd(rhs + 12)));
+				}
+				_mm256_storeu_pd(lanes + 0, a0); _mm256_storeu_pd(lanes +  4, a1);
+				_mm256_storeu_pd(lanes + 8, a2); _mm256_storeu_pd(lanes + 12, a3);
+			}
+
+			UTILS_SIMD_TARGET("avx2")
+			inline void minmax_blocks(avx2_tag, float const* data, size_t blocks, float * mins, float * maxs) {
+				auto n0 = _mm256_loadu_ps(mins +  0), x0 = _mm256_loadu_ps(maxs +  0);
+				auto n1 = _mm256_loadu_ps(mins +  8), x1 = _mm256_loadu_ps(maxs +  8);
+				auto n2 = _mm256_loadu_ps(mins + 16), x2 = _mm256_loadu_ps(maxs + 16);
+				auto n3 = _mm256_loadu_ps(mins + 24), x3 = _mm256_loadu_ps(maxs + 24);
+				for (size_t b = 0; b != blocks; ++b, data += 32) {
+					auto const v0 = _mm256_loadu_ps(data +  0);
+					auto const v1 = _mm256_loadu_ps(data +  8);
+					auto const v2 = _mm256_loadu_ps(data + 16);
+					auto const v3 = _mm256_loadu_ps(data + 24);
+					n0 = _mm256_min_ps(n0, v0); x0 = _mm256_max_ps(x0, v0);
+					n1 = _mm256_min_ps(n1, v1); x1 = _mm256_max_ps(x1, v1);
+					n2 = _mm256_min_ps(n2, v2); x2 = _mm256_max_ps(x2, v2);
+					n3 = _mm256_min_ps(n3, v3); x3 = _mm256_max_ps(x3, v3);
+				}
+				_mm256_storeu_ps(mins +  0, n0); _mm256_storeu_ps(maxs +  0, x0);
+				_mm256_storeu_ps(mins +  8, n1); _mm256_storeu_ps(maxs +  8, x1);
+				_mm256_storeu_ps(mins + 16, n2); _mm256_storeu_ps(maxs + 16, x2);
+				_mm256_storeu_ps(mins + 24, n3); _mm256_storeu_ps(maxs + 24, x3);
+			}
+
+			UTILS_SIMD_TARGET("avx2")
+			inline void minmax_blocks(avx2_tag, double const* data, size_t blocks, double * mins, double * maxs) {
+				auto n0 = _mm256_loadu_pd(mins + 0), x0 = _mm256_loadu_pd(maxs +  0);
+				auto n1 = _mm256_loadu_pd(mins + 4), x1 = _mm256_loadu_pd(maxs +  4);
+				auto n2 = _mm256_loadu_pd(mins + 8), x2 = _mm256_loadu_pd(maxs +  8);
+				auto n3 = _mm256_loadu_pd(mins + 12), x3 = _mm256_loadu_pd(maxs + 12);
+				for (size_t b = 0; b != blocks; ++b, data += 16) {
+					auto const v0 = _mm256_loadu_pd(data +  0);
+					auto const v1 = _mm256_loadu_pd(data +  4);
+					auto const v2 = _mm256_loadu_pd(data +  8);
+					auto const v3 = _mm256_loadu_pd(data + 12);
+					n0 = _mm256_min_pd(n0, v0); x0 = _mm256_max_pd(x0, v0);
+					n1 = _mm256_min_pd(n1, v1); x1 = _mm256_max_pd(x1, v1);
+					n2 = _mm256_min_pd(n2, v2); x2 = _mm256_max_pd(x2, v2);
+					n3 = _mm256_min_pd(n3, v3); x3 = _mm256_max_pd(x3, v3);
+				}
+				_mm256_storeu_pd(mins + 0, n0); _mm256_storeu_pd(maxs +  0, x0);
+				_mm256_storeu_pd(mins + 4, n1); _mm256_storeu_pd(maxs +  4, x1);
+				_mm256_storeu_pd(mins + 8, n2); _mm256_storeu_pd(maxs +  8, x2);
+				_mm256_storeu_pd(mins + 12, n3); _mm256_storeu_pd(maxs + 12, x3);
+			}
+
+			UTILS_SIMD_TARGET("avx2")
+			inline auto find_equal(avx2_tag, float const* data, size_t size, float value) -> size_t {
+				auto const needle = _mm256_set1_ps(value);
+				size_t i = 0;
+				for (; i + 8 <= size; i += 8) {
+					auto const mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(data + i), needle, _CMP_EQ_OQ));
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+					}
+				}
+				return i + find_equal(data + i, size - i, value);
+			}
+
+			UTILS_SIMD_TARGET("avx2")
+			inline auto find_equal(avx2_tag, double const* data, size_t size, double value) -> size_t {
+				auto const needle = _mm256_set1_pd(value);
+				size_t i = 0;
+				for (; i + 4 <= size; i += 4) {
+					auto const mask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(data + i), needle, _CMP_EQ_OQ));
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+					}
+				}
+				return i + find_equal(data + i, size - i, value);
+			}
+
+		//============================================================
+		// AVX-512
+		//============================================================
+
+			// Helpers for the AVX-512 kernels. They use the masked intrinsics
+			// with an all-ones mask since the unmasked ones pass an undefined
+			// vector that GCC reports as maybe-uninitialized under -Wall.
+
+			// The explicitly rounded multiplication cannot be contracted.
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto mul_rounded(__m512 lhs, __m512 rhs) -> __m512 {
+				return _mm512_mask_mul_round_ps(lhs, static_cast<__mmask16>(0xFFFF), lhs, rhs, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			}
+
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto mul_rounded(__m512d lhs, __m512d rhs) -> __m512d {
+				return _mm512_mask_mul_round_pd(lhs, static_cast<__mmask8>(0xFF), lhs, rhs, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			}
+
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto min512(__m512 acc, __m512 value) -> __m512 {
+				return _mm512_mask_min_ps(acc, static_cast<__mmask16>(0xFFFF), acc, value);
+			}
+
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto min512(__m512d acc, __m512d value) -> __m512d {
+				return _mm512_mask_min_pd(acc, static_cast<__mmask8>(0xFF), acc, value);
+			}
+
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto max512(__m512 acc, __m512 value) -> __m512 {
+				return _mm512_mask_max_ps(acc, static_cast<__mmask16>(0xFFFF), acc, value);
+			}
+
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto max512(__m512d acc, __m512d value) -> __m512d {
+				return _mm512_mask_max_pd(acc, static_cast<__mmask8>(0xFF), acc, value);
+			}
+
+			UTILS_SIMD_TARGET("avx512f")
+			inline void sum_blocks(avx512_tag, float const* data, size_t blocks, float * lanes) {
+				auto a0 = _mm512_loadu_ps(lanes), a1 = _mm512_loadu_ps(lanes + 16);
+				for (size_t b = 0; b != blocks; ++b, data += 32) {
+					a0 = _mm512_add_ps(a0, _mm512_loadu_ps(data +  0));
+					a1 = _mm512_add_ps(a1, _mm512_loadu_ps(data + 16));
+				}
+				_mm512_storeu_ps(lanes, a0); _mm512_storeu_ps(lanes + 16, a1);
+			}
+
+			UTILS_SIMD_TARGET("avx512f")
+			inline void sum_blocks(avx512_tag, double const* data, size_t blocks, double * lanes) {
+				auto a0 = _mm512_loadu_pd(lanes), a1 = _mm512_loadu_pd(lanes + 8);
+				for (size_t b = 0; b != blocks; ++b, data += 16) {
+					a0 = _mm512_add_pd(a0, _mm512_loadu_pd(data + 0));
+					a1 = _mm512_add_pd(a1, _mm512_loadu_pd(data + 8));
+				}
+				_mm512_storeu_pd(lanes, a0); _mm512_storeu_pd(lanes + 8, a1);
+			}
+
+			UTILS_SIMD_TARGET("avx512f")
+			inline void dot_blocks(avx512_tag, float const* lhs, float const* rhs, size_t blocks, float * lanes) {
+				auto a0 = _mm512_loadu_ps(lanes), a1 = _mm512_loadu_ps(lanes + 16);
+				for (size_t b = 0; b != blocks; ++b, lhs += 32, rhs += 32) {
+					a0 = _mm512_add_ps(a0, mul_rounded(_mm512_loadu_ps(lhs +  0), _mm512_loadu_ps(rhs +  0)));
+					a1 = _mm512_add_ps(a1, mul_rounded(_mm512_loadu_ps(lhs + 16), _mm512_loadu_ps(rhs + 16)));
+				}
+				_mm512_storeu_ps(lanes, a0); _mm512_storeu_ps(lanes + 16, a1);
+			}
+
+			UTILS_SIMD_TARGET("avx512f")
+			inline void dot_blocks(avx512_tag, double const* lhs, double const* rhs, size_t blocks, double * lanes) {
+				auto a0 = _mm512_loadu_pd(lanes), a1 = _mm512_loadu_pd(lanes + 8);
+				for (size_t b = 0; b != blocks; ++b, lhs += 16, rhs += 16) {
+					a0 = _mm512_add_pd(a0, mul_rounded(_mm512_loadu_pd(lhs + 0), _mm512_loadu_pd(rhs + 0)));
+					a1 = _mm512_add_pd(a1, mul_rounded(_mm512_loadu_pd(lhs + 8), _mm512_loadu_pd(rhs + 8)));
+				}
+				_mm512_storeu_pd(lanes, a0); _mm512_storeu_pd(lanes + 8, a1);
+			}
+
+			UTILS_SIMD_TARGET("avx512f")
+			inline void minmax_blocks(avx512_tag, float const* data, size_t blocks, float * mins, float * maxs) {
+				auto n0 = _mm512_loadu_ps(mins), x0 = _mm512_loadu_ps(maxs);
+				auto n1 = _mm512_loadu_ps(mins + 16), x1 = _mm512_loadu_ps(maxs + 16);
+				for (size_t b = 0; b != blocks; ++b, data += 32) {
+					auto const v0 = _mm512_loadu_ps(data +  0);
+					auto const v1 = _mm512_loadu_ps(data + 16);
+					n0 = min512(n0, v0); x0 = max512(x0, v0);
+					n1 = min512(n1, v1); x1 = max512(x1, v1);
+				}
+				_mm512_storeu_ps(mins, n0); _mm512_storeu_ps(maxs, x0);
+				_mm512_storeu_ps(mins + 16, n1); _mm512_storeu_ps(maxs + 16, x1);
+			}
+
+			UTILS_SIMD_TARGET("avx512f")
+			inline void minmax_blocks(avx512_tag, double const* data, size_t blocks, double * mins, double * maxs) {
+				auto n0 = _mm512_loadu_pd(mins), x0 = _mm512_loadu_pd(maxs);
+				auto n1 = _mm512_loadu_pd(mins + 8), x1 = _mm512_loadu_pd(maxs + 8);
+				for (size_t b = 0; b != blocks; ++b, data += 16) {
+					auto const v0 = _mm512_loadu_pd(data + 0);
+					auto const v1 = _mm512_loadu_pd(data + 8);
+					n0 = min512(n0, v0); x0 = max512(x0, v0);
+					n1 = min512(n1, v1); x1 = max512(x1, v1);
+				}
+				_mm512_storeu_pd(mins, n0); _mm512_storeu_pd(maxs, x0);
+				_mm512_storeu_pd(mins + 8, n1); _mm512_storeu_pd(maxs + 8, x1);
+			}
+
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto find_equal(avx512_tag, float const* data, size_t size, float value) -> size_t {
+				auto const needle = _mm512_set1_ps(value);
+				size_t i = 0;
+				for (; i + 16 <= size; i += 16) {
+					auto const mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(data + i), needle, _CMP_EQ_OQ);
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+					}
+				}
+				return i + find_equal(data + i, size - i, value);
+			}
+
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto find_equal(avx512_tag, double const* data, size_t size, double value) -> size_t {
+				auto const needle = _mm512_set1_pd(value);
+				size_t i = 0;
+				for (; i + 8 <= size; i += 8) {
+					auto const mask = _mm512_cmp_pd_mask(_mm512_loadu_pd(data + i), needle, _CMP_EQ_OQ);
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+					}
+				}
+				return i + find_equal(data + i, size - i, value);
+			}
+
+		//============================================================
+		// Integer kernels
+		//============================================================
+
+			// Kernels for 32-bit and 64-bit integers. Since their results do not
+			// depend on the order of the elements every kernel processes the
+			// whole range and finishes the last partial vector in scalar code.
+			// Sums are widened to 64 bits and wrap around like unsigned integers.
+
+			template<typename T>
+			using width_tag = std::integral_constant<size_t, sizeof(T)>;
+
+			/// Adds the elements [\first, \last) to the 64-bit \total and returns it as accumulate_t<T>.
+			template<typename T>
+			auto finish_sum(std::uint64_t total, T const* data, size_t first, size_t last) -> accumulate_t<T> {
+				for (auto i = first; i != last; ++i) {
+					total += static_cast<std::uint64_t>(static_cast<accumulate_t<T>>(data[i]));
+				}
+				return static_cast<accumulate_t<T>>(total);
+			}
+
+			/// Reduces the \lanes bounds and the elements [\first, \last) to the overall bounds.
+			template<typename T, size_t Lanes>
+			auto finish_minmax(T (&mins)[Lanes], T (&maxs)[Lanes], T const* data, size_t first, size_t last)
+				-> std::pair<T, T>
+			{
+				auto result = std::make_pair(*std::min_element(mins, mins + Lanes), *std::max_element(maxs, maxs + Lanes));
+				for (auto i = first; i != last; ++i) {
+					result.first  = std::min(result.first,  data[i]);
+					result.second = std::max(result.second, data[i]);
+				}
+				return result;
+			}
+
+			/// Bias that maps the order of unsigned integers to the order of signed integers.
+			template<typename T>
+			constexpr auto sign_bias() -> long long {
+				return std::is_signed<T>::value ? 0 :
+					sizeof(T) == 4 ? std::numeric_limits<int>::min() : std::numeric_limits<long long>::min();
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("sse2")
+			inline auto sum_integers(sse2_tag, T const* data, size_t size, width_tag<std::int32_t>) -> accumulate_t<T> {
+				auto a0 = _mm_setzero_si128(), a1 = _mm_setzero_si128();
+				auto a2 = _mm_setzero_si128(), a3 = _mm_setzero_si128();
+				size_t i = 0;
+				for (; i + 8 <= size; i += 8) {
+					auto const v0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i));
+					auto const v1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i + 4));
+					// The upper halves of the 64-bit lanes hold the sign or zero extension.
+					auto const h0 = std::is_signed<T>::value ? _mm_srai_epi32(v0, 31) : _mm_setzero_si128();
+					auto const h1 = std::is_signed<T>::value ? _mm_srai_epi32(v1, 31) : _mm_setzero_si128();
+					a0 = _mm_add_epi64(a0, _mm_unpacklo_epi32(v0, h0));
+					a1 = _mm_add_epi64(a1, _mm_unpackhi_epi32(v0, h0));
+					a2 = _mm_add_epi64(a2, _mm_unpacklo_epi32(v1, h1));
+					a3 = _mm_add_epi64(a3, _mm_unpackhi_epi32(v1, h1));
+				}
+				std::uint64_t lanes[2];
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes),
+					_mm_add_epi64(_mm_add_epi64(a0, a1), _mm_add_epi64(a2, a3)));
+				return finish_sum(lanes[0] + lanes[1], data, i, size);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("sse2")
+			inline auto sum_integers(sse2_tag, T const* data, size_t size, width_tag<std::int64_t>) -> accumulate_t<T> {
+				auto a0 = _mm_setzero_si128(), a1 = _mm_setzero_si128();
+				auto a2 = _mm_setzero_si128(), a3 = _mm_setzero_si128();
+				size_t i = 0;
+				for (; i + 8 <= size; i += 8) {
+					auto const it = reinterpret_cast<__m128i const*>(data + i);
+					a0 = _mm_add_epi64(a0, _mm_loadu_si128(it + 0));
+					a1 = _mm_add_epi64(a1, _mm_loadu_si128(it + 1));
+					a2 = _mm_add_epi64(a2, _mm_loadu_si128(it + 2));
+					a3 = _mm_add_epi64(a3, _mm_loadu_si128(it + 3));
+				}
+				std::uint64_t lanes[2];
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes),
+					_mm_add_epi64(_mm_add_epi64(a0, a1), _mm_add_epi64(a2, a3)));
+				return finish_sum(lanes[0] + lanes[1], data, i, size);
+			}
+
+			/// Selects the lanes of \rhs where \mask is set and the lanes of \lhs otherwise.
+			UTILS_SIMD_TARGET("sse2")
+			inline auto select128(__m128i mask, __m128i rhs, __m128i lhs) -> __m128i {
+				return _mm_or_si128(_mm_and_si128(mask, rhs), _mm_andnot_si128(mask, lhs));
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("sse2")
+			inline auto minmax_integers(sse2_tag, T const* data, size_t size, width_tag<std::int32_t>) -> std::pair<T, T> {
+				// SSE2 only compares signed integers: the sign bits of unsigned ones are flipped.
+				auto const bias = _mm_set1_epi32(static_cast<int>(sign_bias<T>()));
+				auto const first = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(data[0])), bias);
+				auto n0 = first, n1 = first, x0 = first, x1 = first;
+				size_t i = 0;
+				for (; i + 8 <= size; i += 8) {
+					auto const v0 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i)), bias);
+					auto const v1 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i + 4)), bias);
+					n0 = select128(_mm_cmpgt_epi32(n0, v0), v0, n0);
+					n1 = select128(_mm_cmpgt_epi32(n1, v1), v1, n1);
+					x0 = select128(_mm_cmpgt_epi32(v0, x0), v0, x0);
+					x1 = select128(_mm_cmpgt_epi32(v1, x1), v1, x1);
+				}
+				T mins[8];
+				T maxs[8];
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(mins + 0), _mm_xor_si128(n0, bias));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(mins + 4), _mm_xor_si128(n1, bias));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(maxs + 0), _mm_xor_si128(x0, bias));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(maxs + 4), _mm_xor_si128(x1, bias));
+				return finish_minmax(mins, maxs, data, i, size);
+			}
+
+			/// SSE2 has no 64-bit comparisons.
+			template<typename T>
+			inline auto minmax_integers(sse2_tag, T const* data, size_t size, width_tag<std::int64_t>) -> std::pair<T, T> {
+				return detail::minmax(data, size);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("sse2")
+			inline auto find_integer(sse2_tag, T const* data, size_t size, T value, width_tag<std::int32_t>) -> size_t {
+				auto const needle = _mm_set1_epi32(static_cast<int>(value));
+				size_t i = 0;
+				for (; i + 4 <= size; i += 4) {
+					auto const equal = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i)), needle);
+					auto const mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+					}
+				}
+				return i + find_equal(data + i, size - i, value);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("sse2")
+			inline auto find_integer(sse2_tag, T const* data, size_t size, T value, width_tag<std::int64_t>) -> size_t {
+				auto const needle = _mm_set1_epi64x(static_cast<long long>(value));
+				size_t i = 0;
+				for (; i + 2 <= size; i += 2) {
+					// A 64-bit lane is equal if both of its 32-bit halves are.
+					auto const halves = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i)), needle);
+					auto const equal = _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+					auto const mask = _mm_movemask_pd(_mm_castsi128_pd(equal));
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+					}
+				}
+				return i + find_equal(data + i, size - i, value);
+			}
+
+			/// Loads four 32-bit integers at \it and sign or zero extends them to 64 bits.
+			template<typename T>
+			UTILS_SIMD_TARGET("avx2")
+			inline auto widen256(T const* it) -> __m256i {
+				auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(it));
+				return std::is_signed<T>::value ? _mm256_cvtepi32_epi64(v) : _mm256_cvtepu32_epi64(v);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx2")
+			inline auto sum_integers(avx2_tag, T const* data, size_t size, width_tag<std::int32_t>) -> accumulate_t<T> {
+				auto a0 = _mm256_setzero_si256(), a1 = _mm256_setzero_si256();
+				auto a2 = _mm256_setzero_si256(), a3 = _mm256_setzero_si256();
+				size_t i = 0;
+				for (; i + 16 <= size; i += 16) {
+					a0 = _mm256_add_epi64(a0, widen256(data + i +  0));
+					a1 = _mm256_add_epi64(a1, widen256(data + i +  4));
+					a2 = _mm256_add_epi64(a2, widen256(data + i +  8));
+					a3 = _mm256_add_epi64(a3, widen256(data + i + 12));
+				}
+				std::uint64_t lanes[4];
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes),
+					_mm256_add_epi64(_mm256_add_epi64(a0, a1), _mm256_add_epi64(a2, a3)));
+				return finish_sum(lanes[0] + lanes[1] + lanes[2] + lanes[3], data, i, size);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx2")
+			inline auto sum_integers(avx2_tag, T const* data, size_t size, width_tag<std::int64_t>) -> accumulate_t<T> {
+				auto a0 = _mm256_setzero_si256(), a1 = _mm256_setzero_si256();
+				auto a2 = _mm256_setzero_si256(), a3 = _mm256_setzero_si256();
+				size_t i = 0;
+				for (; i + 16 <= size; i += 16) {
+					auto const it = reinterpret_cast<__m256i const*>(data + i);
+					a0 = _mm256_add_epi64(a0, _mm256_loadu_si256(it + 0));
+					a1 = _mm256_add_epi64(a1, _mm256_loadu_si256(it + 1));
+					a2 = _mm256_add_epi64(a2, _mm256_loadu_si256(it + 2));
+					a3 = _mm256_add_epi64(a3, _mm256_loadu_si256(it + 3));
+				}
+				std::uint64_t lanes[4];
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes),
+					_mm256_add_epi64(_mm256_add_epi64(a0, a1), _mm256_add_epi64(a2, a3)));
+				return finish_sum(lanes[0] + lanes[1] + lanes[2] + lanes[3], data, i, size);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx2")
+			inline auto min256(__m256i lhs, __m256i rhs) -> __m256i {
+				return std::is_signed<T>::value ? _mm256_min_epi32(lhs, rhs) : _mm256_min_epu32(lhs, rhs);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx2")
+			inline auto max256(__m256i lhs, __m256i rhs) -> __m256i {
+				return std::is_signed<T>::value ? _mm256_max_epi32(lhs, rhs) : _mm256_max_epu32(lhs, rhs);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx2")
+			inline auto minmax_integers(avx2_tag, T const* data, size_t size, width_tag<std::int32_t>) -> std::pair<T, T> {
+				auto const first = _mm256_set1_epi32(static_cast<int>(data[0]));
+				auto n0 = first, n1 = first, x0 = first, x1 = first;
+				size_t i = 0;
+				for (; i + 16 <= size; i += 16) {
+					auto const v0 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i));
+					auto const v1 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i + 8));
+					n0 = min256<T>(n0, v0); x0 = max256<T>(x0, v0);
+					n1 = min256<T>(n1, v1); x1 = max256<T>(x1, v1);
+				}
+				T mins[16];
+				T maxs[16];
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(mins + 0), n0);
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(mins + 8), n1);
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(maxs + 0), x0);
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(maxs + 8), x1);
+				return finish_minmax(mins, maxs, data, i, size);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx2")
+			inline auto minmax_integers(avx2_tag, T const* data, size_t size, width_tag<std::int64_t>) -> std::pair<T, T> {
+				// AVX2 only compares signed 64-bit integers: the sign bits of unsigned ones are flipped.
+				auto const bias = _mm256_set1_epi64x(sign_bias<T>());
+				auto const first = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(data[0])), bias);
+				auto n0 = first, n1 = first, x0 = first, x1 = first;
+				size_t i = 0;
+				for (; i + 8 <= size; i += 8) {
+					auto const v0 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i)), bias);
+					auto const v1 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i + 4)), bias);
+					n0 = _mm256_blendv_epi8(n0, v0, _mm256_cmpgt_epi64(n0, v0));
+					n1 = _mm256_blendv_epi8(n1, v1, _mm256_cmpgt_epi64(n1, v1));
+					x0 = _mm256_blendv_epi8(x0, v0, _mm256_cmpgt_epi64(v0, x0));
+					x1 = _mm256_blendv_epi8(x1, v1, _mm256_cmpgt_epi64(v1, x1));
+				}
+				T mins[8];
+				T maxs[8];
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(mins + 0), _mm256_xor_si256(n0, bias));
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(mins + 4), _mm256_xor_si256(n1, bias));
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(maxs + 0), _mm256_xor_si256(x0, bias));
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(maxs + 4), _mm256_xor_si256(x1, bias));
+				return finish_minmax(mins, maxs, data, i, size);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx2")
+			inline auto find_integer(avx2_tag, T const* data, size_t size, T value, width_tag<std::int32_t>) -> size_t {
+				auto const needle = _mm256_set1_epi32(static_cast<int>(value));
+				size_t i = 0;
+				for (; i + 8 <= size; i += 8) {
+					auto const equal = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i)), needle);
+					auto const mask = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+					}
+				}
+				return i + find_equal(data + i, size - i, value);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx2")
+			inline auto find_integer(avx2_tag, T const* data, size_t size, T value, width_tag<std::int64_t>) -> size_t {
+				auto const needle = _mm256_set1_epi64x(static_cast<long long>(value));
+				size_t i = 0;
+				for (; i + 4 <= size; i += 4) {
+					auto const equal = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i)), needle);
+					auto const mask = _mm256_movemask_pd(_mm256_castsi256_pd(equal));
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+					}
+				}
+				return i + find_equal(data + i, size - i, value);
+			}
+
+			/// Loads eight 32-bit integers at \it and sign or zero extends them to 64 bits.
+			template<typename T>
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto widen512(T const* it) -> __m512i {
+				auto const v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(it));
+				auto const all = static_cast<__mmask8>(0xFF);
+				return std::is_signed<T>::value ? _mm512_maskz_cvtepi32_epi64(all, v) : _mm512_maskz_cvtepu32_epi64(all, v);
+			}
+
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto reduce_add512(__m512i a0, __m512i a1, __m512i a2, __m512i a3) -> std::uint64_t {
+				std::uint64_t lanes[8];
+				_mm512_storeu_si512(lanes, _mm512_add_epi64(_mm512_add_epi64(a0, a1), _mm512_add_epi64(a2, a3)));
+				return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto sum_integers(avx512_tag, T const* data, size_t size, width_tag<std::int32_t>) -> accumulate_t<T> {
+				auto a0 = _mm512_setzero_si512(), a1 = _mm512_setzero_si512();
+				auto a2 = _mm512_setzero_si512(), a3 = _mm512_setzero_si512();
+				size_t i = 0;
+				for (; i + 32 <= size; i += 32) {
+					a0 = _mm512_add_epi64(a0, widen512(data + i +  0));
+					a1 = _mm512_add_epi64(a1, widen512(data + i +  8));
+					a2 = _mm512_add_epi64(a2, widen512(data + i + 16));
+					a3 = _mm512_add_epi64(a3, widen512(data + i + 24));
+				}
+				return finish_sum(reduce_add512(a0, a1, a2, a3), data, i, size);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto sum_integers(avx512_tag, T const* data, size_t size, width_tag<std::int64_t>) -> accumulate_t<T> {
+				auto a0 = _mm512_setzero_si512(), a1 = _mm512_setzero_si512();
+				auto a2 = _mm512_setzero_si512(), a3 = _mm512_setzero_si512();
+				size_t i = 0;
+				for (; i + 32 <= size; i += 32) {
+					a0 = _mm512_add_epi64(a0, _mm512_loadu_si512(data + i +  0));
+					a1 = _mm512_add_epi64(a1, _mm512_loadu_si512(data + i +  8));
+					a2 = _mm512_add_epi64(a2, _mm512_loadu_si512(data + i + 16));
+					a3 = _mm512_add_epi64(a3, _mm512_loadu_si512(data + i + 24));
+				}
+				return finish_sum(reduce_add512(a0, a1, a2, a3), data, i, size);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto min512(__m512i acc, __m512i value, width_tag<std::int32_t>) -> __m512i {
+				auto const all = static_cast<__mmask16>(0xFFFF);
+				return std::is_signed<T>::value
+					? _mm512_mask_min_epi32(acc, all, acc, value) : _mm512_mask_min_epu32(acc, all, acc, value);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto min512(__m512i acc, __m512i value, width_tag<std::int64_t>) -> __m512i {
+				auto const all = static_cast<__mmask8>(0xFF);
+				return std::is_signed<T>::value
+					? _mm512_mask_min_epi64(acc, all, acc, value) : _mm512_mask_min_epu64(acc, all, acc, value);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto max512(__m512i acc, __m512i value, width_tag<std::int32_t>) -> __m512i {
+				auto const all = static_cast<__mmask16>(0xFFFF);
+				return std::is_signed<T>::value
+					? _mm512_mask_max_epi32(acc, all, acc, value) : _mm512_mask_max_epu32(acc, all, acc, value);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto max512(__m512i acc, __m512i value, width_tag<std::int64_t>) -> __m512i {
+				auto const all = static_cast<__mmask8>(0xFF);
+				return std::is_signed<T>::value
+					? _mm512_mask_max_epi64(acc, all, acc, value) : _mm512_mask_max_epu64(acc, all, acc, value);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto broadcast512(T value) -> __m512i {
+				return sizeof(T) == 4
+					? _mm512_set1_epi32(static_cast<int>(value))
+					: _mm512_set1_epi64(static_cast<long long>(value));
+			}
+
+			template<typename T, size_t Width>
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto minmax_integers(avx512_tag, T const* data, size_t size, std::integral_constant<size_t, Width> width)
+				-> std::pair<T, T>
+			{
+				constexpr auto per_vector = 64 / Width;
+				auto const first = broadcast512(data[0]);
+				auto n0 = first, n1 = first, x0 = first, x1 = first;
+				size_t i = 0;
+				for (; i + 2 * per_vector <= size; i += 2 * per_vector) {
+					auto const v0 = _mm512_loadu_si512(data + i);
+					auto const v1 = _mm512_loadu_si512(data + i + per_vector);
+					n0 = min512<T>(n0, v0, width); x0 = max512<T>(x0, v0, width);
+					n1 = min512<T>(n1, v1, width); x1 = max512<T>(x1, v1, width);
+				}
+				T mins[2 * per_vector];
+				T maxs[2 * per_vector];
+				_mm512_storeu_si512(mins, n0); _mm512_storeu_si512(mins + per_vector, n1);
+				_mm512_storeu_si512(maxs, x0); _mm512_storeu_si512(maxs + per_vector, x1);
+				return finish_minmax(mins, maxs, data, i, size);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto find_integer(avx512_tag, T const* data, size_t size, T value, width_tag<std::int32_t>) -> size_t {
+				auto const needle = _mm512_set1_epi32(static_cast<int>(value));
+				size_t i = 0;
+				for (; i + 16 <= size; i += 16) {
+					auto const mask = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(data + i), needle);
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+					}
+				}
+				return i + find_equal(data + i, size - i, value);
+			}
+
+			template<typename T>
+			UTILS_SIMD_TARGET("avx512f")
+			inline auto find_integer(avx512_tag, T const* data, size_t size, T value, width_tag<std::int64_t>) -> size_t {
+				auto const needle = _mm512_set1_epi64(static_cast<long long>(value));
+				size_t i = 0;
+				for (; i + 8 <= size; i += 8) {
+					auto const mask = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(data + i), needle);
+					if (mask != 0) {
+						return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+					}
+				}
+				return i + find_equal(data + i, size - i, value);
+			}
+
+		//============================================================
+		// Dispatch
+		//============================================================
+
+			template<typename T>
+			auto vector_sum(T const* data, size_t size) -> T {
+				constexpr auto lane_total = lane_count<T>::value;
+				T lanes[lane_total] = {};
+				auto const blocks = size / lane_total;
+				switch (active_isa()) {
+					case isa::avx512: sum_blocks(avx512_tag{}, data, blocks, lanes); break;
+					case isa::avx2:   sum_blocks(avx2_tag{},   data, blocks, lanes); break;
+					case isa::sse2:   sum_blocks(sse2_tag{},   data, blocks, lanes); break;
+					case isa::scalar: return detail::sum(data, size);
+				}
+				sum_tail(lanes, data, blocks * lane_total, size);
+				return combine_lanes(lanes, [](T lhs, T rhs) { return lhs + rhs; });
+			}
+
+			template<typename T>
+			auto vector_dot(T const* lhs, T const* rhs, size_t size) -> T {
+				constexpr auto lane_total = lane_count<T>::value;
+				T lanes[lane_total] = {};
+				auto const blocks = size / lane_total;
+				switch (active_isa()) {
+					case isa::avx512: dot_blocks(avx512_tag{}, lhs, rhs, blocks, lanes); break;
+					case isa::avx2:   dot_blocks(avx2_tag{},   lhs, rhs, blocks, lanes); break;
+					case isa::sse2:   dot_blocks(sse2_tag{},   lhs, rhs, blocks, lanes); break;
+					case isa::scalar: return detail::dot(lhs, rhs, size);
+				}
+				dot_tail(lanes, lhs, rhs, blocks * lane_total, size);
+				return combine_lanes(lanes, [](T l, T r) { return l + r; });
+			}
+
+			template<typename T>
+			auto vector_minmax(T const* data, size_t size) -> std::pair<T, T> {
+				constexpr auto lane_total = lane_count<T>::value;
+				T mins[lane_total];
+				T maxs[lane_total];
+				std::fill(mins, mins + lane_total, data[0]);
+				std::fill(maxs, maxs + lane_total, data[0]);
+				auto const blocks = size / lane_total;
+				switch (active_isa()) {
+					case isa::avx512: minmax_blocks(avx512_tag{}, data, blocks, mins, maxs); break;
+					case isa::avx2:   minmax_blocks(avx2_tag{},   data, blocks, mins, maxs); break;
+					case isa::sse2:   minmax_blocks(sse2_tag{},   data, blocks, mins, maxs); break;
+					case isa::scalar: return detail::minmax(data, size);
+				}
+				minmax_tail(mins, maxs, data, blocks * lane_total, size);
+				return {combine_lanes(mins, min_op{}), combine_lanes(maxs, max_op{})};
+			}
+
+			template<typename T>
+			auto vector_find_equal(T const* data, size_t size, T value) -> size_t {
+				switch (active_isa()) {
+					case isa::avx512: return find_equal(avx512_tag{}, data, size, value);
+					case isa::avx2:   return find_equal(avx2_tag{},   data, size, value);
+					case isa::sse2:   return find_equal(sse2_tag{},   data, size, value);
+					case isa::scalar: break;
+				}
+				return detail::find_equal(data, size, value);
+			}
+
+			template<typename T>
+			auto integer_sum(T const* data, size_t size) -> accumulate_t<T> {
+				switch (active_isa()) {
+					case isa::avx512: return sum_integers(avx512_tag{}, data, size, width_tag<T>{});
+					case isa::avx2:   return sum_integers(avx2_tag{},   data, size, width_tag<T>{});
+					case isa::sse2:   return sum_integers(sse2_tag{},   data, size, width_tag<T>{});
+					case isa::scalar: break;
+				}
+				return detail::sum(data, size);
+			}
+
+			template<typename T>
+			auto integer_minmax(T const* data, size_t size) -> std::pair<T, T> {
+				switch (active_isa()) {
+					case isa::avx512: return minmax_integers(avx512_tag{}, data, size, width_tag<T>{});
+					case isa::avx2:   return minmax_integers(avx2_tag{},   data, size, width_tag<T>{});
+					case isa::sse2:   return minmax_integers(sse2_tag{},   data, size, width_tag<T>{});
+					case isa::scalar: break;
+				}
+				return detail::minmax(data, size);
+			}
+
+			template<typename T>
+			auto integer_find_equal(T const* data, size_t size, T value) -> size_t {
+				switch (active_isa()) {
+					case isa::avx512: return find_integer(avx512_tag{}, data, size, value, width_tag<T>{});
+					case isa::avx2:   return find_integer(avx2_tag{},   data, size, value, width_tag<T>{});
+					case isa::sse2:   return find_integer(sse2_tag{},   data, size, value, width_tag<T>{});
+					case isa::scalar: break;
+				}
+				return detail::find_equal(data, size, value);
+			}
+
+			// Non-template overloads take precedence over the portable templates.
+
+			inline auto sum(float  const* data, size_t size) -> float  { return vector_sum(data, size); }
+			inline auto sum(double const* data, size_t size) -> double { return vector_sum(data, size); }
+
+			inline auto dot(float  const* lhs, float  const* rhs, size_t size) -> float  { return vector_dot(lhs, rhs, size); }
+			inline auto dot(double const* lhs, double const* rhs, size_t size) -> double { return vector_dot(lhs, rhs, size); }
+
+			inline auto minmax(float  const* data, size_t size) -> std::pair<float,  float>  { return vector_minmax(data, size); }
+			inline auto minmax(double const* data, size_t size) -> std::pair<double, double> { return vector_minmax(data, size); }
+
+			inline auto find_equal(float  const* data, size_t size, float  const& value) -> size_t { return vector_find_equal(data, size, value); }
+			inline auto find_equal(double const* data, size_t size, double const& value) -> size_t { return vector_find_equal(data, size, value); }
+
+			inline auto sum(int                const* data, size_t size) -> accumulate_t<int> { return integer_sum(data, size); }
+			inline auto sum(unsigned int       const* data, size_t size) -> accumulate_t<unsigned int> { return integer_sum(data, size); }
+			inline auto sum(long               const* data, size_t size) -> accumulate_t<long> { return integer_sum(data, size); }
+			inline auto sum(unsigned long      const* data, size_t size) -> accumulate_t<unsigned long> { return integer_sum(data, size); }
+			inline auto sum(long long          const* data, size_t size) -> accumulate_t<long long> { return integer_sum(data, size); }
+			inline auto sum(unsigned long long const* data, size_t size) -> accumulate_t<unsigned long long> { return integer_sum(data, size); }
+
+			inline auto minmax(int                const* data, size_t size) -> std::pair<int, int> { return integer_minmax(data, size); }
+			inline auto minmax(unsigned int       const* data, size_t size) -> std::pair<unsigned int, unsigned int> { return integer_minmax(data, size); }
+			inline auto minmax(long               const* data, size_t size) -> std::pair<long, long> { return integer_minmax(data, size); }
+			inline auto minmax(unsigned long      const* data, size_t size) -> std::pair<unsigned long, unsigned long> { return integer_minmax(data, size); }
+			inline auto minmax(long long          const* data, size_t size) -> std::pair<long long, long long> { return integer_minmax(data, size); }
+			inline auto minmax(unsigned long long const* data, size_t size) -> std::pair<unsigned long long, unsigned long long> { return integer_minmax(data, size); }
+
+			inline auto find_equal(int                const* data, size_t size, int                const& value) -> size_t { return integer_find_equal(data, size, value); }
+			inline auto find_equal(unsigned int       const* data, size_t size, unsigned int       const& value) -> size_t { return integer_find_equal(data, size, value); }
+			inline auto find_equal(long               const* data, size_t size, long               const& value) -> size_t { return integer_find_equal(data, size, value); }
+			inline auto find_equal(unsigned long      const* data, size_t size, unsigned long      const& value) -> size_t { return integer_find_equal(data, size, value); }
+			inline auto find_equal(long long          const* data, size_t size, long long          const& value) -> size_t { return integer_find_equal(data, size, value); }
+			inline auto find_equal(unsigned long long const* data, size_t size, unsigned long long const& value) -> size_t { return integer_find_equal(data, size, value); }
+#endif
+		}
+	}
+}
+
+//============================================================
+// Reductions
+//============================================================
+
+template<typename T>
+auto utils::simd::sum(dynarray<T> const& array) -> accumulate_t<T> {
+	static_assert(std::is_arithmetic<T>::value, "simd::sum requires arithmetic element types");
+	return detail::sum(array.data(), array.size());
+}
+
+template<typename T>
+auto utils::simd::dot(dynarray<T> const& lhs, dynarray<T> const& rhs) -> accumulate_t<T> {
+	static_assert(std::is_arithmetic<T>::value, "simd::dot requires arithmetic element types");
+	if (lhs.size() != rhs.size()) {
+		using namespace std::string_literals;
+		throw std::invalid_argument{
+			"cannot compute dot product of dynarrays with sizes "s +
+			std::to_string(lhs.size()) + " and " + std::to_string(rhs.size())
+		};
+	}
+	return detail::dot(lhs.data(), rhs.data(), lhs.size());
+}
+
+template<typename T>
+auto utils::simd::norm(dynarray<T> const& array) -> T {
+	static_assert(std::is_floating_point<T>::value, "simd::norm requires floating point element types");
+	using std::sqrt;
+	return sqrt(detail::dot(array.data(), array.data(), array.size()));
+}
+
+template<typename T>
+auto utils::simd::min(dynarray<T> const& array) -> T {
+	return minmax(array).first;
+}
+
+template<typename T>
+auto utils::simd::max(dynarray<T> const& array) -> T {
+	return minmax(array).second;
+}
+
+template<typename T>
+auto utils::simd::minmax(dynarray<T> const& array) -> std::pair<T, T> {
+	static_assert(std::is_arithmetic<T>::value, "simd::minmax requires arithmetic element types");
+	detail::ensure_not_empty(array.size(), "minmax");
+	return detail::minmax(array.data(), array.size());
+}
+
+template<typename T>
+auto utils::simd::argmin(dynarray<T> const& array) -> size_t {
+	detail::ensure_not_empty(array.size(), "argmin");
+	auto const pos = detail::find_equal(array.data(), array.size(), min(array));
+	// Only a NaN minimum compares unequal to every element.
+	return pos != array.size() ? pos
+		: detail::find_nan(array.data(), array.size(), std::is_floating_point<T>{});
+}
+
+template<typename T>
+auto utils::simd::argmax(dynarray<T> const& array) -> size_t {
+	detail::ensure_not_empty(array.size(), "argmax");
+	auto const pos = detail::find_equal(array.data(), array.size(), max(array));
+	// Only a NaN maximum compares unequal to every element.
+	return pos != array.size() ? pos
+		: detail::find_nan(array.data(), array.size(), std::is_floating_point<T>{});
+}
+
+#endif // UTILS_DYNARRAY_SIMD_HPP
@@ -0,0 +1,456 @@
+//===---------------------------------------------------------
+//                       DYNARRAY_VIEW
+//===---------------------------------------------------------
+//
+// Non-owning view onto a contiguous range of elements,
+// usually a whole dynarray or a slice of one.
+// Slicing and passing views around never allocates or
+// copies any element.
+//
+// Views onto read-only elements are expressed by a const
+// qualified element type, e.g. dynarray_view<T const>.
+// When compiled against a standard library that provides
+// std::span views convert implicitly to and from spans.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_DYNARRAY_VIEW_HPP
+#define UTILS_DYNARRAY_VIEW_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+#if defined(__has_include)
+	#if __has_include(<span>) && __cplusplus > 201703L
+		#include <span>
+	#endif
+#endif
+
+// headers used by definition site
+#include <stdexcept>
+#include <string>
+
+#if defined(__cpp_lib_span)
+	#define UTILS_DYNARRAY_VIEW_HAS_SPAN 1
+#else
+	#define UTILS_DYNARRAY_VIEW_HAS_SPAN 0
+#endif
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// Non-owning view onto \count contiguous elements of type \T.
+	///
+	/// A view is cheap to copy and should be passed by value.
+	/// It does not extend the lifetime of the viewed elements:
+	/// the viewed dynarray must outlive all views onto it.
+	template<typename T>
+	class dynarray_view {
+	public:
+
+	//============================================================
+	// Type aliases
+	//============================================================
+
+		using element_type           = T;
+		using value_type             = typename std::remove_cv<T>::type;
+		using size_type              = size_t;
+		using difference_type        = std::ptrdiff_t;
+		using reference              = element_type &;
+		using const_reference        = element_type const&;
+		using pointer                = element_type *;
+		using const_pointer          = element_type const*;
+		using iterator               = pointer;
+		using const_iterator         = const_pointer;
+		using reverse_iterator       = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+		/// Passed as count to subview() in order to view all remaining elements.
+		static constexpr size_type npos = static_cast<size_type>(-1);
+
+	//============================================================
+	// Constructors
+	//============================================================
+
+	// (1) construct empty view
+	//============================================================
+		dynarray_view();
+
+	// (2) construct from pointer and count
+	//============================================================
+		dynarray_view(pointer first, size_type count);
+
+	// (3) construct from dynarray
+	//============================================================
+		dynarray_view(dynarray<value_type> & array);
+
+		template<
+			typename U = T,
+			typename = typename std::enable_if<std::is_const<U>::value>::type>
+		dynarray_view(dynarray<value_type> const& array);
+
+	// (4) construct from view onto mutable elements
+	//============================================================
+		template<
+			typename U,
+			typename = typename std::enable_if<
+				std::is_convertible<U (*)[], T (*)[]>::value>::type>
+		dynarray_view(dynarray_view<U> const& other);
+
+	#if UTILS_DYNARRAY_VIEW_HAS_SPAN
+	// (5) construct from span
+	//============================================================
+		dynarray_view(std::span<T> span);
+	#endif
+
+	//============================================================
+	// Access API
+	//============================================================
+
+		/// Access the element at the specified position \pos with bounds checking.
+		/// Throws out_of_bounds exception if \pos was illegal.
+		auto at(size_type pos) const -> reference;
+
+		/// Access the element at the specified position \pos without bounds checking.
+		auto operator[](size_type pos) const -> reference;
+
+		/// Access the first element.
+		auto front() const -> reference;
+
+		/// Access the last element.
+		auto back() const -> reference;
+
+		/// Returns a raw-pointer to the first viewed element.
+		auto data() const -> pointer;
+
+	//============================================================
+	// Capacity API
+	//============================================================
+
+		/// Returns `true` if this view is empty and `false` otherwise.
+		auto empty() const -> bool;
+
+		/// Returns the count of elements in this view.
+		auto size() const -> size_type;
+
+	//============================================================
+	// Slicing API
+	// None of these allocate or copy elements.
+	//============================================================
+
+		/// Returns a view onto \count elements starting at \offset.
+		/// If \count is npos all elements from \offset to the end are viewed.
+		/// Throws out_of_range exception if the range exceeds this view.
+		auto subview(size_type offset, size_type count = npos) const -> dynarray_view;
+
+		/// Returns a view onto the first \count elements.
+		/// Throws out_of_range exception if \count exceeds the size of this view.
+		auto first(size_type count) const -> dynarray_view;
+
+		/// Returns a view onto the last \count elements.
+		/// Throws out_of_range exception if \count exceeds the size of this view.
+		auto last(size_type count) const -> dynarray_view;
+
+	#if UTILS_DYNARRAY_VIEW_HAS_SPAN
+	//============================================================
+	// Conversion API
+	//============================================================
+
+		/// Converts this view into an equivalent std::span.
+		operator std::span<T>() const;
+	#endif
+
+	//============================================================
+	// Iterator API
+	//============================================================
+
+		/// Returns an iterator to the first element in this view.
+		auto begin() const -> iterator;
+
+		/// Returns a read-only iterator to the first element in this view.
+		auto cbegin() const -> const_iterator;
+
+		/// Returns an iterator to the position behind the last element in this view.
+		auto end() const -> iterator;
+
+		/// Returns a read-only iterator to the position behind the last element in this view.
+		auto cend() const -> const_iterator;
+
+		/// Returns an iterator to the first element in this view
+		/// in respective to the reverse order of elements.
+		auto rbegin() const -> reverse_iterator;
+
+		/// Returns a read-only iterator to the first element in this view
+		/// in respective to the reverse order of elements.
+		auto crbegin() const -> const_reverse_iterator;
+
+		/// Returns an iterator to the position behind the last element
+		/// in this view in respective to the reverse order of elements.
+		auto rend() const -> reverse_iterator;
+
+		/// Returns a read-only iterator to the position behind the last element
+		/// in this view in respective to the reverse order of elements.
+		auto crend() const -> const_reverse_iterator;
+
+	//============================================================
+	// Member Variables
+	//============================================================
+
+	private:
+		pointer   m_data;
+		size_type m_size;
+	};
+
+	/// Returns a view onto all elements of \array.
+	template<typename T>
+	auto make_view(dynarray<T> & array) -> dynarray_view<T>;
+
+	/// Returns a read-only view onto all elements of \array.
+	template<typename T>
+	auto make_view(dynarray<T> const& array) -> dynarray_view<T const>;
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+template<typename T>
+constexpr typename utils::dynarray_view<T>::size_type utils::dynarray_view<T>::npos;
+
+//============================================================
+// Constructors
+//============================================================
+
+// (1) construct empty view
+//============================================================
+template<typename T>
+utils::dynarray_view<T>::dynarray_view():
+	m_data{nullptr},
+	m_size{0}
+{}
+
+// (2) construct from pointer and count
+//============================================================
+template<typename T>
+utils::dynarray_view<T>::dynarray_view(pointer first, size_type count):
+	m_data{first},
+	m_size{count}
+{}
+
+// (3) construct from dynarray
+//============================================================
+template<typename T>
+utils::dynarray_view<T>::dynarray_view(dynarray<value_type> & array):
+	m_data{array.data()},
+	m_size{array.size()}
+{}
+
+template<typename T>
+template<typename U, typename>
+utils::dynarray_view<T>::dynarray_view(dynarray<value_type> const& array):
+	m_data{array.data()},
+	m_size{array.size()}
+{}
+
+// (4) construct from view onto mutable elements
+//============================================================
+template<typename T>
+template<typename U, typename>
+utils::dynarray_view<T>::dynarray_view(dynarray_view<U> const& other):
+	m_data{other.data()},
+	m_size{other.size()}
+{}
+
+#if UTILS_DYNARRAY_VIEW_HAS_SPAN
+// (5) construct from span
+//============================================================
+template<typename T>
+utils::dynarray_view<T>::dynarray_view(std::span<T> span):
+	m_data{span.data()},
+	m_size{span.size()}
+{}
+#endif
+
+//============================================================
+// Access API
+//============================================================
+
+template<typename T>
+auto utils::dynarray_view<T>::at(size_type pos) const -> reference {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access element at position "s +
+			std::to_string(pos) +
+			" from a dynarray_view with size " +
+			std::to_string(size())
+		};
+	}
+	return m_data[pos];
+}
+
+template<typename T>
+auto utils::dynarray_view<T>::operator[](size_type pos) const -> reference {
+	return m_data[pos];
+}
+
+template<typename T>
+auto utils::dynarray_view<T>::front() const -> reference {
+	return m_data[0];
+}
+
+template<typename T>
+auto utils::dynarray_view<T>::back() const -> reference {
+	return m_data[size() - 1];
+}
+
+template<typename T>
+auto utils::dynarray_view<T>::data() const -> pointer {
+	return m_data;
+}
+
+//============================================================
+// Capacity API
+//============================================================
+
+template<typename T>
+auto utils::dynarray_view<T>::empty() const -> bool {
+	return m_size == 0;
+}
+
+template<typename T>
+auto utils::dynarray_view<T>::size() const -> size_type {
+	return m_size;
+}
+
+//============================================================
+// Slicing API
+//============================================================
+
+template<typename T>
+auto utils::dynarray_view<T>::subview(size_type offset, size_type count) const -> dynarray_view {
+	if (offset > size() || (count != npos && count > size() - offset)) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot create subview at offset "s +
+			std::to_string(offset) +
+			" with count " +
+			(count == npos ? "npos"s : std::to_string(count)) +
+			" from a dynarray_view with size " +
+			std::to_string(size())
+		};
+	}
+	return dynarray_view{m_data + offset, count == npos ? size() - offset : count};
+}
+
+template<typename T>
+auto utils::dynarray_view<T>::first(size_type count) const -> dynarray_view {
+	if (count > size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot view first "s +
+			std::to_string(count) +
+			" elements of a dynarray_view with size " +
+			std::to_string(size())
+		};
+	}
+	return dynarray_view{m_data, count};
+}
+
+template<typename T>
+auto utils::dynarray_view<T>::last(size_type count) const -> dynarray_view {
+	if (count > size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot view last "s +
+			std::to_string(count) +
+			" elements of a dynarray_view with size " +
+			std::to_string(size())
+		};
+	}
+	return dynarray_view{m_data + (size() - count), count};
+}
+
+#if UTILS_DYNARRAY_VIEW_HAS_SPAN
+//============================================================
+// Conversion API
+//============================================================
+
+template<typename T>
+utils::dynarray_view<T>::operator std::span<T>() const {
+	return std::span<T>{m_data, m_size};
+}
+#endif
+
+//============================================================
+// Iterator API
+//============================================================
+
+template<typename T>
+auto utils::dynarray_view<T>::begin() const -> iterator {
+	return m_data;
+}
+
+template<typename T>
+auto utils::dynarray_view<T>::cbegin() const -> const_iterator {
+	return m_data;
+}
+
+template<typename T>
+auto utils::dynarray_view<T>::end() const -> iterator {
+	return m_data + m_size;
+}
+
+template<typename T>
+auto utils::dynarray_view<T>::cend() const -> const_iterator {
+	return m_data + m_size;
+}
+
+template<typename T>
+auto utils::dynarray_view<T>::rbegin() const -> reverse_iterator {
+	return reverse_iterator{end()};
+}
+
+template<typename T>
+auto utils::dynarray_view<T>::crbegin() const -> const_reverse_iterator {
+	return const_reverse_iterator{cend()};
+}
+
+template<typename T>
+auto utils::dynarray_view<T>::rend() const -> reverse_iterator {
+	return reverse_iterator{begin()};
+}
+
+template<typename T>
+auto utils::dynarray_view<T>::crend() const -> const_reverse_iterator {
+	return const_reverse_iterator{cbegin()};
+}
+
+//============================================================
+// Factory functions
+//============================================================
+
+template<typename T>
+auto utils::make_view(dynarray<T> & array) -> dynarray_view<T> {
+	return dynarray_view<T>{array};
+}
+
+template<typename T>
+auto utils::make_view(dynarray<T> const& array) -> dynarray_view<T const> {
+	return dynarray_view<T const>{array};
+}
+
+#endif // UTILS_DYNARRAY_VIEW_HPP
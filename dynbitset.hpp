@@ -0,0 +1,669 @@
+//===---------------------------------------------------------
+//                       DYNBITSET
+//===---------------------------------------------------------
+//
+// Bit-packed companion of the dynarray container for
+// boolean flags. Like dynarray the number of bits is
+// fixed at construction. In contrast to dynarray<bool>,
+// which spends a whole byte per flag, every flag occupies
+// a single bit of an array of 64-bit words.
+//
+// Bulk queries (count, find_first, find_next) and the
+// bitwise combination of equally sized sets operate on
+// whole words. count, find_first and find_next select an
+// AVX2 kernel at runtime (see cpu_dispatch.hpp).
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_DYNBITSET_HPP
+#define UTILS_DYNBITSET_HPP
+
+// headers used by declaration site
+#include "cpu_dispatch.hpp"
+#include "dynarray.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+// headers used by definition site
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// Fixed-size sequence of bits stored densely in 64-bit words.
+	///
+	/// Bit \pos is stored in word `pos / 64` at bit position `pos % 64`.
+	/// Unused bits of the last word are kept zero by all member functions
+	/// so that whole words can be processed without masking. Callers writing
+	/// through data() must preserve this, otherwise count(), all(), the find
+	/// functions and comparisons report bits past the end.
+	class dynbitset {
+	public:
+
+	//============================================================
+	// Type aliases
+	//============================================================
+
+		using word_type = std::uint64_t;
+		using size_type = size_t;
+
+		/// Returned by the find functions if no set bit was found.
+		static constexpr size_type npos = static_cast<size_type>(-1);
+
+		/// The number of bits per word.
+		static constexpr size_type bits_per_word = 64;
+
+		/// Proxy reference to a single bit.
+		class reference {
+		public:
+			reference(word_type & word, word_type mask):
+				m_word{&word},
+				m_mask{mask}
+			{}
+
+			reference(reference const&) = default;
+
+			operator bool() const { return (*m_word & m_mask) != 0; }
+			auto operator~() const -> bool { return (*m_word & m_mask) == 0; }
+
+			auto operator=(bool value) -> reference & {
+				if (value) { *m_word |= m_mask; } else { *m_word &= ~m_mask; }
+				return *this;
+			}
+
+			auto operator=(reference const& other) -> reference & {
+				return *this = static_cast<bool>(other);
+			}
+
+			auto flip() -> reference & {
+				*m_word ^= m_mask;
+				return *this;
+			}
+
+		private:
+			word_type * m_word;
+			word_type   m_mask;
+		};
+
+		using const_reference = bool;
+
+	//============================================================
+	// Constructors
+	//============================================================
+
+	// (1) construct by count with all bits unset
+	//============================================================
+		explicit dynbitset(size_type count);
+
+	// (2) construct by count and copied value
+	//============================================================
+		dynbitset(size_type count, bool value);
+
+	// (3) construct by initializer list
+	//============================================================
+		dynbitset(std::initializer_list<bool> list);
+
+	//============================================================
+	// Assignment Operator
+	//============================================================
+
+		/// Copy-Assigns from the specified \other dynbitset instance.
+		/// Throws an invalid_argument exception when the sizes of both
+		/// dynbitsets are unequal.
+		auto operator=(dynbitset const& other) -> dynbitset &;
+
+		/// Move-Assigns from the specified \other dynbitset instance.
+		auto operator=(dynbitset && other) -> dynbitset &;
+
+		dynbitset(dynbitset const& other) = default;
+		dynbitset(dynbitset && other) = default;
+
+	//============================================================
+	// Access API
+	//============================================================
+
+		/// Access the bit at the specified position \pos with bounds checking.
+		/// Throws out_of_bounds exception if \pos was illegal.
+		auto at(size_type pos) -> reference;
+
+		/// Read-only access to the bit at the specified position \pos with bounds checking.
+		/// Throws out_of_bounds exception if \pos was illegal.
+		auto at(size_type pos) const -> const_reference;
+
+		/// Access the bit at the specified position \pos without bounds checking.
+		auto operator[](size_type pos) -> reference;
+
+		/// Read-only access the bit at the specified position \pos without bounds checking.
+		auto operator[](size_type pos) const -> const_reference;
+
+		/// Returns `true` if the bit at position \pos is set.
+		auto test(size_type pos) const -> bool;
+
+		/// Returns a raw-pointer to the underlying words.
+		/// Unused bits of the last word must be left zero when writing through it.
+		auto data() -> word_type *;
+
+		/// Returns a read-only raw-pointer to the underlying words.
+		auto data() const -> word_type const*;
+
+	//============================================================
+	// Capacity API
+	//============================================================
+
+		/// Returns `true` if this dynbitset has no bits and `false` otherwise.
+		auto empty() const -> bool;
+
+		/// Returns the count of bits in this dynbitset.
+		auto size() const -> size_type;
+
+		/// Returns the count of words used to store the bits.
+		auto word_count() const -> size_type;
+
+	//============================================================
+	// Query API
+	//============================================================
+
+		/// Returns the number of set bits.
+		auto count() const -> size_type;
+
+		/// Returns `true` if any bit is set.
+		auto any() const -> bool;
+
+		/// Returns `true` if no bit is set.
+		auto none() const -> bool;
+
+		/// Returns `true` if all bits are set.
+		auto all() const -> bool;
+
+		/// Returns the position of the first set bit or npos if there is none.
+		auto find_first() const -> size_type;
+
+		/// Returns the position of the first set bit after \pos or npos if there is none.
+		auto find_next(size_type pos) const -> size_type;
+
+	//============================================================
+	// Mutate API
+	//============================================================
+
+		/// Sets the bit at position \pos to \value.
+		auto set(size_type pos, bool value = true) -> dynbitset &;
+
+		/// Sets all bits.
+		auto set() -> dynbitset &;
+
+		/// Unsets the bit at position \pos.
+		auto reset(size_type pos) -> dynbitset &;
+
+		/// Unsets all bits.
+		auto reset() -> dynbitset &;
+
+		/// Toggles the bit at position \pos.
+		auto flip(size_type pos) -> dynbitset &;
+
+		/// Toggles all bits.
+		auto flip() -> dynbitset &;
+
+		/// Sets all bits to \value.
+		void fill(bool value);
+
+	//============================================================
+	// Bitwise API
+	// All operations throw an invalid_argument exception when
+	// the sizes of both dynbitsets are unequal.
+	//============================================================
+
+		auto operator&=(dynbitset const& other) -> dynbitset &;
+		auto operator|=(dynbitset const& other) -> dynbitset &;
+		auto operator^=(dynbitset const& other) -> dynbitset &;
+
+		/// Returns a copy of this dynbitset with all bits toggled.
+		auto operator~() const -> dynbitset;
+
+	//============================================================
+	// Member Variables
+	//============================================================
+
+	private:
+		/// Throws an invalid_argument exception if \other has a different size.
+		void ensure_same_size(dynbitset const& other, char const* operation) const;
+
+		/// Clears the unused bits of the last word.
+		void sanitize();
+
+		dynarray<word_type> m_words;
+		size_type           m_size;
+	};
+
+	auto operator==(dynbitset const& lhs, dynbitset const& rhs) -> bool;
+	auto operator!=(dynbitset const& lhs, dynbitset const& rhs) -> bool;
+
+	auto operator&(dynbitset const& lhs, dynbitset const& rhs) -> dynbitset;
+	auto operator|(dynbitset const& lhs, dynbitset const& rhs) -> dynbitset;
+	auto operator^(dynbitset const& lhs, dynbitset const& rhs) -> dynbitset;
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace detail {
+		/// Returns the number of set bits in \word.
+		inline auto popcount64(std::uint64_t word) -> unsigned {
+		#if defined(__GNUC__) || defined(__clang__)
+			return static_cast<unsigned>(__builtin_popcountll(word));
+		#else
+			word = word - ((word >> 1) & 0x5555555555555555ull);
+			word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+			word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+			return static_cast<unsigned>((word * 0x0101010101010101ull) >> 56);
+		#endif
+		}
+
+		/// Returns the number of trailing zero bits in the non-zero \word.
+		inline auto countr_zero64(std::uint64_t word) -> unsigned {
+		#if defined(__GNUC__) || defined(__clang__)
+			return static_cast<unsigned>(__builtin_ctzll(word));
+		#else
+			return popcount64((word & (~word + 1)) - 1);
+		#endif
+		}
+
+		/// Returns the number of set bits in the \count words starting at \words.
+		inline auto popcount_words_scalar(std::uint64_t const* words, size_t count) -> size_t {
+			// Independent accumulators break the dependency chain
+			// between consecutive popcount instructions.
+			size_t i = 0;
+			size_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+			for (; i + 4 <= count; i += 4) {
+				acc0 += popcount64(words[i + 0]);
+				acc1 += popcount64(words[i + 1]);
+				acc2 += popcount64(words[i + 2]);
+				acc3 += popcount64(words[i + 3]);
+			}
+			auto total = acc0 + acc1 + acc2 + acc3;
+			for (size_t tail = 0; tail != count % 4; ++tail) {
+				total += popcount64(words[i + tail]);
+			}
+			return total;
+		}
+
+		/// Returns the index of the first non-zero word in [\first, \count)
+		/// or \count if all of them are zero.
+		inline auto find_nonzero_word_scalar(std::uint64_t const* words, size_t first, size_t count) -> size_t {
+			for (auto i = first; i != count; ++i) {
+				if (words[i] != 0) {
+					return i;
+				}
+			}
+			return count;
+		}
+
+	#if defined(UTILS_SIMD_X86)
+		UTILS_SIMD_TARGET("avx2")
+		inline auto popcount_words_avx2(std::uint64_t const* words, size_t count) -> size_t {
+			// Nibble lookup popcount (Mula et al.): splits every byte into two
+			// nibbles, counts them via an in-register table and sums up the
+			// byte counters horizontally with the SAD instruction.
+			auto const lookup = _mm256_setr_epi8(
+				0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+				0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+			auto const low_mask = _mm256_set1_epi8(0x0f);
+			auto acc = _mm256_setzero_si256();
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				auto const v  = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(words + i));
+				auto const lo = _mm256_and_si256(v, low_mask);
+				auto const hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+				auto const counts = _mm256_add_epi8(
+					_mm256_shuffle_epi8(lookup, lo),
+					_mm256_shuffle_epi8(lookup, hi));
+				acc = _mm256_add_epi64(acc, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+			}
+			auto total = static_cast<size_t>(_mm256_extract_epi64(acc, 0))
+			           + static_cast<size_t>(_mm256_extract_epi64(acc, 1))
+			           + static_cast<size_t>(_mm256_extract_epi64(acc, 2))
+			           + static_cast<size_t>(_mm256_extract_epi64(acc, 3));
+			return total + popcount_words_scalar(words + i, count - i);
+		}
+
+		UTILS_SIMD_TARGET("avx2")
+		inline auto find_nonzero_word_avx2(std::uint64_t const* words, size_t first, size_t count) -> size_t {
+			auto i = first;
+			for (; i + 4 <= count; i += 4) {
+				auto const v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(words + i));
+				if (!_mm256_testz_si256(v, v)) {
+					break;
+				}
+			}
+			return find_nonzero_word_scalar(words, i, count);
+		}
+	#endif
+
+		inline auto popcount_words(std::uint64_t const* words, size_t count) -> size_t {
+	#if defined(UTILS_SIMD_X86)
+			if (cpu::active_isa() >= cpu::isa::avx2) {
+				return popcount_words_avx2(words, count);
+			}
+	#endif
+			return popcount_words_scalar(words, count);
+		}
+
+		inline auto find_nonzero_word(std::uint64_t const* words, size_t first, size_t count) -> size_t {
+	#if defined(UTILS_SIMD_X86)
+			if (cpu::active_isa() >= cpu::isa::avx2) {
+				return find_nonzero_word_avx2(words, first, count);
+			}
+	#endif
+			return find_nonzero_word_scalar(words, first, count);
+		}
+	}
+}
+
+//============================================================
+// Constructors
+//============================================================
+
+// (1) construct by count with all bits unset
+//============================================================
+inline utils::dynbitset::dynbitset(size_type count):
+	m_words((count + bits_per_word - 1) / bits_per_word, word_type{0}),
+	m_size{count}
+{}
+
+// (2) construct by count and copied value
+//============================================================
+inline utils::dynbitset::dynbitset(size_type count, bool value):
+	m_words((count + bits_per_word - 1) / bits_per_word, value ? ~word_type{0} : word_type{0}),
+	m_size{count}
+{
+	sanitize();
+}
+
+// (3) construct by initializer list
+//============================================================
+inline utils::dynbitset::dynbitset(std::initializer_list<bool> list):
+	dynbitset(list.size())
+{
+	size_type pos = 0;
+	for (auto value : list) {
+		set(pos++, value);
+	}
+}
+
+//============================================================
+// Assignment Operator
+//============================================================
+
+inline auto utils::dynbitset::operator=(dynbitset const& other) -> dynbitset & {
+	ensure_same_size(other, "copy-assign");
+	m_words = other.m_words;
+	return *this;
+}
+
+inline auto utils::dynbitset::operator=(dynbitset && other) -> dynbitset & {
+	m_words = std::move(other.m_words);
+	std::swap(m_size, other.m_size);
+	return *this;
+}
+
+//============================================================
+// Access API
+//============================================================
+
+inline auto utils::dynbitset::at(size_type pos) -> reference {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access bit at position "s +
+			std::to_string(pos) +
+			" from a dynbitset with size " +
+			std::to_string(size())
+		};
+	}
+	return (*this)[pos];
+}
+
+inline auto utils::dynbitset::at(size_type pos) const -> const_reference {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access bit at position "s +
+			std::to_string(pos) +
+			" from a dynbitset with size " +
+			std::to_string(size())
+		};
+	}
+	return (*this)[pos];
+}
+
+inline auto utils::dynbitset::operator[](size_type pos) -> reference {
+	return reference{m_words[pos / bits_per_word], word_type{1} << (pos % bits_per_word)};
+}
+
+inline auto utils::dynbitset::operator[](size_type pos) const -> const_reference {
+	return test(pos);
+}
+
+inline auto utils::dynbitset::test(size_type pos) const -> bool {
+	return ((m_words[pos / bits_per_word] >> (pos % bits_per_word)) & 1) != 0;
+}
+
+inline auto utils::dynbitset::data() -> word_type * {
+	return m_words.data();
+}
+
+inline auto utils::dynbitset::data() const -> word_type const* {
+	return m_words.data();
+}
+
+//============================================================
+// Capacity API
+//============================================================
+
+inline auto utils::dynbitset::empty() const -> bool {
+	return m_size == 0;
+}
+
+inline auto utils::dynbitset::size() const -> size_type {
+	return m_size;
+}
+
+inline auto utils::dynbitset::word_count() const -> size_type {
+	return m_words.size();
+}
+
+//============================================================
+// Query API
+//============================================================
+
+inline auto utils::dynbitset::count() const -> size_type {
+	return detail::popcount_words(m_words.data(), m_words.size());
+}
+
+inline auto utils::dynbitset::any() const -> bool {
+	return detail::find_nonzero_word(m_words.data(), 0, m_words.size()) != m_words.size();
+}
+
+inline auto utils::dynbitset::none() const -> bool {
+	return !any();
+}
+
+inline auto utils::dynbitset::all() const -> bool {
+	return count() == size();
+}
+
+inline auto utils::dynbitset::find_first() const -> size_type {
+	auto const word = detail::find_nonzero_word(m_words.data(), 0, m_words.size());
+	if (word == m_words.size()) {
+		return npos;
+	}
+	return word * bits_per_word + detail::countr_zero64(m_words[word]);
+}
+
+inline auto utils::dynbitset::find_next(size_type pos) const -> size_type {
+	++pos;
+	if (pos >= size()) {
+		return npos;
+	}
+	auto word = pos / bits_per_word;
+	auto const masked = m_words[word] & (~word_type{0} << (pos % bits_per_word));
+	if (masked != 0) {
+		return word * bits_per_word + detail::countr_zero64(masked);
+	}
+	word = detail::find_nonzero_word(m_words.data(), word + 1, m_words.size());
+	if (word == m_words.size()) {
+		return npos;
+	}
+	return word * bits_per_word + detail::countr_zero64(m_words[word]);
+}
+
+//============================================================
+// Mutate API
+//============================================================
+
+inline auto utils::dynbitset::set(size_type pos, bool value) -> dynbitset & {
+	(*this)[pos] = value;
+	return *this;
+}
+
+inline auto utils::dynbitset::set() -> dynbitset & {
+	fill(true);
+	return *this;
+}
+
+inline auto utils::dynbitset::reset(size_type pos) -> dynbitset & {
+	m_words[pos / bits_per_word] &= ~(word_type{1} << (pos % bits_per_word));
+	return *this;
+}
+
+inline auto utils::dynbitset::reset() -> dynbitset & {
+	fill(false);
+	return *this;
+}
+
+inline auto utils::dynbitset::flip(size_type pos) -> dynbitset & {
+	m_words[pos / bits_per_word] ^= word_type{1} << (pos % bits_per_word);
+	return *this;
+}
+
+inline auto utils::dynbitset::flip() -> dynbitset & {
+	for (auto & word : m_words) {
+		word = ~word;
+	}
+	sanitize();
+	return *this;
+}
+
+inline void utils::dynbitset::fill(bool value) {
+	m_words.fill(value ? ~word_type{0} : word_type{0});
+	sanitize();
+}
+
+//============================================================
+// Bitwise API
+//
+// The word loops below are trivially vectorized by the
+// compiler and run at memory bandwidth for large sets.
+//============================================================
+
+inline auto utils::dynbitset::operator&=(dynbitset const& other) -> dynbitset & {
+	ensure_same_size(other, "and");
+	auto       dst = m_words.data();
+	auto const src = other.m_words.data();
+	for (size_type i = 0; i != m_words.size(); ++i) {
+		dst[i] &= src[i];
+	}
+	return *this;
+}
+
+inline auto utils::dynbitset::operator|=(dynbitset const& other) -> dynbitset & {
+	ensure_same_size(other, "or");
+	auto       dst = m_words.data();
+	auto const src = other.m_words.data();
+	for (size_type i = 0; i != m_words.size(); ++i) {
+		dst[i] |= src[i];
+	}
+	return *this;
+}
+
+inline auto utils::dynbitset::operator^=(dynbitset const& other) -> dynbitset & {
+	ensure_same_size(other, "xor");
+	auto       dst = m_words.data();
+	auto const src = other.m_words.data();
+	for (size_type i = 0; i != m_words.size(); ++i) {
+		dst[i] ^= src[i];
+	}
+	return *this;
+}
+
+inline auto utils::dynbitset::operator~() const -> dynbitset {
+	auto result = *this;
+	result.flip();
+	return result;
+}
+
+inline auto utils::operator==(dynbitset const& lhs, dynbitset const& rhs) -> bool {
+	return lhs.size() == rhs.size()
+	    && std::equal(lhs.data(), lhs.data() + lhs.word_count(), rhs.data());
+}
+
+inline auto utils::operator!=(dynbitset const& lhs, dynbitset const& rhs) -> bool {
+	return !(lhs == rhs);
+}
+
+inline auto utils::operator&(dynbitset const& lhs, dynbitset const& rhs) -> dynbitset {
+	auto result = lhs;
+	result &= rhs;
+	return result;
+}
+
+inline auto utils::operator|(dynbitset const& lhs, dynbitset const& rhs) -> dynbitset {
+	auto result = lhs;
+	result |= rhs;
+	return result;
+}
+
+inline auto utils::operator^(dynbitset const& lhs, dynbitset const& rhs) -> dynbitset {
+	auto result = lhs;
+	result ^= rhs;
+	return result;
+}
+
+//============================================================
+// Helpers
+//============================================================
+
+inline void utils::dynbitset::ensure_same_size(dynbitset const& other, char const* operation) const {
+	if (size() != other.size()) {
+		using namespace std::string_literals;
+		throw std::invalid_argument{
+			"cannot "s + operation + " dynbitset of size " +
+			std::to_string(other.size()) +
+			" into dynbitset of size " +
+			std::to_string(size())
+		};
+	}
+}
+
+inline void utils::dynbitset::sanitize() {
+	auto const tail = m_size % bits_per_word;
+	if (tail != 0) {
+		m_words.back() &= (word_type{1} << tail) - 1;
+	}
+}
+
+#endif // UTILS_DYNBITSET_HPP
@@ -0,0 +1,490 @@
+//===---------------------------------------------------------
+//                       EYTZINGER_INDEX
+//===---------------------------------------------------------
+//
+// Read-only search indices over sorted dynarrays with cache
+// friendly memory layouts.
+//
+// Binary search over a sorted array touches a different
+// cache line on almost every probe and the probes of the
+// upper levels are spread over the whole array. Both
+// indices in this header copy the keys once into a layout
+// where the keys probed after each other are close to each
+// other in memory:
+//
+// - eytzinger_index stores the implicit binary search tree
+//   in breadth-first order. Its search loop is branchless and
+//   prefetches the cache line holding the descendants
+//   log2(64 / sizeof(T)) levels further down, which exactly
+//   fill that line: 3 levels for 64-bit keys and 4 levels
+//   for 32-bit keys.
+//
+// - stree_index stores an implicit static B-tree whose nodes
+//   hold one cache line of keys each. The nodes are compared
+//   with SIMD instructions for 32-bit and 64-bit integer keys
+//   when AVX2 is available (see cpu_dispatch.hpp).
+//
+// Search results are positions in the original sorted array.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_EYTZINGER_INDEX_HPP
+#define UTILS_EYTZINGER_INDEX_HPP
+
+// headers used by declaration site
+#include "cpu_dispatch.hpp"
+#include "dynarray.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// headers used by definition site
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+
+namespace utils {
+	/// Search index storing a sorted dynarray in Eytzinger (breadth-first) order.
+	template<typename T>
+	class eytzinger_index {
+	public:
+		using value_type = T;
+		using size_type  = size_t;
+
+		/// Builds the index from the ascending \sorted keys.
+		/// Throws an invalid_argument exception if \sorted is not sorted or holds NaN.
+		explicit eytzinger_index(dynarray<T> const& sorted);
+
+		eytzinger_index(eytzinger_index &&) = default;
+		auto operator=(eytzinger_index &&) -> eytzinger_index & = default;
+
+		eytzinger_index(eytzinger_index const&) = delete;
+		auto operator=(eytzinger_index const&) -> eytzinger_index & = delete;
+
+		/// Returns the position of the first key not less than \key in the
+		/// original sorted dynarray or size() if there is none.
+		auto lower_bound(T const& key) const -> size_type;
+
+		/// Returns the position of a key equal to \key in the original sorted
+		/// dynarray or size() if there is none.
+		auto find(T const& key) const -> size_type;
+
+		/// Returns `true` if the index contains \key.
+		auto contains(T const& key) const -> bool;
+
+		/// Returns the number of indexed keys.
+		auto size() const -> size_type;
+
+		/// Returns the number of bytes allocated by the index.
+		auto memory_usage() const -> size_type;
+
+	private:
+		/// Returns the tree node holding the lower bound of \key or 0 if there is none.
+		auto lower_bound_node(T const& key) const -> size_type;
+
+		size_type        m_size;
+		dynarray<T>      m_storage;
+		T *              m_tree;
+		dynarray<size_t> m_ranks;
+	};
+
+	/// Search index storing a sorted dynarray as an implicit static B-tree
+	/// (S-tree) with one cache line of keys per node. Requires arithmetic keys.
+	template<typename T>
+	class stree_index {
+		static_assert(std::is_arithmetic<T>::value, "stree_index requires arithmetic key types");
+
+	public:
+		using value_type = T;
+		using size_type  = size_t;
+
+		/// The number of keys per node.
+		static constexpr size_type node_size = 64 / sizeof(T);
+
+		/// Builds the index from the ascending \sorted keys.
+		/// Throws an invalid_argument exception if \sorted is not sorted or holds NaN.
+		explicit stree_index(dynarray<T> const& sorted);
+
+		stree_index(stree_index &&) = default;
+		auto operator=(stree_index &&) -> stree_index & = default;
+
+		stree_index(stree_index const&) = delete;
+		auto operator=(stree_index const&) -> stree_index & = delete;
+
+		/// Returns the position of the first key not less than \key in the
+		/// original sorted dynarray or size() if there is none.
+		auto lower_bound(T const& key) const -> size_type;
+
+		/// Returns the position of a key equal to \key in the original sorted
+		/// dynarray or size() if there is none.
+		auto find(T const& key) const -> size_type;
+
+		/// Returns `true` if the index contains \key.
+		auto contains(T const& key) const -> bool;
+
+		/// Returns the number of indexed keys.
+		auto size() const -> size_type;
+
+		/// Returns the number of bytes allocated by the index.
+		auto memory_usage() const -> size_type;
+
+	private:
+		/// Returns the slot holding the lower bound of \key or size() if there is none.
+		auto lower_bound_slot(T const& key) const -> size_type;
+
+		size_type        m_size;
+		size_type        m_node_count;
+		dynarray<T>      m_storage;
+		T *              m_nodes;
+		dynarray<size_t> m_ranks;
+	};
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace detail {
+		constexpr size_t search_line_size = 64;
+
+		/// Returns the number of elements to skip from \data to the first
+		/// element that starts a cache line. Never more than search_line_size / sizeof(T).
+		template<typename T>
+		auto search_line_offset(T const* data) -> size_t {
+			auto const misalignment = reinterpret_cast<std::uintptr_t>(data) % search_line_size;
+			return misalignment == 0 ? 0 : (search_line_size - misalignment) / sizeof(T);
+		}
+
+		inline auto count_trailing_zeros(size_t value) -> unsigned {
+#if defined(__GNUC__) || defined(__clang__)
+			return static_cast<unsigned>(__builtin_ctzll(value));
+#else
+			unsigned result = 0;
+			for (; (value & 1) == 0; value >>= 1) {
+				++result;
+			}
+			return result;
+#endif
+		}
+
+		template<typename T>
+		auto has_nan_keys(dynarray<T> const&, std::false_type) -> bool {
+			return false;
+		}
+
+		template<typename T>
+		auto has_nan_keys(dynarray<T> const& sorted, std::true_type) -> bool {
+			return std::any_of(sorted.begin(), sorted.end(), [](T key) { return std::isnan(key); });
+		}
+
+		template<typename T>
+		void ensure_sorted_keys(dynarray<T> const& sorted, char const* index) {
+			using namespace std::string_literals;
+			// NaN is unordered: it would break the search order and could lose against padding.
+			if (has_nan_keys(sorted, std::is_floating_point<T>{})) {
+				throw std::invalid_argument{"cannot build "s + index + " from NaN keys"};
+			}
+			if (!std::is_sorted(sorted.begin(), sorted.end())) {
+				throw std::invalid_argument{"cannot build "s + index + " from unsorted keys"};
+			}
+		}
+
+		/// Returns the value padding the slots after the last key. No key compares
+		/// greater, so padding comes after equal keys in order and never wins over them.
+		template<typename T>
+		constexpr auto stree_padding() -> T {
+			return std::numeric_limits<T>::has_infinity
+				? std::numeric_limits<T>::infinity()
+				: std::numeric_limits<T>::max();
+		}
+
+		/// Assigns the keys from \next onward to the subtree of \node in-order.
+		template<typename T>
+		void eytzinger_fill(dynarray<T> const& sorted, T * tree, size_t * ranks, size_t node, size_t & next) {
+			if (node > sorted.size()) {
+				return;
+			}
+			eytzinger_fill(sorted, tree, ranks, 2 * node, next);
+			tree[node] = sorted[next];
+			ranks[node] = next;
+			++next;
+			eytzinger_fill(sorted, tree, ranks, 2 * node + 1, next);
+		}
+
+		/// Assigns the keys from \next onward to the subtree of \node in-order.
+		/// Slots after the last key are padded with stree_padding<T>().
+		template<typename T>
+		void stree_fill(
+			dynarray<T> const& sorted, T * nodes, size_t * ranks,
+			size_t node_size, size_t node_count, size_t node, size_t & next
+		) {
+			if (node >= node_count) {
+				return;
+			}
+			for (size_t slot = 0; slot <= node_size; ++slot) {
+				stree_fill(sorted, nodes, ranks, node_size, node_count, node * (node_size + 1) + slot + 1, next);
+				if (slot == node_size) {
+					break;
+				}
+				auto const index = node * node_size + slot;
+				if (next < sorted.size()) {
+					nodes[index] = sorted[next];
+					ranks[index] = next;
+					++next;
+				}
+				else {
+					nodes[index] = stree_padding<T>();
+					ranks[index] = sorted.size();
+				}
+			}
+		}
+
+		/// Returns the number of keys in \node less than \key.
+		template<typename T, size_t NodeSize>
+		auto stree_rank(T const* node, T key) -> size_t {
+			size_t rank = 0;
+			for (size_t i = 0; i != NodeSize; ++i) {
+				rank += static_cast<size_t>(node[i] < key);
+			}
+			return rank;
+		}
+
+		/// Returns the slot holding the lower bound of \key or \size if there is none.
+		template<typename T, size_t NodeSize, typename Rank>
+		auto stree_search(T const* nodes, size_t node_count, T key, Rank rank) -> size_t {
+			size_t result = node_count * NodeSize;
+			size_t node = 0;
+			while (node < node_count) {
+				auto const slot = rank(nodes + node * NodeSize, key);
+				// Keys of deeper nodes are less than every key found so far.
+				result = slot < NodeSize ? node * NodeSize + slot : result;
+				node = node * (NodeSize + 1) + slot + 1;
+			}
+			return result;
+		}
+
+		/// Keys whose nodes are compared with AVX2 instructions.
+		template<typename T, typename = void>
+		struct stree_avx2_key : std::false_type {};
+
+		template<typename T>
+		struct stree_avx2_key<T, std::enable_if_t<
+			std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+			(sizeof(T) == 4 || sizeof(T) == 8)>> : std::true_type {};
+
+#if defined(UTILS_SIMD_X86)
+		/// Signed comparison of biased keys: the sign bit of unsigned keys is flipped.
+		template<typename T>
+		constexpr auto stree_bias() -> std::make_unsigned_t<T> {
+			return std::is_signed<T>::value
+				? std::make_unsigned_t<T>{0}
+				: static_cast<std::make_unsigned_t<T>>(std::make_unsigned_t<T>{1} << (sizeof(T) * 8 - 1));
+		}
+
+		/// The keys of a node are sorted, hence the keys less than \key form a prefix.
+		template<typename T>
+		UTILS_SIMD_TARGET("avx2")
+		auto stree_rank_avx2(T const* node, T key, std::integral_constant<size_t, 4>) -> size_t {
+			auto const bias = _mm256_set1_epi32(static_cast<int>(stree_bias<T>()));
+			auto const k = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(key)), bias);
+			auto const lo = _mm256_xor_si256(_mm256_load_si256(reinterpret_cast<__m256i const*>(node)), bias);
+			auto const hi = _mm256_xor_si256(_mm256_load_si256(reinterpret_cast<__m256i const*>(node) + 1), bias);
+			auto const mask =
+				static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, lo)))) |
+				static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, hi)))) << 8;
+			return static_cast<size_t>(__builtin_ctz(~mask));
+		}
+
+		template<typename T>
+		UTILS_SIMD_TARGET("avx2")
+		auto stree_rank_avx2(T const* node, T key, std::integral_constant<size_t, 8>) -> size_t {
+			auto const bias = _mm256_set1_epi64x(static_cast<long long>(stree_bias<T>()));
+			auto const k = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(key)), bias);
+			auto const lo = _mm256_xor_si256(_mm256_load_si256(reinterpret_cast<__m256i const*>(node)), bias);
+			auto const hi = _mm256_xor_si256(_mm256_load_si256(reinterpret_cast<__m256i const*>(node) + 1), bias);
+			auto const mask =
+				static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, lo)))) |
+				static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, hi)))) << 4;
+			return static_cast<size_t>(__builtin_ctz(~mask));
+		}
+
+		struct stree_rank_avx2_fn {
+			template<typename T>
+			UTILS_SIMD_TARGET("avx2")
+			auto operator()(T const* node, T key) const -> size_t {
+				return stree_rank_avx2(node, key, std::integral_constant<size_t, sizeof(T)>{});
+			}
+		};
+
+		template<typename T, size_t NodeSize>
+		UTILS_SIMD_TARGET("avx2")
+		auto stree_search_avx2(T const* nodes, size_t node_count, T key) -> size_t {
+			return stree_search<T, NodeSize>(nodes, node_count, key, stree_rank_avx2_fn{});
+		}
+#endif
+
+		template<typename T, size_t NodeSize>
+		auto stree_search_scalar(T const* nodes, size_t node_count, T key) -> size_t {
+			return stree_search<T, NodeSize>(nodes, node_count, key, &stree_rank<T, NodeSize>);
+		}
+
+		template<typename T, size_t NodeSize>
+		auto stree_search_dispatch(T const* nodes, size_t node_count, T key, std::true_type) -> size_t {
+#if defined(UTILS_SIMD_X86)
+			if (cpu::active_isa() >= cpu::isa::avx2) {
+				return stree_search_avx2<T, NodeSize>(nodes, node_count, key);
+			}
+#endif
+			return stree_search_scalar<T, NodeSize>(nodes, node_count, key);
+		}
+
+		template<typename T, size_t NodeSize>
+		auto stree_search_dispatch(T const* nodes, size_t node_count, T key, std::false_type) -> size_t {
+			return stree_search_scalar<T, NodeSize>(nodes, node_count, key);
+		}
+	}
+}
+
+//============================================================
+// Eytzinger layout
+//============================================================
+
+template<typename T>
+utils::eytzinger_index<T>::eytzinger_index(dynarray<T> const& sorted):
+	m_size{sorted.size()},
+	m_storage(sorted.size() + 1 + detail::search_line_size / sizeof(T)),
+	m_tree{nullptr},
+	m_ranks(sorted.size() + 1)
+{
+	detail::ensure_sorted_keys(sorted, "eytzinger_index");
+	// Node 0 is unused such that the children of node k are 2k and 2k + 1
+	// and its descendants some levels down 2^d k to 2^d k + 2^d - 1. With
+	// the tree starting on a cache line these share a single cache line.
+	m_tree = m_storage.data() + detail::search_line_offset(m_storage.data());
+	size_type next = 0;
+	detail::eytzinger_fill(sorted, m_tree, m_ranks.data(), 1, next);
+}
+
+template<typename T>
+auto utils::eytzinger_index<T>::lower_bound_node(T const& key) const -> size_type {
+	constexpr auto keys_per_line = detail::search_line_size / sizeof(T) > 1
+		? detail::search_line_size / sizeof(T) : size_type{1};
+	auto const tree = m_tree;
+	auto const size = m_size;
+	size_type node = 1;
+	while (node <= size) {
+		// Prefetch the descendants log2(keys_per_line) levels down. Prefetching
+		// past the end of the tree is harmless and cheaper than a branch.
+#if defined(__GNUC__) || defined(__clang__)
+		__builtin_prefetch(reinterpret_cast<void const*>(
+			reinterpret_cast<std::uintptr_t>(tree) + node * keys_per_line * sizeof(T)));
+#endif
+		node = 2 * node + static_cast<size_type>(tree[node] < key);
+	}
+	// The search descended right after the last node not less than \key and
+	// left ever since: strip the trailing right turns and the final left turn.
+	return node >> (detail::count_trailing_zeros(~node) + 1);
+}
+
+template<typename T>
+auto utils::eytzinger_index<T>::lower_bound(T const& key) const -> size_type {
+	auto const node = lower_bound_node(key);
+	return node == 0 ? m_size : m_ranks[node];
+}
+
+template<typename T>
+auto utils::eytzinger_index<T>::find(T const& key) const -> size_type {
+	auto const node = lower_bound_node(key);
+	return node == 0 || key < m_tree[node] ? m_size : m_ranks[node];
+}
+
+template<typename T>
+auto utils::eytzinger_index<T>::contains(T const& key) const -> bool {
+	return find(key) != m_size;
+}
+
+template<typename T>
+auto utils::eytzinger_index<T>::size() const -> size_type {
+	return m_size;
+}
+
+template<typename T>
+auto utils::eytzinger_index<T>::memory_usage() const -> size_type {
+	return m_storage.size() * sizeof(T) + m_ranks.size() * sizeof(size_t);
+}
+
+//============================================================
+// S-tree layout
+//============================================================
+
+template<typename T>
+constexpr typename utils::stree_index<T>::size_type utils::stree_index<T>::node_size;
+
+template<typename T>
+utils::stree_index<T>::stree_index(dynarray<T> const& sorted):
+	m_size{sorted.size()},
+	m_node_count{(sorted.size() + node_size - 1) / node_size},
+	m_storage(m_node_count * node_size + node_size),
+	m_nodes{nullptr},
+	m_ranks(m_node_count * node_size)
+{
+	detail::ensure_sorted_keys(sorted, "stree_index");
+	// Node k has the children k(node_size + 1) + 1 to k(node_size + 1) + node_size + 1.
+	m_nodes = m_storage.data() + detail::search_line_offset(m_storage.data());
+	size_type next = 0;
+	detail::stree_fill(sorted, m_nodes, m_ranks.data(), node_size, m_node_count, 0, next);
+}
+
+template<typename T>
+auto utils::stree_index<T>::lower_bound_slot(T const& key) const -> size_type {
+	return detail::stree_search_dispatch<T, node_size>(
+		m_nodes, m_node_count, key, detail::stree_avx2_key<T>{});
+}
+
+template<typename T>
+auto utils::stree_index<T>::lower_bound(T const& key) const -> size_type {
+	auto const slot = lower_bound_slot(key);
+	// Padding slots map to size() as well.
+	return slot == m_ranks.size() ? m_size : m_ranks[slot];
+}
+
+template<typename T>
+auto utils::stree_index<T>::find(T const& key) const -> size_type {
+	auto const slot = lower_bound_slot(key);
+	if (slot == m_ranks.size() || key < m_nodes[slot]) {
+		return m_size;
+	}
+	return m_ranks[slot];
+}
+
+template<typename T>
+auto utils::stree_index<T>::contains(T const& key) const -> bool {
+	return find(key) != m_size;
+}
+
+template<typename T>
+auto utils::stree_index<T>::size() const -> size_type {
+	return m_size;
+}
+
+template<typename T>
+auto utils::stree_index<T>::memory_usage() const -> size_type {
+	return m_storage.size() * sizeof(T) + m_ranks.size() * sizeof(size_t);
+}
+
+#endif // UTILS_EYTZINGER_INDEX_HPP
@@ -0,0 +1,337 @@
+//===---------------------------------------------------------
+//                       LEARNED_INDEX
+//===---------------------------------------------------------
+//
+// Read-only learned index over a sorted dynarray of
+// arithmetic keys.
+//
+// The index approximates the position of a key in the sorted
+// dynarray by piecewise-linear models with a bounded error.
+// The segments are fitted greedily in a single pass with the
+// shrinking cone method such that every distinct key is
+// predicted at most `max_error` positions away from its first
+// occurrence. A lookup evaluates one segment and finishes
+// with a binary search in the small window around the
+// prediction.
+//
+// The segments are indexed recursively by the same kind of
+// models over their first keys until a single segment
+// remains, so a lookup touches a few cache lines per level
+// independent of the number of keys. For nearly uniformly
+// distributed keys like timestamps or identifiers very few
+// segments suffice and the memory overhead is a small
+// fraction of the keys.
+//
+// The index references the elements of the dynarray it was
+// built from, which must outlive the index and must not be
+// modified afterwards.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_LEARNED_INDEX_HPP
+#define UTILS_LEARNED_INDEX_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+
+#include <cstddef>
+#include <type_traits>
+
+// headers used by definition site
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// Read-only index predicting positions in a sorted dynarray of arithmetic keys
+	/// with piecewise-linear models of bounded error.
+	template<typename Key>
+	class learned_index {
+		static_assert(std::is_arithmetic<Key>::value && !std::is_same<Key, bool>::value,
+			"learned_index requires arithmetic key types");
+
+	public:
+		using key_type  = Key;
+		using size_type = size_t;
+
+		/// Maximum prediction error of the segments indexing other segments.
+		static constexpr size_type upper_max_error = 8;
+
+		/// Builds the index over the ascending \sorted keys with segments that predict
+		/// every key at most \max_error positions away from its first occurrence.
+		/// \sorted must outlive the index and must not be modified afterwards.
+		/// Throws an invalid_argument exception if \sorted is not sorted or \max_error is zero.
+		explicit learned_index(dynarray<Key> const& sorted, size_type max_error = 32);
+
+		/// Returns the position of the first key not less than \key in the
+		/// indexed dynarray or size() if there is none.
+		auto lower_bound(Key key) const -> size_type;
+
+		/// Returns the position of the first key equal to \key in the indexed
+		/// dynarray or size() if there is none.
+		auto find(Key key) const -> size_type;
+
+		/// Returns `true` if the indexed dynarray contains \key.
+		auto contains(Key key) const -> bool;
+
+		/// Returns the number of indexed keys.
+		auto size() const -> size_type;
+
+		/// Returns the maximum prediction error of the segments over the keys.
+		auto max_error() const -> size_type;
+
+		/// Returns the number of segments over the keys, excluding upper levels.
+		auto segment_count() const -> size_type;
+
+		/// Returns the number of levels of segments.
+		auto level_count() const -> size_type;
+
+		/// Returns the number of bytes allocated by the index, excluding the keys.
+		auto memory_usage() const -> size_type;
+
+	private:
+		struct segment {
+			Key       first;
+			double    slope;
+			size_type position;
+		};
+
+		/// Returns the position of the first entry not less than \key in the level
+		/// below segment \s. Entry 0 of that level must be less than \key.
+		template<typename KeyAt>
+		auto search(size_type s, size_type end, size_type below_size, size_type error, Key key, KeyAt key_at) const
+			-> size_type;
+
+		Key const*         m_keys;
+		size_type          m_size;
+		size_type          m_max_error;
+		/// Segments of all levels, the level over the keys first.
+		dynarray<segment>  m_segments;
+		/// Level l spans the segments from m_levels[l] to m_levels[l + 1].
+		dynarray<size_type> m_levels;
+	};
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace detail {
+		/// Returns the distance from \first to \key as double; \key must not be less than \first.
+		template<typename Key>
+		auto learned_delta(Key key, Key first) -> std::enable_if_t<std::is_integral<Key>::value, double> {
+			// Subtract in the unsigned domain to avoid overflow and precision loss
+			// of large keys that are close to each other.
+			using unsigned_key = std::make_unsigned_t<Key>;
+			return static_cast<double>(static_cast<unsigned_key>(
+				static_cast<unsigned_key>(key) - static_cast<unsigned_key>(first)));
+		}
+
+		template<typename Key>
+		auto learned_delta(Key key, Key first) -> std::enable_if_t<std::is_floating_point<Key>::value, double> {
+			return static_cast<double>(key) - static_cast<double>(first);
+		}
+
+		/// Fits segments with at most \error prediction error over the first occurrences
+		/// of the \count ascending keys returned by \key_at and appends them to \out.
+		template<typename Segment, typename KeyAt>
+		void learned_fit(size_t count, size_t error, KeyAt key_at, std::vector<Segment> & out) {
+			auto const infinity = std::numeric_limits<double>::infinity();
+			auto const tolerance = static_cast<double>(error);
+			auto current = Segment{key_at(0), 0.0, 0};
+			auto slope_low = 0.0;
+			auto slope_high = infinity;
+			for (size_t i = 1; i < count; ++i) {
+				auto const key = key_at(i);
+				if (!(key_at(i - 1) < key)) {
+					continue;
+				}
+				auto const dx = learned_delta(key, current.first);
+				auto const dy = static_cast<double>(i - current.position);
+				auto const low = std::max(slope_low, (dy - tolerance) / dx);
+				auto const high = std::min(slope_high, (dy + tolerance) / dx);
+				if (low <= high) {
+					slope_low = low;
+					slope_high = high;
+					continue;
+				}
+				current.slope = slope_high == infinity ? 0.0 : (slope_low + slope_high) / 2;
+				out.push_back(current);
+				current = Segment{key, 0.0, i};
+				slope_low = 0.0;
+				slope_high = infinity;
+			}
+			current.slope = slope_high == infinity ? 0.0 : (slope_low + slope_high) / 2;
+			out.push_back(current);
+		}
+
+		/// Returns the position of the first entry in [\first, \last) not less
+		/// than \key or \last if there is none. \key_at returns entries by reference.
+		template<typename Key, typename KeyAt>
+		auto learned_lower_bound(size_t first, size_t last, Key key, KeyAt key_at) -> size_t {
+			if (first == last) {
+				return last;
+			}
+			// Branchless: the windows are small and their outcome unpredictable.
+			auto length = last - first;
+#if defined(__GNUC__) || defined(__clang__)
+			// Fetches the cache lines of the window in parallel instead of one per probe.
+			auto const window_first = reinterpret_cast<char const*>(&key_at(first));
+			auto const window_last = reinterpret_cast<char const*>(&key_at(last - 1));
+			for (auto line = window_first; line <= window_last; line += 64) {
+				__builtin_prefetch(line);
+			}
+			__builtin_prefetch(window_last);
+#endif
+			while (length > 1) {
+				auto const half = length / 2;
+				first = key_at(first + half - 1) < key ? first + half : first;
+				length -= half;
+			}
+			return first + static_cast<size_t>(key_at(first) < key);
+		}
+	}
+}
+
+template<typename Key>
+constexpr typename utils::learned_index<Key>::size_type utils::learned_index<Key>::upper_max_error;
+
+template<typename Key>
+utils::learned_index<Key>::learned_index(dynarray<Key> const& sorted, size_type max_error):
+	m_keys{sorted.data()},
+	m_size{sorted.size()},
+	m_max_error{max_error},
+	m_segments(0),
+	m_levels(0)
+{
+	using namespace std::string_literals;
+	if (max_error == 0) {
+		throw std::invalid_argument{"cannot build learned_index with a maximum error of 0"s};
+	}
+	if (!std::is_sorted(sorted.begin(), sorted.end())) {
+		throw std::invalid_argument{"cannot build learned_index from unsorted keys"s};
+	}
+	if (m_size == 0) {
+		m_levels = dynarray<size_type>(1, size_type{0});
+		return;
+	}
+	auto segments = std::vector<segment>{};
+	auto levels = std::vector<size_type>{0};
+	auto const keys = m_keys;
+	detail::learned_fit(m_size, m_max_error, [keys](size_type i) -> Key const& { return keys[i]; }, segments);
+	levels.push_back(segments.size());
+	while (levels.back() - levels[levels.size() - 2] > 1) {
+		auto const first = levels[levels.size() - 2];
+		auto const count = levels.back() - first;
+		// Reallocation would invalidate references into the lower level, hence the index.
+		detail::learned_fit(count, upper_max_error, [&segments, first](size_type i) -> Key const& {
+			return segments[first + i].first;
+		}, segments);
+		levels.push_back(segments.size());
+	}
+	m_segments = dynarray<segment>(segments.size());
+	std::copy(segments.begin(), segments.end(), m_segments.begin());
+	m_levels = dynarray<size_type>(levels.size());
+	std::copy(levels.begin(), levels.end(), m_levels.begin());
+}
+
+template<typename Key>
+template<typename KeyAt>
+auto utils::learned_index<Key>::search(
+	size_type s, size_type end, size_type below_size, size_type error, Key key, KeyAt key_at
+) const -> size_type {
+	// The answer lies within the entries covered by the segment, bounded by the
+	// first entry of the next segment which is greater than \key.
+	auto const& seg = m_segments[s];
+	auto const first = seg.position;
+	auto const last = s + 1 != end ? m_segments[s + 1].position : below_size;
+	auto const predicted = static_cast<double>(first) + seg.slope * detail::learned_delta(key, seg.first);
+	auto const position = predicted < static_cast<double>(last)
+		? std::max(first, static_cast<size_type>(predicted)) : last;
+	auto const low = position - first > error ? position - error : first;
+	auto const high = last - position > error + 1 ? position + error + 1 : last;
+	auto const result = detail::learned_lower_bound(low, high, key, key_at);
+	// Keys that are not indexed, rounding and runs of duplicates may fall
+	// outside of the window: fall back to searching the rest of the segment.
+	if (result == low && low != first && !(key_at(low - 1) < key)) {
+		return detail::learned_lower_bound(first, low, key, key_at);
+	}
+	if (result == high && high != last) {
+		return detail::learned_lower_bound(high, last, key, key_at);
+	}
+	return result;
+}
+
+template<typename Key>
+auto utils::learned_index<Key>::lower_bound(Key key) const -> size_type {
+	if (m_size == 0 || !(m_keys[0] < key)) {
+		return 0;
+	}
+	// Descend from the single top segment to the segment over the keys
+	// whose first key is the last one less than or equal to \key.
+	auto s = m_levels[m_levels.size() - 2];
+	for (auto level = m_levels.size() - 2; level > 0; --level) {
+		auto const below = m_levels[level - 1];
+		auto const below_size = m_levels[level] - below;
+		auto const segments = m_segments.data() + below;
+		auto const position = search(s, m_levels[level + 1], below_size, upper_max_error, key,
+			[segments](size_type i) -> Key const& { return segments[i].first; });
+		auto const exact = position != below_size && !(key < segments[position].first);
+		s = below + (exact ? position : position - 1);
+	}
+	auto const keys = m_keys;
+	return search(s, m_levels[1], m_size, m_max_error, key, [keys](size_type i) -> Key const& { return keys[i]; });
+}
+
+template<typename Key>
+auto utils::learned_index<Key>::find(Key key) const -> size_type {
+	auto const position = lower_bound(key);
+	return position != m_size && !(key < m_keys[position]) ? position : m_size;
+}
+
+template<typename Key>
+auto utils::learned_index<Key>::contains(Key key) const -> bool {
+	return find(key) != m_size;
+}
+
+template<typename Key>
+auto utils::learned_index<Key>::size() const -> size_type {
+	return m_size;
+}
+
+template<typename Key>
+auto utils::learned_index<Key>::max_error() const -> size_type {
+	return m_max_error;
+}
+
+template<typename Key>
+auto utils::learned_index<Key>::segment_count() const -> size_type {
+	return m_levels.size() > 1 ? m_levels[1] : 0;
+}
+
+template<typename Key>
+auto utils::learned_index<Key>::level_count() const -> size_type {
+	return m_levels.size() - 1;
+}
+
+template<typename Key>
+auto utils::learned_index<Key>::memory_usage() const -> size_type {
+	return m_segments.size() * sizeof(segment) + m_levels.size() * sizeof(size_type);
+}
+
+#endif // UTILS_LEARNED_INDEX_HPP
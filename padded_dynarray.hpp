@@ -0,0 +1,506 @@
+//===---------------------------------------------------------
+//                       PADDED_DYNARRAY
+//===---------------------------------------------------------
+//
+// Variant of the dynarray container where every element
+// occupies its own cache line(s).
+//
+// Intended for per-thread slots such as counters and
+// statistics that are written concurrently by different
+// threads. With a packed layout adjacent slots share a cache
+// line and every write invalidates the line for all the
+// other writers (false sharing).
+//
+// The padding granularity defaults to 64 bytes and can be
+// overridden by defining UTILS_CACHE_LINE_SIZE before
+// including this header, e.g. to 128 for targets with
+// adjacent-line prefetching or 128 byte cache lines.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_PADDED_DYNARRAY_HPP
+#define UTILS_PADDED_DYNARRAY_HPP
+
+// headers used by declaration site
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+// headers used by definition site
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if !defined(UTILS_CACHE_LINE_SIZE)
+	#define UTILS_CACHE_LINE_SIZE 64
+#endif
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// The assumed size of a cache line in bytes.
+	constexpr size_t cache_line_size = UTILS_CACHE_LINE_SIZE;
+
+	static_assert((cache_line_size & (cache_line_size - 1)) == 0,
+		"UTILS_CACHE_LINE_SIZE must be a power of two");
+
+	namespace detail {
+		/// Random-access iterator over elements that are \stride bytes apart.
+		template<typename T>
+		class strided_iterator {
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type        = typename std::remove_cv<T>::type;
+			using difference_type   = std::ptrdiff_t;
+			using reference         = T &;
+			using pointer           = T *;
+
+			strided_iterator(): m_ptr{nullptr}, m_stride{0} {}
+
+			strided_iterator(unsigned char * ptr, size_t stride):
+				m_ptr{ptr},
+				m_stride{stride}
+			{}
+
+			/// Allows to convert a mutable iterator into a read-only one.
+			operator strided_iterator<T const>() const { return {m_ptr, m_stride}; }
+
+			auto operator*() const -> reference { return *reinterpret_cast<pointer>(m_ptr); }
+			auto operator->() const -> pointer { return reinterpret_cast<pointer>(m_ptr); }
+			auto operator[](difference_type n) const -> reference { return *(*this + n); }
+
+			auto operator++() -> strided_iterator & { m_ptr += m_stride; return *this; }
+			auto operator--() -> strided_iterator & { m_ptr -= m_stride; return *this; }
+			auto operator++(int) -> strided_iterator { auto it = *this; ++*this; return it; }
+			auto operator--(int) -> strided_iterator { auto it = *this; --*this; return it; }
+
+			auto operator+=(difference_type n) -> strided_iterator & {
+				m_ptr += n * static_cast<difference_type>(m_stride);
+				return *this;
+			}
+			auto operator-=(difference_type n) -> strided_iterator & {
+				m_ptr -= n * static_cast<difference_type>(m_stride);
+				return *this;
+			}
+			auto operator+(difference_type n) const -> strided_iterator { auto it = *this; return it += n; }
+			auto operator-(difference_type n) const -> strided_iterator { auto it = *this; return it -= n; }
+
+			auto operator-(strided_iterator const& rhs) const -> difference_type {
+				return (m_ptr - rhs.m_ptr) / static_cast<difference_type>(m_stride);
+			}
+
+			auto operator==(strided_iterator const& rhs) const -> bool { return m_ptr == rhs.m_ptr; }
+			auto operator!=(strided_iterator const& rhs) const -> bool { return m_ptr != rhs.m_ptr; }
+			auto operator< (strided_iterator const& rhs) const -> bool { return m_ptr <  rhs.m_ptr; }
+			auto operator> (strided_iterator const& rhs) const -> bool { return m_ptr >  rhs.m_ptr; }
+			auto operator<=(strided_iterator const& rhs) const -> bool { return m_ptr <= rhs.m_ptr; }
+			auto operator>=(strided_iterator const& rhs) const -> bool { return m_ptr >= rhs.m_ptr; }
+
+		private:
+			unsigned char * m_ptr;
+			size_t          m_stride;
+		};
+	}
+
+	/// Fixed-size array that places every element at the start of its own
+	/// cache line. The distance between two adjacent elements (stride) is
+	/// sizeof(T) rounded up to a multiple of cache_line_size.
+	///
+	/// In contrast to dynarray the elements are not contiguous and thus
+	/// there is no data() member. Iterators are random-access but step
+	/// over the padding between the elements.
+	template<typename T>
+	class padded_dynarray {
+	public:
+
+	//============================================================
+	// Type aliases
+	//============================================================
+
+		using value_type             = T;
+		using size_type              = size_t;
+		using difference_type        = std::ptrdiff_t;
+		using reference              = value_type &;
+		using const_reference        = value_type const&;
+		using iterator               = detail::strided_iterator<T>;
+		using const_iterator         = detail::strided_iterator<T const>;
+
+		/// The distance in bytes between two adjacent elements.
+		static constexpr size_type stride =
+			(sizeof(T) + cache_line_size - 1) / cache_line_size * cache_line_size;
+
+		/// The alignment of every element.
+		static constexpr size_type alignment =
+			alignof(T) > cache_line_size ? alignof(T) : cache_line_size;
+
+	//============================================================
+	// Constructors
+	//============================================================
+
+	// (1) construct by count with value-initialized elements
+	//============================================================
+		explicit padded_dynarray(size_type count);
+
+	// (2) construct by count and copied value
+	//============================================================
+		padded_dynarray(size_type count, T const& value);
+
+	// (3) move-construct
+	//============================================================
+		padded_dynarray(padded_dynarray && other);
+
+		~padded_dynarray();
+
+		padded_dynarray(padded_dynarray const&) = delete;
+		auto operator=(padded_dynarray const&) -> padded_dynarray & = delete;
+
+		/// Move-Assigns from the specified \other padded_dynarray instance.
+		auto operator=(padded_dynarray && other) -> padded_dynarray &;
+
+	//============================================================
+	// Access API
+	//============================================================
+
+		/// Access the element at the specified position \pos with bounds checking.
+		/// Throws out_of_bounds exception if \pos was illegal.
+		auto at(size_type pos) -> reference;
+
+		/// Read-only access to the element at the specified position \pos with bounds checking.
+		/// Throws out_of_bounds exception if \pos was illegal.
+		auto at(size_type pos) const -> const_reference;
+
+		/// Access the element at the specified position \pos without bounds checking.
+		auto operator[](size_type pos) -> reference;
+
+		/// Read-only access the element at the specified position \pos without bounds checking.
+		auto operator[](size_type pos) const -> const_reference;
+
+		/// Access the first element.
+		auto front() -> reference;
+
+		/// Read-only access the first element.
+		auto front() const -> const_reference;
+
+		/// Access the last element.
+		auto back() -> reference;
+
+		/// Read-only access the last element.
+		auto back() const -> const_reference;
+
+	//============================================================
+	// Capacity API
+	//============================================================
+
+		/// Returns `true` if this padded_dynarray is empty and `false` otherwise.
+		auto empty() const -> bool;
+
+		/// Returns the count of elements in this padded_dynarray.
+		auto size() const -> size_type;
+
+	//============================================================
+	// Aggregate API
+	//============================================================
+
+		/// Folds all elements into \init by successively applying `init = op(init, element)`.
+		template<typename R, typename BinaryOp>
+		auto reduce(R init, BinaryOp op) const -> R;
+
+		/// Returns the sum of \init and all elements.
+		/// For atomic elements every slot is read with a sequentially consistent load.
+		template<typename R>
+		auto sum(R init) const -> R;
+
+		/// Invokes \f for every element.
+		template<typename F>
+		void for_each(F && f);
+
+		/// Invokes \f for every element.
+		template<typename F>
+		void for_each(F && f) const;
+
+	//============================================================
+	// Iterator API
+	//============================================================
+
+		/// Returns an iterator to the first element in this padded_dynarray.
+		auto begin()        -> iterator;
+
+		/// Returns a read-only iterator to the first element in this padded_dynarray.
+		auto begin() const  -> const_iterator;
+
+		/// Returns a read-only iterator to the first element in this padded_dynarray.
+		auto cbegin() const -> const_iterator;
+
+		/// Returns an iterator to the position behind the last element in this padded_dynarray.
+		auto end()        -> iterator;
+
+		/// Returns a read-only iterator to the position behind the last element in this padded_dynarray.
+		auto end() const  -> const_iterator;
+
+		/// Returns a read-only iterator to the position behind the last element in this padded_dynarray.
+		auto cend() const -> const_iterator;
+
+	//============================================================
+	// Member Variables
+	//============================================================
+
+	private:
+		/// Allocates the padded buffer and constructs all elements by calling \init.
+		template<typename Init>
+		void create(Init init);
+
+		auto slot(size_type pos) const -> unsigned char *;
+
+		std::unique_ptr<unsigned char[]> m_buffer;
+		unsigned char *                  m_first;
+		size_type                        m_size;
+	};
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+template<typename T>
+constexpr typename utils::padded_dynarray<T>::size_type utils::padded_dynarray<T>::stride;
+
+template<typename T>
+constexpr typename utils::padded_dynarray<T>::size_type utils::padded_dynarray<T>::alignment;
+
+template<typename T>
+template<typename Init>
+void utils::padded_dynarray<T>::create(Init init) {
+	m_buffer.reset(new unsigned char[m_size * stride + alignment - 1]);
+	auto const base = reinterpret_cast<std::uintptr_t>(m_buffer.get());
+	m_first = m_buffer.get() + ((alignment - base % alignment) % alignment);
+	size_type constructed = 0;
+	try {
+		for (; constructed != m_size; ++constructed) {
+			init(slot(constructed));
+		}
+	}
+	catch (...) {
+		for (size_type i = 0; i != constructed; ++i) {
+			(*this)[i].~T();
+		}
+		throw;
+	}
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::slot(size_type pos) const -> unsigned char * {
+	return m_first + pos * stride;
+}
+
+//============================================================
+// Constructors
+//============================================================
+
+// (1) construct by count with value-initialized elements
+//============================================================
+template<typename T>
+utils::padded_dynarray<T>::padded_dynarray(size_type count):
+	m_buffer{},
+	m_first{nullptr},
+	m_size{count}
+{
+	// Value-initialized so that slots of atomics and other scalars start at zero.
+	create([](unsigned char * ptr) { ::new (static_cast<void *>(ptr)) T(); });
+}
+
+// (2) construct by count and copied value
+//============================================================
+template<typename T>
+utils::padded_dynarray<T>::padded_dynarray(size_type count, T const& value):
+	m_buffer{},
+	m_first{nullptr},
+	m_size{count}
+{
+	create([&value](unsigned char * ptr) { ::new (static_cast<void *>(ptr)) T(value); });
+}
+
+// (3) move-construct
+//============================================================
+template<typename T>
+utils::padded_dynarray<T>::padded_dynarray(padded_dynarray && other):
+	m_buffer{std::move(other.m_buffer)},
+	m_first{other.m_first},
+	m_size{other.m_size}
+{
+	other.m_first = nullptr;
+	other.m_size = 0;
+}
+
+template<typename T>
+utils::padded_dynarray<T>::~padded_dynarray() {
+	for (size_type i = 0; i != m_size; ++i) {
+		(*this)[i].~T();
+	}
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::operator=(padded_dynarray && other) -> padded_dynarray & {
+	std::swap(m_buffer, other.m_buffer);
+	std::swap(m_first, other.m_first);
+	std::swap(m_size, other.m_size);
+	return *this;
+}
+
+//============================================================
+// Access API
+//============================================================
+
+template<typename T>
+auto utils::padded_dynarray<T>::at(size_type pos) -> reference {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access element at position "s +
+			std::to_string(pos) +
+			" from a padded_dynarray with size " +
+			std::to_string(size())
+		};
+	}
+	return (*this)[pos];
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::at(size_type pos) const -> const_reference {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access element at position "s +
+			std::to_string(pos) +
+			" from a padded_dynarray with size " +
+			std::to_string(size())
+		};
+	}
+	return (*this)[pos];
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::operator[](size_type pos) -> reference {
+	return *reinterpret_cast<T *>(slot(pos));
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::operator[](size_type pos) const -> const_reference {
+	return *reinterpret_cast<T const*>(slot(pos));
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::front() -> reference {
+	return (*this)[0];
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::front() const -> const_reference {
+	return (*this)[0];
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::back() -> reference {
+	return (*this)[size() - 1];
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::back() const -> const_reference {
+	return (*this)[size() - 1];
+}
+
+//============================================================
+// Capacity API
+//============================================================
+
+template<typename T>
+auto utils::padded_dynarray<T>::empty() const -> bool {
+	return m_size == 0;
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::size() const -> size_type {
+	return m_size;
+}
+
+//============================================================
+// Aggregate API
+//============================================================
+
+template<typename T>
+template<typename R, typename BinaryOp>
+auto utils::padded_dynarray<T>::reduce(R init, BinaryOp op) const -> R {
+	for (size_type i = 0; i != m_size; ++i) {
+		init = op(std::move(init), (*this)[i]);
+	}
+	return init;
+}
+
+template<typename T>
+template<typename R>
+auto utils::padded_dynarray<T>::sum(R init) const -> R {
+	return reduce(std::move(init), [](R acc, T const& element) -> R { return acc + element; });
+}
+
+template<typename T>
+template<typename F>
+void utils::padded_dynarray<T>::for_each(F && f) {
+	for (size_type i = 0; i != m_size; ++i) {
+		f((*this)[i]);
+	}
+}
+
+template<typename T>
+template<typename F>
+void utils::padded_dynarray<T>::for_each(F && f) const {
+	for (size_type i = 0; i != m_size; ++i) {
+		f((*this)[i]);
+	}
+}
+
+//============================================================
+// Iterator API
+//============================================================
+
+template<typename T>
+auto utils::padded_dynarray<T>::begin() -> iterator {
+	return iterator{slot(0), stride};
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::begin() const -> const_iterator {
+	return const_iterator{slot(0), stride};
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::cbegin() const -> const_iterator {
+	return const_iterator{slot(0), stride};
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::end() -> iterator {
+	return iterator{slot(m_size), stride};
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::end() const -> const_iterator {
+	return const_iterator{slot(m_size), stride};
+}
+
+template<typename T>
+auto utils::padded_dynarray<T>::cend() const -> const_iterator {
+	return const_iterator{slot(m_size), stride};
+}
+
+#endif // UTILS_PADDED_DYNARRAY_HPP
@@ -0,0 +1,227 @@
+//===---------------------------------------------------------
+//                       RADIX_SORT
+//===---------------------------------------------------------
+//
+// Parallel stable least-significant-digit radix sort for
+// dynarrays of integer and floating point keys, optionally
+// permuting a dynarray of values alongside.
+//
+// Keys are sorted by their 8-bit digits from the least to
+// the most significant one. Every pass splits the elements
+// into one contiguous block per thread: each block counts
+// its digits into a private histogram, the histograms are
+// combined into per-block output offsets in block order and
+// finally every block scatters its elements to the offsets,
+// which keeps the sort stable. Passes in which all keys
+// share the same digit are skipped.
+//
+// Since the size of a dynarray is fixed the scratch buffer
+// is allocated exactly once with the size of the input.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_RADIX_SORT_HPP
+#define UTILS_RADIX_SORT_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+
+#include <cstddef>
+
+// headers used by definition site
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// Sorts \keys in ascending order. Stable.
+	///
+	/// Signed integers are ordered by value. Floating point keys are
+	/// ordered by value as well with -0.0 before +0.0, negative NaNs
+	/// before all other keys and positive NaNs after all other keys.
+	template<typename K>
+	void radix_sort(dynarray<K> & keys);
+
+	/// Sorts \keys in ascending order and applies the same permutation to
+	/// \values. Stable, i.e. values of equal keys keep their relative order.
+	/// Throws an invalid_argument exception when the sizes are unequal.
+	/// V must be default constructible and move assignable.
+	template<typename K, typename V>
+	void radix_sort(dynarray<K> & keys, dynarray<V> & values);
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace detail {
+		/// Maps keys to unsigned integers with the same order.
+		template<typename K, typename = void>
+		struct radix_key;
+
+		template<typename K>
+		struct radix_key<K, std::enable_if_t<std::is_integral<K>::value && std::is_unsigned<K>::value>> {
+			using type = K;
+			static auto convert(K key) -> type { return key; }
+		};
+
+		template<typename K>
+		struct radix_key<K, std::enable_if_t<std::is_integral<K>::value && std::is_signed<K>::value>> {
+			using type = std::make_unsigned_t<K>;
+			static auto convert(K key) -> type {
+				// Flipping the sign bit moves negative numbers below positive ones.
+				return static_cast<type>(static_cast<type>(key) ^ (type{1} << (sizeof(K) * 8 - 1)));
+			}
+		};
+
+		template<typename K>
+		struct radix_key<K, std::enable_if_t<std::is_floating_point<K>::value>> {
+			static_assert(sizeof(K) == 4 || sizeof(K) == 8,
+				"radix_sort supports only 32-bit and 64-bit floating point keys");
+			using type = std::conditional_t<sizeof(K) == 4, std::uint32_t, std::uint64_t>;
+			static auto convert(K key) -> type {
+				type bits;
+				std::memcpy(&bits, &key, sizeof(K));
+				// Negative numbers are ordered reversed and below positive ones:
+				// flip all bits of negative numbers and the sign bit of the others.
+				auto const sign = type{1} << (sizeof(K) * 8 - 1);
+				return (bits & sign) != 0 ? static_cast<type>(~bits) : static_cast<type>(bits | sign);
+			}
+		};
+
+		/// Placeholder value type for sorting keys only.
+		struct radix_no_value {};
+
+		/// Elements per thread below which fewer blocks are used.
+		constexpr size_t radix_min_block_size = 64 * 1024;
+
+		constexpr size_t radix_buckets = 256;
+
+		template<typename K, typename V>
+		void radix_sort(K * keys, V * values, size_t size) {
+			using traits = radix_key<K>;
+			constexpr bool has_values = !std::is_same<V, radix_no_value>::value;
+
+			if (size < 2) {
+				return;
+			}
+			auto & pool = thread_pool::instance();
+			auto const blocks = std::max<size_t>(1, std::min(pool.concurrency(), size / radix_min_block_size));
+			auto const block_first = [&](size_t block) { return block * size / blocks; };
+			auto for_each_block = [&](auto && f) {
+				pool.parallel_for(0, blocks, 1, [&](size_t first, size_t last) {
+					for (auto block = first; block != last; ++block) {
+						f(block, block_first(block), block_first(block + 1));
+					}
+				});
+			};
+
+			auto key_buffer = dynarray<K>(size);
+			auto value_buffer = dynarray<V>(has_values ? size : 0);
+			auto counts = dynarray<size_t>(blocks * radix_buckets);
+
+			K * src_keys = keys;
+			K * dst_keys = key_buffer.data();
+			V * src_values = values;
+			V * dst_values = value_buffer.data();
+
+			for (size_t pass = 0; pass != sizeof(K); ++pass) {
+				auto const shift = pass * 8;
+				auto const digit = [shift](K key) {
+					return static_cast<size_t>((traits::convert(key) >> shift) & (radix_buckets - 1));
+				};
+
+				for_each_block([&](size_t block, size_t first, size_t last) {
+					auto const histogram = counts.data() + block * radix_buckets;
+					std::fill(histogram, histogram + radix_buckets, size_t{0});
+					for (auto i = first; i != last; ++i) {
+						++histogram[digit(src_keys[i])];
+					}
+				});
+
+				// Turn the counts into output offsets ordered by digit first and
+				// by block second. A pass where one digit holds all keys is a no-op.
+				auto skip = false;
+				auto offset = size_t{0};
+				for (size_t d = 0; d != radix_buckets && !skip; ++d) {
+					auto const digit_first = offset;
+					for (size_t block = 0; block != blocks; ++block) {
+						auto & count = counts[block * radix_buckets + d];
+						auto const n = count;
+						count = offset;
+						offset += n;
+					}
+					skip = offset - digit_first == size;
+				}
+				if (skip) {
+					continue;
+				}
+
+				for_each_block([&](size_t block, size_t first, size_t last) {
+					auto const offsets = counts.data() + block * radix_buckets;
+					for (auto i = first; i != last; ++i) {
+						auto const position = offsets[digit(src_keys[i])]++;
+						dst_keys[position] = src_keys[i];
+						if (has_values) {
+							dst_values[position] = std::move(src_values[i]);
+						}
+					}
+				});
+				std::swap(src_keys, dst_keys);
+				std::swap(src_values, dst_values);
+			}
+
+			if (src_keys != keys) {
+				for_each_block([&](size_t, size_t first, size_t last) {
+					std::copy(src_keys + first, src_keys + last, keys + first);
+					if (has_values) {
+						std::move(src_values + first, src_values + last, values + first);
+					}
+				});
+			}
+		}
+	}
+}
+
+template<typename K>
+void utils::radix_sort(dynarray<K> & keys) {
+	static_assert((std::is_integral<K>::value && !std::is_same<K, bool>::value) || std::is_floating_point<K>::value,
+		"radix_sort requires integral or floating point keys");
+	detail::radix_sort<K, detail::radix_no_value>(keys.data(), nullptr, keys.size());
+}
+
+template<typename K, typename V>
+void utils::radix_sort(dynarray<K> & keys, dynarray<V> & values) {
+	static_assert((std::is_integral<K>::value && !std::is_same<K, bool>::value) || std::is_floating_point<K>::value,
+		"radix_sort requires integral or floating point keys");
+	if (keys.size() != values.size()) {
+		using namespace std::string_literals;
+		throw std::invalid_argument{
+			"cannot radix_sort dynarray of size "s +
+			std::to_string(keys.size()) +
+			" along with values of size " +
+			std::to_string(values.size())
+		};
+	}
+	detail::radix_sort(keys.data(), values.data(), keys.size());
+}
+
+#endif // UTILS_RADIX_SORT_HPP
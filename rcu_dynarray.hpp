@@ -0,0 +1,424 @@
+//===---------------------------------------------------------
+//                       RCU_DYNARRAY
+//===---------------------------------------------------------
+//
+// Read-copy-update publisher for whole dynarray instances.
+//
+// Writers build a new dynarray and publish it with a single
+// atomic pointer exchange. Readers pin the currently
+// published dynarray with a wait-free read guard and never
+// block on writers or on each other.
+//
+// Replaced dynarrays are reclaimed through epoch-based
+// reclamation: every reader announces the global epoch in
+// its own cache-line padded slot while it holds a guard,
+// and a replaced dynarray is destroyed once no announced
+// epoch is old enough to still observe it.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_RCU_DYNARRAY_HPP
+#define UTILS_RCU_DYNARRAY_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// headers used by definition site
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// Publishes a dynarray<T> to many concurrent readers and allows
+	/// writers to atomically replace it as a whole.
+	///
+	/// Every reader thread obtains its own reader handle via make_reader()
+	/// once and uses it to acquire read guards. The number of concurrent
+	/// reader handles is fixed at construction just like the size of a
+	/// dynarray so that no allocation happens on the read path.
+	///
+	/// Acquiring and releasing a read guard is wait-free and touches
+	/// only the cache line of the reader's own slot and the shared,
+	/// read-mostly epoch and pointer. Writers are serialized by a mutex
+	/// and may allocate; they are expected to be rare.
+	///
+	/// All reader handles must be destroyed before the rcu_dynarray.
+	template<typename T>
+	class rcu_dynarray {
+		struct reader_slot;
+
+	public:
+
+	//============================================================
+	// Type aliases
+	//============================================================
+
+		using value_type = dynarray<T>;
+		using size_type  = size_t;
+		using epoch_type = std::uint64_t;
+
+		/// Pins the dynarray that was published at the time of its
+		/// construction. The pinned dynarray stays alive until the
+		/// guard is destroyed even if it is replaced meanwhile.
+		///
+		/// A reader must hold at most one guard at a time.
+		class read_guard {
+		public:
+			read_guard(read_guard && other);
+			~read_guard();
+
+			read_guard(read_guard const&) = delete;
+			auto operator=(read_guard const&) -> read_guard & = delete;
+			auto operator=(read_guard &&) -> read_guard & = delete;
+
+			/// Returns the pinned dynarray.
+			auto get() const -> value_type const&;
+
+			auto operator*() const -> value_type const&;
+			auto operator->() const -> value_type const*;
+
+		private:
+			friend class rcu_dynarray;
+
+			read_guard(reader_slot & slot, value_type const* array);
+
+			reader_slot *      m_slot;
+			value_type const * m_array;
+		};
+
+		/// Handle that owns one reader slot of an rcu_dynarray.
+		/// A reader handle must only be used by a single thread at a time.
+		class reader {
+		public:
+			reader(reader && other);
+			~reader();
+
+			reader(reader const&) = delete;
+			auto operator=(reader const&) -> reader & = delete;
+			auto operator=(reader &&) -> reader & = delete;
+
+			/// Pins and returns a guard to the currently published dynarray.
+			/// This is wait-free.
+			auto read() const -> read_guard;
+
+		private:
+			friend class rcu_dynarray;
+
+			reader(rcu_dynarray & owner, reader_slot & slot);
+
+			rcu_dynarray * m_owner;
+			reader_slot *  m_slot;
+		};
+
+	//============================================================
+	// Constructors
+	//============================================================
+
+		/// Publishes \initial and provides slots for up to \max_readers reader handles.
+		explicit rcu_dynarray(dynarray<T> && initial, size_type max_readers = 128);
+
+		~rcu_dynarray();
+
+		rcu_dynarray(rcu_dynarray const&) = delete;
+		auto operator=(rcu_dynarray const&) -> rcu_dynarray & = delete;
+
+	//============================================================
+	// Reader API
+	//============================================================
+
+		/// Claims a free reader slot and returns its handle.
+		/// Throws a length_error exception if all slots are in use.
+		auto make_reader() -> reader;
+
+		/// Returns the number of reader slots.
+		auto max_readers() const -> size_type;
+
+	//============================================================
+	// Writer API
+	//============================================================
+
+		/// Atomically replaces the published dynarray by \next.
+		/// The replaced dynarray is destroyed as soon as no reader
+		/// can observe it anymore, possibly during a later call.
+		void publish(dynarray<T> && next);
+
+		/// Publishes a modified copy of the currently published dynarray.
+		/// \modify is invoked with a mutable reference to the copy while
+		/// other writers are blocked, so concurrent updates are never lost.
+		template<typename Modify>
+		void update(Modify && modify);
+
+		/// Blocks until all replaced dynarrays have been destroyed.
+		/// Must not be called while the calling thread holds a read guard.
+		void synchronize();
+
+		/// Returns the number of replaced dynarrays that are awaiting destruction.
+		auto pending_reclamations() const -> size_type;
+
+	//============================================================
+	// Member Variables
+	//============================================================
+
+	private:
+		static constexpr size_type cache_line_size = 64;
+
+		/// Per reader state, padded to two cache lines so that the
+		/// epochs of different readers never share a cache line
+		/// regardless of the alignment of the slot array.
+		struct reader_slot {
+			std::atomic<epoch_type> epoch;
+			std::atomic<bool>       in_use;
+			unsigned char           padding[
+				2 * cache_line_size - sizeof(std::atomic<epoch_type>) - sizeof(std::atomic<bool>)];
+
+			reader_slot(): epoch{0}, in_use{false} {}
+		};
+
+		struct retired_array {
+			epoch_type                  epoch;
+			std::unique_ptr<value_type> array;
+		};
+
+		/// Replaces the published dynarray by \next.
+		/// Requires the writer mutex to be locked.
+		void publish_locked(std::unique_ptr<value_type> next);
+
+		/// Destroys all retired dynarrays that no active reader can observe.
+		/// Requires the writer mutex to be locked.
+		void reclaim();
+
+		std::atomic<value_type *>      m_current;
+		std::atomic<epoch_type>        m_epoch;
+		dynarray<reader_slot>          m_slots;
+		mutable std::mutex             m_writer_mutex;
+		std::vector<retired_array>     m_retired;
+	};
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+template<typename T>
+constexpr typename utils::rcu_dynarray<T>::size_type utils::rcu_dynarray<T>::cache_line_size;
+
+//============================================================
+// Read Guard
+//============================================================
+
+template<typename T>
+utils::rcu_dynarray<T>::read_guard::read_guard(reader_slot & slot, value_type const* array):
+	m_slot{&slot},
+	m_array{array}
+{}
+
+template<typename T>
+utils::rcu_dynarray<T>::read_guard::read_guard(read_guard && other):
+	m_slot{other.m_slot},
+	m_array{other.m_array}
+{
+	other.m_slot = nullptr;
+	other.m_array = nullptr;
+}
+
+template<typename T>
+utils::rcu_dynarray<T>::read_guard::~read_guard() {
+	if (m_slot != nullptr) {
+		// Release ordering makes all reads through this guard
+		// happen before a writer that observes the inactive slot.
+		m_slot->epoch.store(0, std::memory_order_release);
+	}
+}
+
+template<typename T>
+auto utils::rcu_dynarray<T>::read_guard::get() const -> value_type const& {
+	return *m_array;
+}
+
+template<typename T>
+auto utils::rcu_dynarray<T>::read_guard::operator*() const -> value_type const& {
+	return *m_array;
+}
+
+template<typename T>
+auto utils::rcu_dynarray<T>::read_guard::operator->() const -> value_type const* {
+	return m_array;
+}
+
+//============================================================
+// Reader
+//============================================================
+
+template<typename T>
+utils::rcu_dynarray<T>::reader::reader(rcu_dynarray & owner, reader_slot & slot):
+	m_owner{&owner},
+	m_slot{&slot}
+{}
+
+template<typename T>
+utils::rcu_dynarray<T>::reader::reader(reader && other):
+	m_owner{other.m_owner},
+	m_slot{other.m_slot}
+{
+	other.m_owner = nullptr;
+	other.m_slot = nullptr;
+}
+
+template<typename T>
+utils::rcu_dynarray<T>::reader::~reader() {
+	if (m_slot != nullptr) {
+		m_slot->in_use.store(false, std::memory_order_release);
+	}
+}
+
+template<typename T>
+auto utils::rcu_dynarray<T>::reader::read() const -> read_guard {
+	// The announcement store and the pointer load are sequentially
+	// consistent: if this reader loads a pointer before a writer
+	// replaced it, the writer is guaranteed to observe the announced
+	// epoch when it scans the slots afterwards.
+	auto const epoch = m_owner->m_epoch.load(std::memory_order_seq_cst);
+	m_slot->epoch.store(epoch, std::memory_order_seq_cst);
+	auto const array = m_owner->m_current.load(std::memory_order_seq_cst);
+	return read_guard{*m_slot, array};
+}
+
+//============================================================
+// Constructors
+//============================================================
+
+template<typename T>
+utils::rcu_dynarray<T>::rcu_dynarray(dynarray<T> && initial, size_type max_readers):
+	m_current{new value_type(std::move(initial))},
+	m_epoch{1},
+	m_slots(max_readers),
+	m_writer_mutex{},
+	m_retired{}
+{}
+
+template<typename T>
+utils::rcu_dynarray<T>::~rcu_dynarray() {
+	delete m_current.load(std::memory_order_acquire);
+}
+
+//============================================================
+// Reader API
+//============================================================
+
+template<typename T>
+auto utils::rcu_dynarray<T>::make_reader() -> reader {
+	for (auto & slot : m_slots) {
+		auto expected = false;
+		if (!slot.in_use.load(std::memory_order_relaxed) &&
+			slot.in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)
+		) {
+			return reader{*this, slot};
+		}
+	}
+	using namespace std::string_literals;
+	throw std::length_error{
+		"cannot create more than "s +
+		std::to_string(max_readers()) +
+		" concurrent readers for rcu_dynarray"
+	};
+}
+
+template<typename T>
+auto utils::rcu_dynarray<T>::max_readers() const -> size_type {
+	return m_slots.size();
+}
+
+//============================================================
+// Writer API
+//============================================================
+
+template<typename T>
+void utils::rcu_dynarray<T>::publish(dynarray<T> && next) {
+	auto replacement = std::unique_ptr<value_type>{new value_type(std::move(next))};
+	std::lock_guard<std::mutex> lock{m_writer_mutex};
+	publish_locked(std::move(replacement));
+}
+
+template<typename T>
+void utils::rcu_dynarray<T>::publish_locked(std::unique_ptr<value_type> next) {
+	m_retired.reserve(m_retired.size() + 1);
+	auto const previous = m_current.exchange(next.release(), std::memory_order_seq_cst);
+	// Readers that can still observe the previous dynarray have
+	// announced an epoch that is not newer than retire_epoch.
+	auto const retire_epoch = m_epoch.fetch_add(1, std::memory_order_seq_cst);
+	m_retired.push_back(retired_array{retire_epoch, std::unique_ptr<value_type>{previous}});
+	reclaim();
+}
+
+template<typename T>
+template<typename Modify>
+void utils::rcu_dynarray<T>::update(Modify && modify) {
+	// The lock is held from copy to swap, otherwise concurrent writers
+	// could start from the same snapshot and overwrite each other.
+	std::lock_guard<std::mutex> lock{m_writer_mutex};
+	auto copy = std::unique_ptr<value_type>{new value_type(*m_current.load(std::memory_order_acquire))};
+	std::forward<Modify>(modify)(*copy);
+	publish_locked(std::move(copy));
+}
+
+template<typename T>
+void utils::rcu_dynarray<T>::synchronize() {
+	for (;;) {
+		{
+			std::lock_guard<std::mutex> lock{m_writer_mutex};
+			reclaim();
+			if (m_retired.empty()) {
+				return;
+			}
+		}
+		std::this_thread::yield();
+	}
+}
+
+template<typename T>
+auto utils::rcu_dynarray<T>::pending_reclamations() const -> size_type {
+	std::lock_guard<std::mutex> lock{m_writer_mutex};
+	return m_retired.size();
+}
+
+template<typename T>
+void utils::rcu_dynarray<T>::reclaim() {
+	if (m_retired.empty()) {
+		return;
+	}
+	auto oldest_active = m_epoch.load(std::memory_order_seq_cst);
+	for (auto const& slot : m_slots) {
+		auto const epoch = slot.epoch.load(std::memory_order_seq_cst);
+		if (epoch != 0 && epoch < oldest_active) {
+			oldest_active = epoch;
+		}
+	}
+	m_retired.erase(
+		std::remove_if(m_retired.begin(), m_retired.end(),
+			[oldest_active](retired_array const& retired) {
+				return retired.epoch < oldest_active;
+			}),
+		m_retired.end());
+}
+
+#endif // UTILS_RCU_DYNARRAY_HPP
@@ -0,0 +1,306 @@
+//===---------------------------------------------------------
+//                       RLE_DYNARRAY
+//===---------------------------------------------------------
+//
+// Immutable run-length encoded dynarray for data with long
+// runs of equal values, such as sensor readings or status
+// columns.
+//
+// A run of equal consecutive elements is stored as its value
+// and the position one past its last element, the run end,
+// in two dynarrays. Run ends are ascending, so the run of a
+// position is found by binary search over them. Counting,
+// summing and iterating visit every run once rather than
+// every element.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_RLE_DYNARRAY_HPP
+#define UTILS_RLE_DYNARRAY_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// headers used by definition site
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// Immutable dynarray storing runs of equal consecutive elements once.
+	/// T must be default constructible, copy assignable and equality comparable.
+	template<typename T>
+	class rle_dynarray {
+	public:
+		using value_type = T;
+		using size_type  = size_t;
+
+		/// Result type of sum(): a 64-bit integer of the same signedness for
+		/// integral T, like simd::accumulate_t, and T itself otherwise.
+		using sum_type = std::conditional_t<
+			std::is_integral<T>::value,
+			std::conditional_t<std::is_signed<T>::value, std::int64_t, std::uint64_t>,
+			T>;
+
+	//============================================================
+	// Constructors
+	//============================================================
+
+		/// Encodes the elements of \values.
+		explicit rle_dynarray(dynarray<T> const& values);
+
+		/// Encodes the elements of the range [\first, \last).
+		/// Traverses the range twice, hence requires forward iterators.
+		template<typename ForwardIt>
+		rle_dynarray(ForwardIt first, ForwardIt last);
+
+	//============================================================
+	// Access API
+	//============================================================
+
+		/// Returns the element at position \pos with bounds checking.
+		/// Throws out_of_range exception if \pos was illegal.
+		auto at(size_type pos) const -> T const&;
+
+		/// Returns the element at position \pos without bounds checking.
+		/// Takes logarithmic time in the count of runs.
+		auto operator[](size_type pos) const -> T const&;
+
+		/// Returns the index of the run containing position \pos without bounds checking.
+		auto run_of(size_type pos) const -> size_type;
+
+		/// Returns a dynarray of all elements.
+		auto decompress() const -> dynarray<T>;
+
+	//============================================================
+	// Run API
+	//============================================================
+
+		/// Calls \f with the value and length of every run in order.
+		template<typename F>
+		void for_each_run(F && f) const;
+
+		/// Returns the number of elements equal to \value.
+		auto count(T const& value) const -> size_type;
+
+		/// Returns the sum of all elements, starting from a value-initialized sum_type.
+		/// Integer sums wrap around modulo 2^64 instead of overflowing.
+		auto sum() const -> sum_type;
+
+		/// Returns the values of the runs.
+		auto run_values() const -> dynarray<T> const&;
+
+		/// Returns the positions one past the last element of the runs.
+		auto run_ends() const -> dynarray<size_type> const&;
+
+	//============================================================
+	// Capacity API
+	//============================================================
+
+		/// Returns `true` if this rle_dynarray is empty and `false` otherwise.
+		auto empty() const -> bool;
+
+		/// Returns the count of elements.
+		auto size() const -> size_type;
+
+		/// Returns the count of runs.
+		auto run_count() const -> size_type;
+
+		/// Returns the number of bytes allocated for run values and ends.
+		auto memory_usage() const -> size_type;
+
+		/// Returns the size of the uncompressed elements divided by memory_usage().
+		auto compression_ratio() const -> double;
+
+	private:
+		dynarray<T>         m_values;
+		dynarray<size_type> m_ends;
+	};
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace detail {
+		/// Returns the number of runs of equal consecutive elements in [\first, \last).
+		template<typename ForwardIt>
+		auto count_runs(ForwardIt first, ForwardIt last) -> size_t {
+			if (first == last) {
+				return 0;
+			}
+			size_t runs = 1;
+			for (auto previous = first++; first != last; previous = first++) {
+				runs += !(*first == *previous);
+			}
+			return runs;
+		}
+	}
+}
+
+//============================================================
+// Constructors
+//============================================================
+
+template<typename T>
+utils::rle_dynarray<T>::rle_dynarray(dynarray<T> const& values):
+	rle_dynarray(values.begin(), values.end())
+{}
+
+template<typename T>
+template<typename ForwardIt>
+utils::rle_dynarray<T>::rle_dynarray(ForwardIt first, ForwardIt last):
+	m_values(detail::count_runs(first, last)),
+	m_ends(m_values.size())
+{
+	size_type run = 0;
+	size_type pos = 0;
+	for (auto it = first; it != last; ++it, ++pos) {
+		if (pos != 0 && !(*it == m_values[run])) {
+			m_ends[run++] = pos;
+		}
+		m_values[run] = *it;
+	}
+	if (pos != 0) {
+		m_ends[run] = pos;
+	}
+}
+
+//============================================================
+// Access API
+//============================================================
+
+template<typename T>
+auto utils::rle_dynarray<T>::at(size_type pos) const -> T const& {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access element at position "s +
+			std::to_string(pos) +
+			" from a rle_dynarray with size " +
+			std::to_string(size())
+		};
+	}
+	return (*this)[pos];
+}
+
+template<typename T>
+auto utils::rle_dynarray<T>::operator[](size_type pos) const -> T const& {
+	return m_values[run_of(pos)];
+}
+
+template<typename T>
+auto utils::rle_dynarray<T>::run_of(size_type pos) const -> size_type {
+	// Branchless search for the first run ending after pos.
+	auto first = size_type{0};
+	auto length = m_ends.size();
+	while (length > 1) {
+		auto const half = length / 2;
+		first = m_ends[first + half - 1] <= pos ? first + half : first;
+		length -= half;
+	}
+	return first;
+}
+
+template<typename T>
+auto utils::rle_dynarray<T>::decompress() const -> dynarray<T> {
+	auto result = dynarray<T>(size());
+	auto out = result.begin();
+	for_each_run([&](T const& value, size_type length) {
+		out = std::fill_n(out, length, value);
+	});
+	return result;
+}
+
+//============================================================
+// Run API
+//============================================================
+
+template<typename T>
+template<typename F>
+void utils::rle_dynarray<T>::for_each_run(F && f) const {
+	auto begin = size_type{0};
+	for (size_type run = 0; run != m_values.size(); ++run) {
+		f(m_values[run], m_ends[run] - begin);
+		begin = m_ends[run];
+	}
+}
+
+template<typename T>
+auto utils::rle_dynarray<T>::count(T const& value) const -> size_type {
+	auto result = size_type{0};
+	for_each_run([&](T const& run_value, size_type length) {
+		if (run_value == value) {
+			result += length;
+		}
+	});
+	return result;
+}
+
+template<typename T>
+auto utils::rle_dynarray<T>::sum() const -> sum_type {
+	// Integers are accumulated unsigned so that the products and sums wrap around.
+	using accumulator = std::conditional_t<std::is_integral<T>::value, std::uint64_t, sum_type>;
+	auto result = accumulator{};
+	for_each_run([&](T const& value, size_type length) {
+		result += static_cast<accumulator>(value) * static_cast<accumulator>(length);
+	});
+	return static_cast<sum_type>(result);
+}
+
+template<typename T>
+auto utils::rle_dynarray<T>::run_values() const -> dynarray<T> const& {
+	return m_values;
+}
+
+template<typename T>
+auto utils::rle_dynarray<T>::run_ends() const -> dynarray<size_type> const& {
+	return m_ends;
+}
+
+//============================================================
+// Capacity API
+//============================================================
+
+template<typename T>
+auto utils::rle_dynarray<T>::empty() const -> bool {
+	return m_ends.size() == 0;
+}
+
+template<typename T>
+auto utils::rle_dynarray<T>::size() const -> size_type {
+	return m_ends.size() == 0 ? 0 : m_ends[m_ends.size() - 1];
+}
+
+template<typename T>
+auto utils::rle_dynarray<T>::run_count() const -> size_type {
+	return m_values.size();
+}
+
+template<typename T>
+auto utils::rle_dynarray<T>::memory_usage() const -> size_type {
+	return m_values.size() * sizeof(T) + m_ends.size() * sizeof(size_type);
+}
+
+template<typename T>
+auto utils::rle_dynarray<T>::compression_ratio() const -> double {
+	return static_cast<double>(size() * sizeof(T)) / static_cast<double>(memory_usage());
+}
+
+#endif // UTILS_RLE_DYNARRAY_HPP
@@ -0,0 +1,344 @@
+//===---------------------------------------------------------
+//                       SEQLOCK_DYNARRAY
+//===---------------------------------------------------------
+//
+// Small fixed-size array of trivially copyable elements that
+// is updated in place by a single writer and read by many
+// concurrent readers through consistent snapshots.
+//
+// Access is synchronized by a sequence counter: the writer
+// makes the counter odd while it updates the elements and
+// even again afterwards. Readers copy the elements and retry
+// if the counter was odd or changed meanwhile. Readers never
+// write to shared memory and therefore never contend for
+// cache lines with each other.
+//
+// The elements are stored as relaxed atomic 64-bit words so
+// that the racy copies performed by readers are well-defined
+// under the C++ memory model.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_SEQLOCK_DYNARRAY_HPP
+#define UTILS_SEQLOCK_DYNARRAY_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// headers used by definition site
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// Fixed-size array of trivially copyable elements with a single
+	/// writer and lock-free snapshot readers. Like the writer-private
+	/// dynarray copy of the elements, T must be default constructible.
+	///
+	/// Intended for small arrays (a few dozen elements) that are
+	/// updated at high frequency, e.g. per-symbol price levels.
+	/// Readers may starve under a writer that updates continuously
+	/// since every update invalidates concurrent snapshots.
+	///
+	/// All mutating member functions must only be called by a
+	/// single writer thread at a time. The const member functions
+	/// may be called concurrently from any number of threads.
+	template<typename T>
+	class seqlock_dynarray {
+		static_assert(std::is_trivially_copyable<T>::value,
+			"seqlock_dynarray requires trivially copyable element types");
+		static_assert(std::is_default_constructible<T>::value,
+			"seqlock_dynarray requires default constructible element types");
+
+	public:
+
+	//============================================================
+	// Type aliases
+	//============================================================
+
+		using value_type    = T;
+		using size_type     = size_t;
+		using sequence_type = std::uint64_t;
+
+	//============================================================
+	// Constructors
+	//============================================================
+
+	// (1) construct by count with value-initialized elements
+	//============================================================
+		explicit seqlock_dynarray(size_type count);
+
+	// (2) construct by count and copied value
+	//============================================================
+		seqlock_dynarray(size_type count, T const& value);
+
+		seqlock_dynarray(seqlock_dynarray const&) = delete;
+		auto operator=(seqlock_dynarray const&) -> seqlock_dynarray & = delete;
+
+	//============================================================
+	// Reader API
+	//============================================================
+
+		/// Copies a consistent snapshot of all elements into \out which
+		/// must provide room for size() elements. Retries until no update
+		/// happened concurrently.
+		void snapshot(T * out) const;
+
+		/// Copies a consistent snapshot of all elements into \out.
+		/// Throws an invalid_argument exception when the sizes are unequal.
+		void snapshot(dynarray<T> & out) const;
+
+		/// Returns a consistent snapshot of all elements.
+		auto snapshot() const -> dynarray<T>;
+
+		/// Returns a consistent copy of the element at position \pos.
+		/// Throws out_of_bounds exception if \pos was illegal.
+		auto load(size_type pos) const -> T;
+
+		/// Returns the current value of the sequence counter.
+		/// It is odd while an update is in progress.
+		auto sequence() const -> sequence_type;
+
+	//============================================================
+	// Writer API
+	//============================================================
+
+		/// Stores \value at position \pos.
+		/// Throws out_of_bounds exception if \pos was illegal.
+		void store(size_type pos, T const& value);
+
+		/// Replaces all elements by the ones in \values.
+		/// Throws an invalid_argument exception when the sizes are unequal.
+		void store(dynarray<T> const& values);
+
+		/// Applies \modify to a writer-private copy of all elements and
+		/// publishes the result as a single update. \modify is invoked
+		/// with a pointer to the first of size() mutable elements.
+		template<typename Modify>
+		void update(Modify && modify);
+
+	//============================================================
+	// Capacity API
+	//============================================================
+
+		/// Returns `true` if this seqlock_dynarray is empty and `false` otherwise.
+		auto empty() const -> bool;
+
+		/// Returns the count of elements in this seqlock_dynarray.
+		auto size() const -> size_type;
+
+	//============================================================
+	// Member Variables
+	//============================================================
+
+	private:
+		using word_type = std::uint64_t;
+
+		static constexpr size_type word_size = sizeof(word_type);
+
+		/// Copies a consistent snapshot of \length bytes starting at byte \offset into \out.
+		void read_bytes(size_type offset, size_type length, void * out) const;
+
+		/// Publishes the bytes of the writer-private copy that fall into
+		/// the byte range [\first, \last) to the shared words.
+		void write_bytes(size_type first, size_type last);
+
+		alignas(64) std::atomic<sequence_type> m_sequence;
+		dynarray<std::atomic<word_type>>       m_words;
+		dynarray<T>                            m_shadow;
+	};
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+template<typename T>
+constexpr typename utils::seqlock_dynarray<T>::size_type utils::seqlock_dynarray<T>::word_size;
+
+//============================================================
+// Constructors
+//============================================================
+
+// (1) construct by count with value-initialized elements
+//============================================================
+template<typename T>
+utils::seqlock_dynarray<T>::seqlock_dynarray(size_type count):
+	seqlock_dynarray(count, T{})
+{}
+
+// (2) construct by count and copied value
+//============================================================
+template<typename T>
+utils::seqlock_dynarray<T>::seqlock_dynarray(size_type count, T const& value):
+	m_sequence{0},
+	m_words((count * sizeof(T) + word_size - 1) / word_size),
+	m_shadow(count, value)
+{
+	write_bytes(0, count * sizeof(T));
+}
+
+//============================================================
+// Reader API
+//============================================================
+
+template<typename T>
+void utils::seqlock_dynarray<T>::read_bytes(size_type offset, size_type length, void * out) const {
+	auto const bytes = static_cast<unsigned char *>(out);
+	auto const first_word = offset / word_size;
+	auto const last_word  = (offset + length + word_size - 1) / word_size;
+	for (;;) {
+		auto const before = m_sequence.load(std::memory_order_acquire);
+		if ((before & 1) != 0) {
+			continue;
+		}
+		for (auto i = first_word; i != last_word; ++i) {
+			auto const word = m_words[i].load(std::memory_order_relaxed);
+			auto const word_first = i * word_size;
+			auto const copy_first = word_first > offset ? word_first : offset;
+			auto const copy_last  = word_first + word_size < offset + length
+			                      ? word_first + word_size : offset + length;
+			std::memcpy(
+				bytes + (copy_first - offset),
+				reinterpret_cast<unsigned char const*>(&word) + (copy_first - word_first),
+				copy_last - copy_first);
+		}
+		// Orders the relaxed word loads before the validating load.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (m_sequence.load(std::memory_order_relaxed) == before) {
+			return;
+		}
+	}
+}
+
+template<typename T>
+void utils::seqlock_dynarray<T>::snapshot(T * out) const {
+	read_bytes(0, size() * sizeof(T), out);
+}
+
+template<typename T>
+void utils::seqlock_dynarray<T>::snapshot(dynarray<T> & out) const {
+	if (out.size() != size()) {
+		using namespace std::string_literals;
+		throw std::invalid_argument{
+			"cannot snapshot seqlock_dynarray of size "s +
+			std::to_string(size()) +
+			" into dynarray of size " +
+			std::to_string(out.size())
+		};
+	}
+	snapshot(out.data());
+}
+
+template<typename T>
+auto utils::seqlock_dynarray<T>::snapshot() const -> dynarray<T> {
+	auto result = dynarray<T>(size());
+	snapshot(result.data());
+	return result;
+}
+
+template<typename T>
+auto utils::seqlock_dynarray<T>::load(size_type pos) const -> T {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot load element at position "s +
+			std::to_string(pos) +
+			" from a seqlock_dynarray with size " +
+			std::to_string(size())
+		};
+	}
+	T result;
+	read_bytes(pos * sizeof(T), sizeof(T), &result);
+	return result;
+}
+
+template<typename T>
+auto utils::seqlock_dynarray<T>::sequence() const -> sequence_type {
+	return m_sequence.load(std::memory_order_acquire);
+}
+
+//============================================================
+// Writer API
+//============================================================
+
+template<typename T>
+void utils::seqlock_dynarray<T>::write_bytes(size_type first, size_type last) {
+	auto const bytes = reinterpret_cast<unsigned char const*>(m_shadow.data());
+	auto const total = size() * sizeof(T);
+	auto const first_word = first / word_size;
+	auto const last_word  = (last + word_size - 1) / word_size;
+	auto const sequence = m_sequence.load(std::memory_order_relaxed);
+	m_sequence.store(sequence + 1, std::memory_order_relaxed);
+	// Orders the odd sequence number before the following word stores.
+	std::atomic_thread_fence(std::memory_order_release);
+	for (auto i = first_word; i != last_word; ++i) {
+		auto word = word_type{0};
+		auto const word_first = i * word_size;
+		std::memcpy(&word, bytes + word_first,
+			word_first + word_size <= total ? word_size : total - word_first);
+		m_words[i].store(word, std::memory_order_relaxed);
+	}
+	m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+template<typename T>
+void utils::seqlock_dynarray<T>::store(size_type pos, T const& value) {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot store element at position "s +
+			std::to_string(pos) +
+			" into a seqlock_dynarray with size " +
+			std::to_string(size())
+		};
+	}
+	m_shadow[pos] = value;
+	write_bytes(pos * sizeof(T), (pos + 1) * sizeof(T));
+}
+
+template<typename T>
+void utils::seqlock_dynarray<T>::store(dynarray<T> const& values) {
+	m_shadow = values;
+	write_bytes(0, size() * sizeof(T));
+}
+
+template<typename T>
+template<typename Modify>
+void utils::seqlock_dynarray<T>::update(Modify && modify) {
+	std::forward<Modify>(modify)(m_shadow.data());
+	write_bytes(0, size() * sizeof(T));
+}
+
+//============================================================
+// Capacity API
+//============================================================
+
+template<typename T>
+auto utils::seqlock_dynarray<T>::empty() const -> bool {
+	return m_shadow.empty();
+}
+
+template<typename T>
+auto utils::seqlock_dynarray<T>::size() const -> size_type {
+	return m_shadow.size();
+}
+
+#endif // UTILS_SEQLOCK_DYNARRAY_HPP
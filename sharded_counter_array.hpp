@@ -0,0 +1,363 @@
+//===---------------------------------------------------------
+//                       SHARDED_COUNTER_ARRAY
+//===---------------------------------------------------------
+//
+// Fixed-size arrays of concurrently incremented counters
+// for hot-path metrics.
+//
+// Instead of a single array of atomics that all threads
+// increment, every shard holds its own copy of all counters
+// on separate cache lines. Threads increment the counters
+// of the shard they are assigned to with relaxed atomic
+// operations; reading a counter merges all shards.
+// The increment path never allocates and contends only with
+// the few threads that happen to share the same shard.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_SHARDED_COUNTER_ARRAY_HPP
+#define UTILS_SHARDED_COUNTER_ARRAY_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+#include "padded_dynarray.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// headers used by definition site
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// Array of \size() unsigned 64-bit counters distributed over
+	/// \shard_count() shards. Sized once at construction like dynarray.
+	///
+	/// Every thread is assigned to a shard on its first increment in
+	/// round-robin order. With at least as many shards as concurrently
+	/// incrementing threads no two threads ever write the same cache line.
+	class sharded_counter_array {
+	public:
+
+	//============================================================
+	// Type aliases
+	//============================================================
+
+		using value_type = std::uint64_t;
+		using size_type  = size_t;
+
+	//============================================================
+	// Constructors
+	//============================================================
+
+		/// Creates \counters zero-initialized counters with \shards shards.
+		/// Throws an invalid_argument exception if \shards is zero.
+		explicit sharded_counter_array(size_type counters, size_type shards = default_shard_count());
+
+		sharded_counter_array(sharded_counter_array const&) = delete;
+		auto operator=(sharded_counter_array const&) -> sharded_counter_array & = delete;
+
+		/// Returns the number of hardware threads or 1 if it is unknown.
+		static auto default_shard_count() -> size_type;
+
+	//============================================================
+	// Increment API
+	// Wait-free, allocation-free and without bounds checking.
+	//============================================================
+
+		/// Increments the counter at \index by one.
+		void increment(size_type index);
+
+		/// Adds \delta to the counter at \index.
+		void add(size_type index, value_type delta);
+
+		/// Adds \delta to the counter at \index in the explicitly given \shard.
+		/// Useful for callers that already know a stable worker index.
+		void add_to_shard(size_type shard, size_type index, value_type delta);
+
+	//============================================================
+	// Read API
+	// The result is merged from all shards. Concurrent increments
+	// may or may not be reflected.
+	//============================================================
+
+		/// Returns the merged value of the counter at \index.
+		/// Throws out_of_bounds exception if \index was illegal.
+		auto load(size_type index) const -> value_type;
+
+		/// Returns the merged values of all counters.
+		auto snapshot() const -> dynarray<value_type>;
+
+		/// Writes the merged values of all counters into \out.
+		/// Throws an invalid_argument exception when the sizes are unequal.
+		void snapshot(dynarray<value_type> & out) const;
+
+		/// Returns the sum over all counters in all shards.
+		auto total() const -> value_type;
+
+		/// Resets all counters in all shards to zero.
+		/// Concurrent increments may or may not survive the reset.
+		void reset();
+
+	//============================================================
+	// Capacity API
+	//============================================================
+
+		/// Returns the number of counters.
+		auto size() const -> size_type;
+
+		/// Returns the number of shards.
+		auto shard_count() const -> size_type;
+
+	//============================================================
+	// Member Variables
+	//============================================================
+
+	private:
+		using counter_type = std::atomic<value_type>;
+
+		/// Returns the shard of the calling thread.
+		auto local_shard() const -> size_type;
+
+		auto shard(size_type index) const -> counter_type *;
+
+		size_type                       m_size;
+		size_type                       m_shard_count;
+		size_type                       m_shard_stride;
+		std::unique_ptr<counter_type[]> m_buffer;
+		counter_type *                  m_first;
+	};
+
+	/// Histogram with fixed bucket boundaries on top of a sharded_counter_array.
+	///
+	/// Bucket i counts the recorded values v with `bounds[i-1] < v <= bounds[i]`.
+	/// An additional overflow bucket counts all values above the last bound.
+	template<typename T>
+	class sharded_histogram {
+	public:
+		using value_type = T;
+		using size_type  = size_t;
+		using count_type = sharded_counter_array::value_type;
+
+		/// Creates a histogram with the given ascending upper bucket \bounds.
+		explicit sharded_histogram(
+			dynarray<T> bounds,
+			size_type shards = sharded_counter_array::default_shard_count());
+
+		/// Counts \value in its bucket.
+		void record(T const& value);
+
+		/// Returns the upper bucket bounds.
+		auto bounds() const -> dynarray<T> const&;
+
+		/// Returns the merged counts of all buckets including the overflow bucket.
+		auto snapshot() const -> dynarray<count_type>;
+
+		/// Returns the number of buckets including the overflow bucket.
+		auto bucket_count() const -> size_type;
+
+	private:
+		dynarray<T>           m_bounds;
+		sharded_counter_array m_counts;
+	};
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace detail {
+		/// Returns a small per-thread number assigned in round-robin order
+		/// on first use. Stable for the lifetime of the calling thread.
+		inline auto this_thread_shard_hint() -> size_t {
+			static std::atomic<size_t> next{0};
+			thread_local size_t const hint = next.fetch_add(1, std::memory_order_relaxed);
+			return hint;
+		}
+	}
+}
+
+//============================================================
+// Constructors
+//============================================================
+
+inline utils::sharded_counter_array::sharded_counter_array(size_type counters, size_type shards):
+	m_size{counters},
+	m_shard_count{shards},
+	m_shard_stride{
+		(counters * sizeof(counter_type) + cache_line_size - 1)
+			/ cache_line_size * cache_line_size / sizeof(counter_type)},
+	m_buffer{},
+	m_first{nullptr}
+{
+	if (shards == 0) {
+		throw std::invalid_argument{"cannot create sharded_counter_array with zero shards"};
+	}
+	auto const slack = cache_line_size / sizeof(counter_type) - 1;
+	m_buffer.reset(new counter_type[m_shard_stride * m_shard_count + slack]);
+	auto const misalignment =
+		reinterpret_cast<std::uintptr_t>(m_buffer.get()) % cache_line_size / sizeof(counter_type);
+	m_first = m_buffer.get() + (misalignment == 0 ? 0 : slack + 1 - misalignment);
+	reset();
+}
+
+inline auto utils::sharded_counter_array::default_shard_count() -> size_type {
+	auto const threads = std::thread::hardware_concurrency();
+	return threads != 0 ? threads : 1;
+}
+
+//============================================================
+// Increment API
+//============================================================
+
+inline auto utils::sharded_counter_array::local_shard() const -> size_type {
+	return detail::this_thread_shard_hint() % m_shard_count;
+}
+
+inline auto utils::sharded_counter_array::shard(size_type index) const -> counter_type * {
+	return m_first + index * m_shard_stride;
+}
+
+inline void utils::sharded_counter_array::increment(size_type index) {
+	add(index, 1);
+}
+
+inline void utils::sharded_counter_array::add(size_type index, value_type delta) {
+	shard(local_shard())[index].fetch_add(delta, std::memory_order_relaxed);
+}
+
+inline void utils::sharded_counter_array::add_to_shard(size_type shard_index, size_type index, value_type delta) {
+	shard(shard_index % m_shard_count)[index].fetch_add(delta, std::memory_order_relaxed);
+}
+
+//============================================================
+// Read API
+//============================================================
+
+inline auto utils::sharded_counter_array::load(size_type index) const -> value_type {
+	if (index >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot load counter at position "s +
+			std::to_string(index) +
+			" from a sharded_counter_array with size " +
+			std::to_string(size())
+		};
+	}
+	auto result = value_type{0};
+	for (size_type s = 0; s != m_shard_count; ++s) {
+		result += shard(s)[index].load(std::memory_order_relaxed);
+	}
+	return result;
+}
+
+inline auto utils::sharded_counter_array::snapshot() const -> dynarray<value_type> {
+	auto result = dynarray<value_type>(size());
+	snapshot(result);
+	return result;
+}
+
+inline void utils::sharded_counter_array::snapshot(dynarray<value_type> & out) const {
+	if (out.size() != size()) {
+		using namespace std::string_literals;
+		throw std::invalid_argument{
+			"cannot snapshot sharded_counter_array of size "s +
+			std::to_string(size()) +
+			" into dynarray of size " +
+			std::to_string(out.size())
+		};
+	}
+	out.fill(0);
+	// Shard-major order reads every shard sequentially.
+	for (size_type s = 0; s != m_shard_count; ++s) {
+		auto const counters = shard(s);
+		for (size_type i = 0; i != m_size; ++i) {
+			out[i] += counters[i].load(std::memory_order_relaxed);
+		}
+	}
+}
+
+inline auto utils::sharded_counter_array::total() const -> value_type {
+	auto result = value_type{0};
+	for (size_type s = 0; s != m_shard_count; ++s) {
+		auto const counters = shard(s);
+		for (size_type i = 0; i != m_size; ++i) {
+			result += counters[i].load(std::memory_order_relaxed);
+		}
+	}
+	return result;
+}
+
+inline void utils::sharded_counter_array::reset() {
+	for (size_type s = 0; s != m_shard_count; ++s) {
+		auto const counters = shard(s);
+		for (size_type i = 0; i != m_size; ++i) {
+			counters[i].store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+//============================================================
+// Capacity API
+//============================================================
+
+inline auto utils::sharded_counter_array::size() const -> size_type {
+	return m_size;
+}
+
+inline auto utils::sharded_counter_array::shard_count() const -> size_type {
+	return m_shard_count;
+}
+
+//============================================================
+// Histogram
+//============================================================
+
+template<typename T>
+utils::sharded_histogram<T>::sharded_histogram(dynarray<T> bounds, size_type shards):
+	m_bounds{std::move(bounds)},
+	m_counts{m_bounds.size() + 1, shards}
+{
+	if (!std::is_sorted(m_bounds.begin(), m_bounds.end())) {
+		throw std::invalid_argument{"cannot create sharded_histogram with unsorted bucket bounds"};
+	}
+}
+
+template<typename T>
+void utils::sharded_histogram<T>::record(T const& value) {
+	auto const bucket = std::lower_bound(m_bounds.begin(), m_bounds.end(), value) - m_bounds.begin();
+	m_counts.increment(static_cast<size_type>(bucket));
+}
+
+template<typename T>
+auto utils::sharded_histogram<T>::bounds() const -> dynarray<T> const& {
+	return m_bounds;
+}
+
+template<typename T>
+auto utils::sharded_histogram<T>::snapshot() const -> dynarray<count_type> {
+	return m_counts.snapshot();
+}
+
+template<typename T>
+auto utils::sharded_histogram<T>::bucket_count() const -> size_type {
+	return m_counts.size();
+}
+
+#endif // UTILS_SHARDED_COUNTER_ARRAY_HPP
@@ -0,0 +1,594 @@
+//===---------------------------------------------------------
+//                       SHARED_DYNARRAY
+//===---------------------------------------------------------
+//
+// Reference counted copy-on-write variant of the dynarray
+// container for sharing large, read-mostly arrays between
+// threads.
+//
+// The atomic reference count is stored in front of the
+// elements within the same heap allocation. In contrast
+// to a shared_ptr<dynarray<T>> there is no separate control
+// block and no second pointer indirection on element access.
+// Copying a shared_dynarray is O(1); the elements are only
+// copied once a shared buffer is accessed through a
+// non-const member function.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_SHARED_DYNARRAY_HPP
+#define UTILS_SHARED_DYNARRAY_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+
+// headers used by definition site
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// Fixed-size array with shared ownership of its elements and
+	/// copy-on-write semantics.
+	///
+	/// All const member functions operate on the shared buffer.
+	/// Non-const member functions that grant mutable access first detach
+	/// from the shared buffer by copying it if it is shared with other
+	/// shared_dynarray instances (i.e. use_count() > 1).
+	///
+	/// Note: References, pointers and iterators obtained through
+	/// non-const access are invalidated by copying this shared_dynarray
+	/// and should not be used for mutation afterwards since the writes
+	/// would then become visible to the copy.
+	///
+	/// Distinct shared_dynarray instances sharing the same buffer may
+	/// be used concurrently from different threads. A single instance
+	/// requires external synchronization for non-const access.
+	template<typename T>
+	class shared_dynarray {
+	public:
+
+	//============================================================
+	// Type aliases
+	//============================================================
+
+		using value_type             = T;
+		using size_type              = size_t;
+		using difference_type        = std::ptrdiff_t;
+		using reference              = value_type &;
+		using const_reference        = value_type const&;
+		using pointer                = value_type *;
+		using const_pointer          = value_type const*;
+		using iterator               = pointer;
+		using const_iterator         = const_pointer;
+		using reverse_iterator       = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	//============================================================
+	// Constructors
+	//============================================================
+
+	// (1) construct by count
+	//============================================================
+		explicit shared_dynarray(size_type count);
+
+	// (2) construct by count and copied value
+	//============================================================
+		shared_dynarray(size_type count, T const& value);
+
+	// (3) copy-construct, shares the buffer of \other
+	//============================================================
+		shared_dynarray(shared_dynarray const& other);
+
+	// (4) move-construct
+	//============================================================
+		shared_dynarray(shared_dynarray && other);
+
+	// (5) construct by initializer list
+	//============================================================
+		shared_dynarray(std::initializer_list<T> list);
+
+	// (6) construct by copying the elements of a dynarray
+	//============================================================
+		explicit shared_dynarray(dynarray<T> const& array);
+
+		~shared_dynarray();
+
+	//============================================================
+	// Assignment Operator
+	//============================================================
+
+		/// Releases the current buffer and shares the buffer of \other.
+		/// In contrast to dynarray the sizes may differ since no
+		/// elements are copied.
+		auto operator=(shared_dynarray const& other) -> shared_dynarray &;
+
+		/// Releases the current buffer and takes over the buffer of \other.
+		auto operator=(shared_dynarray && other) -> shared_dynarray &;
+
+	//============================================================
+	// Access API
+	//============================================================
+
+		/// Access the element at the specified position \pos with bounds checking.
+		/// Detaches from a shared buffer. Throws out_of_bounds exception if \pos was illegal.
+		auto at(size_type pos) -> reference;
+
+		/// Read-only access to the element at the specified position \pos with bounds checking.
+		/// Throws out_of_bounds exception if \pos was illegal.
+		auto at(size_type pos) const -> const_reference;
+
+		/// Access the element at the specified position \pos without bounds checking.
+		/// Detaches from a shared buffer.
+		auto operator[](size_type pos) -> reference;
+
+		/// Read-only access the element at the specified position \pos without bounds checking.
+		auto operator[](size_type pos) const -> const_reference;
+
+		/// Access the first element. Detaches from a shared buffer.
+		auto front() -> reference;
+
+		/// Read-only access the first element.
+		auto front() const -> const_reference;
+
+		/// Access the last element. Detaches from a shared buffer.
+		auto back() -> reference;
+
+		/// Read-only access the last element.
+		auto back() const -> const_reference;
+
+		/// Returns a raw-pointer to the underlying data buffer.
+		/// Detaches from a shared buffer.
+		auto data() -> pointer;
+
+		/// Returns a read-only raw-pointer to the underlying data buffer.
+		auto data() const -> const_pointer;
+
+	//============================================================
+	// Capacity API
+	//============================================================
+
+		/// Returns `true` if this shared_dynarray is empty and `false` otherwise.
+		auto empty() const -> bool;
+
+		/// Returns the count of elements in this shared_dynarray.
+		auto size() const -> size_type;
+
+	//============================================================
+	// Sharing API
+	//============================================================
+
+		/// Returns the number of shared_dynarray instances sharing the buffer.
+		/// Returns zero for an empty shared_dynarray.
+		auto use_count() const -> size_type;
+
+		/// Returns `true` if no other shared_dynarray shares the buffer.
+		auto unique() const -> bool;
+
+		/// Copies the buffer if it is shared so that this instance owns it exclusively.
+		void detach();
+
+	//============================================================
+	// Mutate API
+	//============================================================
+
+		/// Fills this shared_dynarray with elements equal to the specified \value.
+		/// Detaches from a shared buffer.
+		void fill(T const& value);
+
+	//============================================================
+	// Iterator API
+	// Non-const overloads detach from a shared buffer.
+	//============================================================
+
+		auto begin()        -> iterator;
+		auto begin() const  -> const_iterator;
+		auto cbegin() const -> const_iterator;
+
+		auto end()        -> iterator;
+		auto end() const  -> const_iterator;
+		auto cend() const -> const_iterator;
+
+		auto rbegin()        -> reverse_iterator;
+		auto rbegin() const  -> const_reverse_iterator;
+		auto crbegin() const -> const_reverse_iterator;
+
+		auto rend()        -> reverse_iterator;
+		auto rend() const  -> const_reverse_iterator;
+		auto crend() const -> const_reverse_iterator;
+
+	//============================================================
+	// Member Variables
+	//============================================================
+
+	private:
+		/// Header in front of the elements of every buffer.
+		struct control_block {
+			std::atomic<size_type> refs;
+			size_type              size;
+		};
+
+		/// Offset of the first element relative to the control block.
+		static constexpr size_type elements_offset =
+			(sizeof(control_block) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+		/// Allocates a buffer for \count elements and constructs them by
+		/// calling \init for each of them. Returns nullptr for zero elements.
+		template<typename Init>
+		static auto create(size_type count, Init init) -> control_block *;
+
+		/// Drops one reference to \block and destroys it once unreferenced.
+		static void release(control_block * block);
+
+		static auto elements(control_block * block) -> pointer;
+
+		control_block * m_block;
+		pointer         m_data;
+	};
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+template<typename T>
+constexpr typename utils::shared_dynarray<T>::size_type utils::shared_dynarray<T>::elements_offset;
+
+//============================================================
+// Buffer management
+//============================================================
+
+template<typename T>
+auto utils::shared_dynarray<T>::elements(control_block * block) -> pointer {
+	if (block == nullptr) {
+		return nullptr;
+	}
+	return reinterpret_cast<pointer>(reinterpret_cast<unsigned char *>(block) + elements_offset);
+}
+
+template<typename T>
+template<typename Init>
+auto utils::shared_dynarray<T>::create(size_type count, Init init) -> control_block * {
+	static_assert(alignof(T) <= alignof(std::max_align_t),
+		"shared_dynarray does not support over-aligned element types");
+	if (count == 0) {
+		return nullptr;
+	}
+	auto const memory = ::operator new(elements_offset + count * sizeof(T));
+	auto const block = ::new (memory) control_block{{1}, count};
+	auto const first = elements(block);
+	size_type constructed = 0;
+	try {
+		for (; constructed != count; ++constructed) {
+			init(first + constructed, constructed);
+		}
+	}
+	catch (...) {
+		for (size_type i = 0; i != constructed; ++i) {
+			first[i].~T();
+		}
+		block->~control_block();
+		::operator delete(memory);
+		throw;
+	}
+	return block;
+}
+
+template<typename T>
+void utils::shared_dynarray<T>::release(control_block * block) {
+	if (block == nullptr) {
+		return;
+	}
+	if (block->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+		return;
+	}
+	auto const first = elements(block);
+	for (size_type i = 0; i != block->size; ++i) {
+		first[i].~T();
+	}
+	block->~control_block();
+	::operator delete(static_cast<void *>(block));
+}
+
+//============================================================
+// Constructors
+//============================================================
+
+// (1) construct by count
+//============================================================
+template<typename T>
+utils::shared_dynarray<T>::shared_dynarray(size_type count):
+	m_block{create(count, [](pointer ptr, size_type) { ::new (static_cast<void *>(ptr)) T; })},
+	m_data{elements(m_block)}
+{}
+
+// (2) construct by count and copied value
+//============================================================
+template<typename T>
+utils::shared_dynarray<T>::shared_dynarray(size_type count, T const& value):
+	m_block{create(count, [&value](pointer ptr, size_type) { ::new (static_cast<void *>(ptr)) T(value); })},
+	m_data{elements(m_block)}
+{}
+
+// (3) copy-construct, shares the buffer of \other
+//============================================================
+template<typename T>
+utils::shared_dynarray<T>::shared_dynarray(shared_dynarray const& other):
+	m_block{other.m_block},
+	m_data{other.m_data}
+{
+	if (m_block != nullptr) {
+		m_block->refs.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+// (4) move-construct
+//============================================================
+template<typename T>
+utils::shared_dynarray<T>::shared_dynarray(shared_dynarray && other):
+	m_block{other.m_block},
+	m_data{other.m_data}
+{
+	other.m_block = nullptr;
+	other.m_data = nullptr;
+}
+
+// (5) construct by initializer list
+//============================================================
+template<typename T>
+utils::shared_dynarray<T>::shared_dynarray(std::initializer_list<T> list):
+	m_block{create(list.size(), [&list](pointer ptr, size_type pos) {
+		::new (static_cast<void *>(ptr)) T(list.begin()[pos]);
+	})},
+	m_data{elements(m_block)}
+{}
+
+// (6) construct by copying the elements of a dynarray
+//============================================================
+template<typename T>
+utils::shared_dynarray<T>::shared_dynarray(dynarray<T> const& array):
+	m_block{create(array.size(), [&array](pointer ptr, size_type pos) {
+		::new (static_cast<void *>(ptr)) T(array[pos]);
+	})},
+	m_data{elements(m_block)}
+{}
+
+template<typename T>
+utils::shared_dynarray<T>::~shared_dynarray() {
+	release(m_block);
+}
+
+//============================================================
+// Assignment Operator
+//============================================================
+
+template<typename T>
+auto utils::shared_dynarray<T>::operator=(shared_dynarray const& other) -> shared_dynarray & {
+	auto copy = other;
+	return *this = std::move(copy);
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::operator=(shared_dynarray && other) -> shared_dynarray & {
+	std::swap(m_block, other.m_block);
+	std::swap(m_data, other.m_data);
+	return *this;
+}
+
+//============================================================
+// Access API
+//============================================================
+
+template<typename T>
+auto utils::shared_dynarray<T>::at(size_type pos) -> reference {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access element at position "s +
+			std::to_string(pos) +
+			" from a shared_dynarray with size " +
+			std::to_string(size())
+		};
+	}
+	detach();
+	return m_data[pos];
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::at(size_type pos) const -> const_reference {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access element at position "s +
+			std::to_string(pos) +
+			" from a shared_dynarray with size " +
+			std::to_string(size())
+		};
+	}
+	return m_data[pos];
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::operator[](size_type pos) -> reference {
+	detach();
+	return m_data[pos];
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::operator[](size_type pos) const -> const_reference {
+	return m_data[pos];
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::front() -> reference {
+	detach();
+	return m_data[0];
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::front() const -> const_reference {
+	return m_data[0];
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::back() -> reference {
+	detach();
+	return m_data[size() - 1];
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::back() const -> const_reference {
+	return m_data[size() - 1];
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::data() -> pointer {
+	detach();
+	return m_data;
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::data() const -> const_pointer {
+	return m_data;
+}
+
+//============================================================
+// Capacity API
+//============================================================
+
+template<typename T>
+auto utils::shared_dynarray<T>::empty() const -> bool {
+	return size() == 0;
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::size() const -> size_type {
+	return m_block != nullptr ? m_block->size : 0;
+}
+
+//============================================================
+// Sharing API
+//============================================================
+
+template<typename T>
+auto utils::shared_dynarray<T>::use_count() const -> size_type {
+	return m_block != nullptr ? m_block->refs.load(std::memory_order_acquire) : 0;
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::unique() const -> bool {
+	return use_count() <= 1;
+}
+
+template<typename T>
+void utils::shared_dynarray<T>::detach() {
+	if (unique()) {
+		return;
+	}
+	auto const source = m_data;
+	auto const block = create(size(), [source](pointer ptr, size_type pos) {
+		::new (static_cast<void *>(ptr)) T(source[pos]);
+	});
+	release(m_block);
+	m_block = block;
+	m_data = elements(block);
+}
+
+//============================================================
+// Mutate API
+//============================================================
+
+template<typename T>
+void utils::shared_dynarray<T>::fill(T const& value) {
+	if (!unique()) {
+		// Constructing a fresh buffer avoids copying elements
+		// that are overwritten right afterwards anyway.
+		*this = shared_dynarray(size(), value);
+		return;
+	}
+	std::fill(m_data, m_data + size(), value);
+}
+
+//============================================================
+// Iterator API
+//============================================================
+
+template<typename T>
+auto utils::shared_dynarray<T>::begin() -> iterator {
+	return data();
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::begin() const -> const_iterator {
+	return m_data;
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::cbegin() const -> const_iterator {
+	return m_data;
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::end() -> iterator {
+	return data() + size();
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::end() const -> const_iterator {
+	return m_data + size();
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::cend() const -> const_iterator {
+	return m_data + size();
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::rbegin() -> reverse_iterator {
+	return reverse_iterator{end()};
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::rbegin() const -> const_reverse_iterator {
+	return const_reverse_iterator{end()};
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::crbegin() const -> const_reverse_iterator {
+	return const_reverse_iterator{cend()};
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::rend() -> reverse_iterator {
+	return reverse_iterator{begin()};
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::rend() const -> const_reverse_iterator {
+	return const_reverse_iterator{begin()};
+}
+
+template<typename T>
+auto utils::shared_dynarray<T>::crend() const -> const_reverse_iterator {
+	return const_reverse_iterator{cbegin()};
+}
+
+#endif // UTILS_SHARED_DYNARRAY_HPP
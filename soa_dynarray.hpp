@@ -0,0 +1,710 @@
+//===---------------------------------------------------------
+//                       SOA_DYNARRAY
+//===---------------------------------------------------------
+//
+// Structure-of-arrays variant of the dynarray container.
+// A row consists of one element of every field type but
+// each field is stored in its own contiguous column so
+// that loops touching only a few fields do not waste
+// cache lines and memory bandwidth on all the others.
+//
+// All columns are carved out of a single heap allocation
+// and each column starts on its own cache line.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_SOA_DYNARRAY_HPP
+#define UTILS_SOA_DYNARRAY_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// headers used by definition site
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	/// Fixed-size container that stores rows of the field types \Ts...
+	/// column by column instead of row by row.
+	///
+	/// Rows are accessed through proxy references that forward to the
+	/// elements in the individual columns. Kernels that want to process
+	/// a single field can obtain a raw pointer to its column via column<I>()
+	/// which is suitable for auto-vectorization or hand-written SIMD code.
+	///
+	/// Conversions from and to dynarray<std::tuple<Ts...>> are provided
+	/// to interoperate with row-oriented code.
+	template<typename... Ts>
+	class soa_dynarray {
+		static_assert(sizeof...(Ts) > 0,
+			"soa_dynarray requires at least one field type");
+
+		template<typename Owner, typename... Us>
+		class basic_reference;
+
+		template<typename Owner, typename Reference>
+		class basic_iterator;
+
+	public:
+
+	//============================================================
+	// Type aliases
+	//============================================================
+
+		using value_type      = std::tuple<Ts...>;
+		using size_type       = size_t;
+		using difference_type = std::ptrdiff_t;
+		using reference       = basic_reference<soa_dynarray, Ts...>;
+		using const_reference = basic_reference<soa_dynarray const, Ts const...>;
+		using iterator        = basic_iterator<soa_dynarray, reference>;
+		using const_iterator  = basic_iterator<soa_dynarray const, const_reference>;
+
+		/// The type of the field with index \I.
+		template<size_t I>
+		using field_type = typename std::tuple_element<I, value_type>::type;
+
+		/// The number of fields (columns) per row.
+		static constexpr size_type field_count = sizeof...(Ts);
+
+		/// Every column starts at an address that is a multiple of this.
+		static constexpr size_type column_alignment = 64;
+
+	//============================================================
+	// Constructors
+	//============================================================
+
+	// (1) construct by count
+	//============================================================
+		explicit soa_dynarray(size_type count);
+
+	// (2) construct by count and copied row value
+	//============================================================
+		soa_dynarray(size_type count, value_type const& value);
+
+	// (3) copy-construct
+	//============================================================
+		soa_dynarray(soa_dynarray const& other);
+
+	// (4) move-construct
+	//============================================================
+		soa_dynarray(soa_dynarray && other);
+
+	// (5) construct from row-oriented dynarray
+	//============================================================
+		explicit soa_dynarray(dynarray<value_type> const& rows);
+
+		~soa_dynarray();
+
+	//============================================================
+	// Assignment Operator
+	//============================================================
+
+		/// Copy-Assigns from the specified \other soa_dynarray instance.
+		/// Throws an invalid_argument exception when the sizes of both
+		/// soa_dynarrays are unequal.
+		auto operator=(soa_dynarray const& other) -> soa_dynarray &;
+
+		/// Move-Assigns from the specified \other soa_dynarray instance.
+		auto operator=(soa_dynarray && other) -> soa_dynarray &;
+
+	//============================================================
+	// Access API
+	//============================================================
+
+		/// Access the row at the specified position \pos with bounds checking.
+		/// Throws out_of_bounds exception if \pos was illegal.
+		auto at(size_type pos) -> reference;
+
+		/// Read-only access to the row at the specified position \pos with bounds checking.
+		/// Throws out_of_bounds exception if \pos was illegal.
+		auto at(size_type pos) const -> const_reference;
+
+		/// Access the row at the specified position \pos without bounds checking.
+		auto operator[](size_type pos) -> reference;
+
+		/// Read-only access the row at the specified position \pos without bounds checking.
+		auto operator[](size_type pos) const -> const_reference;
+
+		/// Returns a raw-pointer to the contiguous column of field \I.
+		template<size_t I>
+		auto column() -> field_type<I> *;
+
+		/// Returns a read-only raw-pointer to the contiguous column of field \I.
+		template<size_t I>
+		auto column() const -> field_type<I> const*;
+
+	//============================================================
+	// Capacity API
+	//============================================================
+
+		/// Returns `true` if this soa_dynarray is empty and `false` otherwise.
+		auto empty() const -> bool;
+
+		/// Returns the count of rows in this soa_dynarray.
+		auto size() const -> size_type;
+
+	//============================================================
+	// Mutate API
+	//============================================================
+
+		/// Fills all rows of this soa_dynarray with the fields of \value.
+		void fill(value_type const& value);
+
+	//============================================================
+	// Conversion API
+	//============================================================
+
+		/// Returns a row-oriented copy of all rows in this soa_dynarray.
+		auto to_dynarray() const -> dynarray<value_type>;
+
+	//============================================================
+	// Iterator API
+	//============================================================
+
+		/// Returns an iterator to the first row in this soa_dynarray.
+		auto begin()        -> iterator;
+
+		/// Returns a read-only iterator to the first row in this soa_dynarray.
+		auto begin() const  -> const_iterator;
+
+		/// Returns a read-only iterator to the first row in this soa_dynarray.
+		auto cbegin() const -> const_iterator;
+
+		/// Returns an iterator to the position behind the last row in this soa_dynarray.
+		auto end()        -> iterator;
+
+		/// Returns a read-only iterator to the position behind the last row in this soa_dynarray.
+		auto end() const  -> const_iterator;
+
+		/// Returns a read-only iterator to the position behind the last row in this soa_dynarray.
+		auto cend() const -> const_iterator;
+
+	private:
+
+	//============================================================
+	// Proxy types
+	//============================================================
+
+		/// Proxy reference to a single row that forwards to the
+		/// elements of that row in all columns.
+		template<typename Owner, typename... Us>
+		class basic_reference {
+		public:
+			basic_reference(Owner & owner, size_type pos):
+				m_owner{&owner},
+				m_pos{pos}
+			{}
+
+			basic_reference(basic_reference const&) = default;
+
+			/// Allows to convert a mutable reference into a read-only one.
+			operator basic_reference<Owner const, Us const...>() const {
+				return {*m_owner, m_pos};
+			}
+
+			/// Returns a copy of all fields of the referenced row.
+			operator value_type() const {
+				return to_tuple(std::index_sequence_for<Ts...>{});
+			}
+
+			/// Assigns all fields of \value to the referenced row.
+			auto operator=(value_type const& value) const -> basic_reference const& {
+				assign(value, std::index_sequence_for<Ts...>{});
+				return *this;
+			}
+
+			/// Assigns all fields of the row referenced by \other to the referenced row.
+			auto operator=(basic_reference const& other) const -> basic_reference const& {
+				return *this = static_cast<value_type>(other);
+			}
+
+			/// Accesses the field \I of the referenced row.
+			template<size_t I>
+			auto get() const -> typename std::tuple_element<I, std::tuple<Us...>>::type & {
+				return m_owner->template column<I>()[m_pos];
+			}
+
+		private:
+			template<size_t... Is>
+			auto to_tuple(std::index_sequence<Is...>) const -> value_type {
+				return value_type{get<Is>()...};
+			}
+
+			template<size_t... Is>
+			void assign(value_type const& value, std::index_sequence<Is...>) const {
+				using swallow = int[];
+				(void)swallow{0, (get<Is>() = std::get<Is>(value), 0)...};
+			}
+
+			Owner *   m_owner;
+			size_type m_pos;
+		};
+
+		/// Random-access iterator over proxy row references.
+		template<typename Owner, typename Reference>
+		class basic_iterator {
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type        = soa_dynarray::value_type;
+			using difference_type   = std::ptrdiff_t;
+			using reference         = Reference;
+			using pointer           = void;
+
+			basic_iterator(Owner & owner, size_type pos):
+				m_owner{&owner},
+				m_pos{pos}
+			{}
+
+			auto operator*() const -> reference { return {*m_owner, m_pos}; }
+			auto operator[](difference_type n) const -> reference { return {*m_owner, m_pos + n}; }
+
+			auto operator++() -> basic_iterator & { ++m_pos; return *this; }
+			auto operator--() -> basic_iterator & { --m_pos; return *this; }
+			auto operator++(int) -> basic_iterator { auto it = *this; ++m_pos; return it; }
+			auto operator--(int) -> basic_iterator { auto it = *this; --m_pos; return it; }
+
+			auto operator+=(difference_type n) -> basic_iterator & { m_pos += n; return *this; }
+			auto operator-=(difference_type n) -> basic_iterator & { m_pos -= n; return *this; }
+			auto operator+(difference_type n) const -> basic_iterator { return {*m_owner, m_pos + n}; }
+			auto operator-(difference_type n) const -> basic_iterator { return {*m_owner, m_pos - n}; }
+
+			auto operator-(basic_iterator const& rhs) const -> difference_type {
+				return static_cast<difference_type>(m_pos) - static_cast<difference_type>(rhs.m_pos);
+			}
+
+			auto operator==(basic_iterator const& rhs) const -> bool { return m_pos == rhs.m_pos; }
+			auto operator!=(basic_iterator const& rhs) const -> bool { return m_pos != rhs.m_pos; }
+			auto operator< (basic_iterator const& rhs) const -> bool { return m_pos <  rhs.m_pos; }
+			auto operator> (basic_iterator const& rhs) const -> bool { return m_pos >  rhs.m_pos; }
+			auto operator<=(basic_iterator const& rhs) const -> bool { return m_pos <= rhs.m_pos; }
+			auto operator>=(basic_iterator const& rhs) const -> bool { return m_pos >= rhs.m_pos; }
+
+		private:
+			Owner *   m_owner;
+			size_type m_pos;
+		};
+
+	//============================================================
+	// Storage helpers
+	//============================================================
+
+		using columns_type = std::tuple<Ts *...>;
+
+		/// Allocates the shared buffer for all columns and sets up the column pointers.
+		void allocate();
+
+		template<size_t... Is>
+		static auto make_columns(
+			std::uintptr_t base,
+			size_type const* offsets,
+			std::index_sequence<Is...>
+		) -> columns_type;
+
+		/// Constructs all elements of the columns starting at \I by calling
+		/// \init for every element. Destroys already constructed elements
+		/// if any element construction throws.
+		template<typename Init, size_t I>
+		void construct_columns(Init const& init, std::integral_constant<size_t, I>);
+
+		template<typename Init>
+		void construct_columns(Init const&, std::integral_constant<size_t, sizeof...(Ts)>);
+
+		template<size_t... Is>
+		void destroy_columns(std::index_sequence<Is...>);
+
+		template<size_t... Is>
+		void copy_columns(soa_dynarray const& other, std::index_sequence<Is...>);
+
+		template<size_t... Is>
+		void fill_columns(value_type const& value, std::index_sequence<Is...>);
+
+	//============================================================
+	// Member Variables
+	//============================================================
+
+		std::unique_ptr<unsigned char[]> m_buffer;
+		columns_type                     m_columns;
+		size_type                        m_size;
+	};
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+namespace utils {
+	namespace detail {
+		/// Rounds \offset up to the next multiple of \alignment.
+		inline auto align_up(size_t offset, size_t alignment) -> size_t {
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+
+		/// Element initializers used by soa_dynarray::construct_columns.
+		struct soa_default_init {
+			template<size_t I, typename U>
+			void construct(U * ptr, size_t) const {
+				::new (static_cast<void *>(ptr)) U;
+			}
+		};
+
+		template<typename Tuple>
+		struct soa_value_init {
+			Tuple const& value;
+
+			template<size_t I, typename U>
+			void construct(U * ptr, size_t) const {
+				::new (static_cast<void *>(ptr)) U(std::get<I>(value));
+			}
+		};
+
+		template<typename Tuple>
+		struct soa_rows_init {
+			Tuple const* rows;
+
+			template<size_t I, typename U>
+			void construct(U * ptr, size_t pos) const {
+				::new (static_cast<void *>(ptr)) U(std::get<I>(rows[pos]));
+			}
+		};
+
+		template<typename Soa>
+		struct soa_copy_init {
+			Soa const& other;
+
+			template<size_t I, typename U>
+			void construct(U * ptr, size_t pos) const {
+				::new (static_cast<void *>(ptr)) U(other.template column<I>()[pos]);
+			}
+		};
+
+		template<typename U>
+		void destroy_n(U * ptr, size_t count) {
+			for (size_t i = 0; i != count; ++i) {
+				ptr[i].~U();
+			}
+		}
+	}
+}
+
+template<typename... Ts>
+constexpr typename utils::soa_dynarray<Ts...>::size_type utils::soa_dynarray<Ts...>::field_count;
+
+template<typename... Ts>
+constexpr typename utils::soa_dynarray<Ts...>::size_type utils::soa_dynarray<Ts...>::column_alignment;
+
+//============================================================
+// Storage helpers
+//============================================================
+
+template<typename... Ts>
+void utils::soa_dynarray<Ts...>::allocate() {
+	size_type const alignments[] = {
+		(alignof(Ts) > column_alignment ? alignof(Ts) : column_alignment)...
+	};
+	size_type const sizes[] = { sizeof(Ts)... };
+	size_type offsets[sizeof...(Ts)];
+	size_type total = 0;
+	size_type max_alignment = 0;
+	for (size_type i = 0; i != sizeof...(Ts); ++i) {
+		total = detail::align_up(total, alignments[i]);
+		offsets[i] = total;
+		total += sizes[i] * m_size;
+		max_alignment = alignments[i] > max_alignment ? alignments[i] : max_alignment;
+	}
+	m_buffer.reset(new unsigned char[total + max_alignment - 1]);
+	auto const base = reinterpret_cast<std::uintptr_t>(m_buffer.get());
+	auto const aligned = static_cast<std::uintptr_t>(detail::align_up(base, max_alignment));
+	m_columns = make_columns(aligned, offsets, std::index_sequence_for<Ts...>{});
+}
+
+template<typename... Ts>
+template<size_t... Is>
+auto utils::soa_dynarray<Ts...>::make_columns(
+	std::uintptr_t base,
+	size_type const* offsets,
+	std::index_sequence<Is...>
+) -> columns_type {
+	return columns_type{reinterpret_cast<Ts *>(base + offsets[Is])...};
+}
+
+template<typename... Ts>
+template<typename Init, size_t I>
+void utils::soa_dynarray<Ts...>::construct_columns(Init const& init, std::integral_constant<size_t, I>) {
+	auto const column = std::get<I>(m_columns);
+	size_type constructed = 0;
+	try {
+		for (; constructed != m_size; ++constructed) {
+			init.template construct<I>(column + constructed, constructed);
+		}
+		construct_columns(init, std::integral_constant<size_t, I + 1>{});
+	}
+	catch (...) {
+		detail::destroy_n(column, constructed);
+		throw;
+	}
+}
+
+template<typename... Ts>
+template<typename Init>
+void utils::soa_dynarray<Ts...>::construct_columns(Init const&, std::integral_constant<size_t, sizeof...(Ts)>) {}
+
+template<typename... Ts>
+template<size_t... Is>
+void utils::soa_dynarray<Ts...>::destroy_columns(std::index_sequence<Is...>) {
+	using swallow = int[];
+	(void)swallow{0, (detail::destroy_n(std::get<Is>(m_columns), m_size), 0)...};
+}
+
+template<typename... Ts>
+template<size_t... Is>
+void utils::soa_dynarray<Ts...>::copy_columns(soa_dynarray const& other, std::index_sequence<Is...>) {
+	using swallow = int[];
+	(void)swallow{0, (std::copy(
+		other.template column<Is>(), other.template column<Is>() + m_size, column<Is>()), 0)...};
+}
+
+template<typename... Ts>
+template<size_t... Is>
+void utils::soa_dynarray<Ts...>::fill_columns(value_type const& value, std::index_sequence<Is...>) {
+	using swallow = int[];
+	(void)swallow{0, (std::fill(column<Is>(), column<Is>() + m_size, std::get<Is>(value)), 0)...};
+}
+
+// (1) construct by count
+//============================================================
+template<typename... Ts>
+utils::soa_dynarray<Ts...>::soa_dynarray(size_type count):
+	m_buffer{},
+	m_columns{},
+	m_size{count}
+{
+	allocate();
+	construct_columns(detail::soa_default_init{}, std::integral_constant<size_t, 0>{});
+}
+
+// (2) construct by count and copied row value
+//============================================================
+template<typename... Ts>
+utils::soa_dynarray<Ts...>::soa_dynarray(size_type count, value_type const& value):
+	m_buffer{},
+	m_columns{},
+	m_size{count}
+{
+	allocate();
+	construct_columns(detail::soa_value_init<value_type>{value}, std::integral_constant<size_t, 0>{});
+}
+
+// (3) copy-construct
+//============================================================
+template<typename... Ts>
+utils::soa_dynarray<Ts...>::soa_dynarray(soa_dynarray const& other):
+	m_buffer{},
+	m_columns{},
+	m_size{other.size()}
+{
+	allocate();
+	construct_columns(detail::soa_copy_init<soa_dynarray>{other}, std::integral_constant<size_t, 0>{});
+}
+
+// (4) move-construct
+//============================================================
+template<typename... Ts>
+utils::soa_dynarray<Ts...>::soa_dynarray(soa_dynarray && other):
+	m_buffer{std::move(other.m_buffer)},
+	m_columns{other.m_columns},
+	m_size{other.size()}
+{
+	other.m_columns = columns_type{};
+	other.m_size = 0;
+}
+
+// (5) construct from row-oriented dynarray
+//============================================================
+template<typename... Ts>
+utils::soa_dynarray<Ts...>::soa_dynarray(dynarray<value_type> const& rows):
+	m_buffer{},
+	m_columns{},
+	m_size{rows.size()}
+{
+	allocate();
+	construct_columns(detail::soa_rows_init<value_type>{rows.data()}, std::integral_constant<size_t, 0>{});
+}
+
+template<typename... Ts>
+utils::soa_dynarray<Ts...>::~soa_dynarray() {
+	if (m_buffer) {
+		destroy_columns(std::index_sequence_for<Ts...>{});
+	}
+}
+
+//============================================================
+// Assignment Operator
+//============================================================
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::operator=(soa_dynarray const& other) -> soa_dynarray & {
+	if (size() != other.size()) {
+		using namespace std::string_literals;
+		throw std::invalid_argument{
+			"cannot copy-assign soa_dynarray of size "s +
+			std::to_string(other.size()) +
+			" into soa_dynarray of size " +
+			std::to_string(size())
+		};
+	}
+	copy_columns(other, std::index_sequence_for<Ts...>{});
+	return *this;
+}
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::operator=(soa_dynarray && other) -> soa_dynarray & {
+	std::swap(m_buffer, other.m_buffer);
+	std::swap(m_columns, other.m_columns);
+	std::swap(m_size, other.m_size);
+	return *this;
+}
+
+//============================================================
+// Access API
+//============================================================
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::at(size_type pos) -> reference {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access row at position "s +
+			std::to_string(pos) +
+			" from a soa_dynarray with size " +
+			std::to_string(size())
+		};
+	}
+	return reference{*this, pos};
+}
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::at(size_type pos) const -> const_reference {
+	if (pos >= size()) {
+		using namespace std::string_literals;
+		throw std::out_of_range{
+			"cannot access row at position "s +
+			std::to_string(pos) +
+			" from a soa_dynarray with size " +
+			std::to_string(size())
+		};
+	}
+	return const_reference{*this, pos};
+}
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::operator[](size_type pos) -> reference {
+	return reference{*this, pos};
+}
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::operator[](size_type pos) const -> const_reference {
+	return const_reference{*this, pos};
+}
+
+template<typename... Ts>
+template<size_t I>
+auto utils::soa_dynarray<Ts...>::column() -> field_type<I> * {
+	return std::get<I>(m_columns);
+}
+
+template<typename... Ts>
+template<size_t I>
+auto utils::soa_dynarray<Ts...>::column() const -> field_type<I> const* {
+	return std::get<I>(m_columns);
+}
+
+//============================================================
+// Capacity API
+//============================================================
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::empty() const -> bool {
+	return m_size == 0;
+}
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::size() const -> size_type {
+	return m_size;
+}
+
+//============================================================
+// Mutate API
+//============================================================
+
+template<typename... Ts>
+void utils::soa_dynarray<Ts...>::fill(value_type const& value) {
+	fill_columns(value, std::index_sequence_for<Ts...>{});
+}
+
+//============================================================
+// Conversion API
+//============================================================
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::to_dynarray() const -> dynarray<value_type> {
+	auto rows = dynarray<value_type>(size());
+	std::copy(begin(), end(), rows.begin());
+	return rows;
+}
+
+//============================================================
+// Iterator API
+//============================================================
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::begin() -> iterator {
+	return iterator{*this, 0};
+}
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::begin() const -> const_iterator {
+	return const_iterator{*this, 0};
+}
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::cbegin() const -> const_iterator {
+	return const_iterator{*this, 0};
+}
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::end() -> iterator {
+	return iterator{*this, size()};
+}
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::end() const -> const_iterator {
+	return const_iterator{*this, size()};
+}
+
+template<typename... Ts>
+auto utils::soa_dynarray<Ts...>::cend() const -> const_iterator {
+	return const_iterator{*this, size()};
+}
+
+#endif // UTILS_SOA_DYNARRAY_HPP
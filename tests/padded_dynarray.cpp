@@ -0,0 +1,50 @@
+//===---------------------------------------------------------
+//                  PADDED_DYNARRAY TESTS
+//===---------------------------------------------------------
+//
+// Standalone test, build and run with e.g.
+//   g++ -std=c++14 -I.. padded_dynarray.cpp && ./a.out
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#include "padded_dynarray.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace {
+	/// Leaves a freed heap block of 0xAB bytes behind for the next allocation to reuse.
+	void dirty_heap(std::size_t bytes) {
+		auto block = std::unique_ptr<unsigned char[]>{new unsigned char[bytes]};
+		std::memset(block.get(), 0xAB, bytes);
+	}
+
+	void fresh_atomic_slots_start_at_zero() {
+		constexpr std::size_t count = 8;
+		dirty_heap(count * utils::padded_dynarray<std::atomic<std::uint64_t>>::stride + 64);
+		utils::padded_dynarray<std::atomic<std::uint64_t>> slots(count);
+		assert(slots.sum(std::uint64_t{0}) == 0);
+		for (auto & slot : slots) {
+			slot.fetch_add(3, std::memory_order_relaxed);
+		}
+		assert(slots.sum(std::uint64_t{0}) == 3 * count);
+	}
+
+	void fresh_scalar_slots_start_at_zero() {
+		dirty_heap(16 * utils::padded_dynarray<int>::stride + 64);
+		utils::padded_dynarray<int> slots(16);
+		for (auto const& slot : slots) {
+			assert(slot == 0);
+		}
+	}
+}
+
+int main() {
+	fresh_atomic_slots_start_at_zero();
+	fresh_scalar_slots_start_at_zero();
+}
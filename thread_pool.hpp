@@ -0,0 +1,542 @@
+//===---------------------------------------------------------
+//                       THREAD_POOL
+//===---------------------------------------------------------
+//
+// Small work-stealing thread pool used as the scheduler of
+// all parallel dynarray operations.
+//
+// Every worker owns a Chase-Lev deque of tasks: it pushes
+// and pops tasks at the bottom while idle workers steal from
+// the top of other deques. Parallel loops split their range
+// recursively in halves, push the right half and continue
+// with the left half so that work is distributed lazily and
+// only when some worker is actually idle.
+//
+// Tasks live on the stack of the forking thread which waits
+// for them before returning. Waiting threads execute other
+// tasks in the meantime, hence the pool does not allocate
+// on the task path and nested parallelism does not block.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The header-only declaration and definition is
+// contained entirely in this single header file.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+// Author Robin Freyler (C) 2016
+// Licence: MIT
+//===---------------------------------------------------------
+
+#ifndef UTILS_THREAD_POOL_HPP
+#define UTILS_THREAD_POOL_HPP
+
+// headers used by declaration site
+#include "dynarray.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// headers used by definition site
+#include <functional>
+#include <utility>
+
+//============================================================
+// DECLARATION
+//============================================================
+
+namespace utils {
+	namespace detail {
+		/// Unit of work that is pushed onto and stolen from the deques.
+		struct pool_task {
+			void (*execute)(pool_task *);
+			std::atomic<bool>  done;
+			std::exception_ptr error;
+
+			explicit pool_task(void (*fn)(pool_task *)):
+				execute{fn},
+				done{false},
+				error{}
+			{}
+		};
+
+		/// Chase-Lev work-stealing deque with a fixed capacity.
+		///
+		/// The owning thread pushes and pops at the bottom, any other
+		/// thread may steal from the top. Follows the C11 formulation
+		/// of Lê, Pop, Cohen and Zappa Nardelli (PPoPP 2013).
+		class work_stealing_deque {
+		public:
+			static constexpr std::int64_t capacity = 1024;
+
+			work_stealing_deque();
+
+			/// Pushes \task at the bottom. Returns `false` if the deque is full.
+			/// Must only be called by the owning thread.
+			auto push(pool_task * task) -> bool;
+
+			/// Pops the most recently pushed task or returns nullptr.
+			/// Must only be called by the owning thread.
+			auto pop() -> pool_task *;
+
+			/// Steals the least recently pushed task or returns nullptr.
+			auto steal() -> pool_task *;
+
+			/// Returns `true` if the deque appears to contain tasks.
+			auto has_tasks() const -> bool;
+
+		private:
+			// Padding keeps the index stolen from by thieves and the
+			// index updated by the owner on separate cache lines.
+			std::atomic<std::int64_t>                   m_top;
+			unsigned char                               m_padding[2 * 64 - sizeof(std::atomic<std::int64_t>)];
+			std::atomic<std::int64_t>                   m_bottom;
+			std::unique_ptr<std::atomic<pool_task *>[]> m_tasks;
+		};
+	}
+
+	/// Work-stealing pool of worker threads.
+	///
+	/// Threads that are not workers of the pool may use it as well:
+	/// such external callers are serialized and temporarily take over
+	/// a dedicated deque for the duration of their call.
+	class thread_pool {
+	public:
+
+	//============================================================
+	// Constructors
+	//============================================================
+
+		/// Creates a pool with \workers worker threads.
+		explicit thread_pool(size_t workers);
+
+		/// Stops and joins all worker threads.
+		~thread_pool();
+
+		thread_pool(thread_pool const&) = delete;
+		auto operator=(thread_pool const&) -> thread_pool & = delete;
+
+		/// Returns the process-wide pool with one worker less than there are
+		/// hardware threads since the calling thread participates as well.
+		static auto instance() -> thread_pool &;
+
+	//============================================================
+	// Scheduling API
+	//============================================================
+
+		/// Returns the number of worker threads plus one for the calling thread.
+		auto concurrency() const -> size_t;
+
+		/// Invokes \f(first, last) for disjoint subranges of [\first, \last)
+		/// with at most \grain elements each and blocks until all returned.
+		/// Ranges of at most \grain elements are processed by the calling
+		/// thread directly without touching the pool.
+		/// Rethrows an exception thrown by any invocation of \f.
+		template<typename F>
+		void parallel_for(size_t first, size_t last, size_t grain, F && f);
+
+		/// Invokes \f1 and \f2, potentially in parallel, and blocks until both returned.
+		template<typename F1, typename F2>
+		void parallel_invoke(F1 && f1, F2 && f2);
+
+	private:
+		struct context {
+			thread_pool *                 pool;
+			detail::work_stealing_deque * deque;
+			size_t                        index;
+		};
+
+		/// Returns the context of the calling thread if it is associated with a pool.
+		static auto current() -> context *&;
+
+		/// Pushes \task on the deque of the calling thread and wakes up sleeping workers.
+		auto push(context & ctx, detail::pool_task & task) -> bool;
+
+		/// Executes other tasks until \task is done. Rethrows its exception.
+		void join(context & ctx, detail::pool_task & task);
+
+		/// Tries to steal a task from any deque except the one at \self.
+		auto steal(size_t self) -> detail::pool_task *;
+
+		/// Runs \task and marks it as done.
+		static void run(detail::pool_task * task);
+
+		/// Forks \f2 as a task, runs \f1 on the calling thread and joins.
+		/// Requires the calling thread to be associated with this pool.
+		template<typename F1, typename F2>
+		void fork_join(context & ctx, F1 & f1, F2 & f2);
+
+		/// Recursively splits [\first, \last) and forks the right halves.
+		template<typename F>
+		void split(context & ctx, size_t first, size_t last, size_t grain, F & f);
+
+		/// Associates the calling external thread with the external deque while
+		/// \body is executed, or executes \body directly for pool threads.
+		template<typename Body>
+		void enter(Body & body);
+
+		void work(size_t index);
+
+		std::vector<std::thread>                       m_workers;
+		std::unique_ptr<detail::work_stealing_deque[]> m_deques;
+		size_t                                         m_deque_count;
+		std::mutex                                     m_external_mutex;
+		std::mutex                                     m_sleep_mutex;
+		std::condition_variable                        m_sleep;
+		std::atomic<size_t>                            m_sleeping;
+		size_t                                         m_wake_epoch;
+		std::atomic<bool>                              m_stop;
+	};
+
+	/// Invokes \f(first, last) on the default thread_pool for disjoint
+	/// iterator subranges of \array with at most \grain elements each.
+	/// Blocks until all elements have been processed.
+	template<typename T, typename F>
+	void parallel_for(dynarray<T> & array, size_t grain, F && f);
+
+	/// Read-only variant of parallel_for.
+	template<typename T, typename F>
+	void parallel_for(dynarray<T> const& array, size_t grain, F && f);
+}
+
+//============================================================
+// IMPLEMENTATION
+//============================================================
+
+//============================================================
+// Chase-Lev deque
+//============================================================
+
+inline utils::detail::work_stealing_deque::work_stealing_deque():
+	m_top{0},
+	m_padding{},
+	m_bottom{0},
+	m_tasks{new std::atomic<pool_task *>[capacity]}
+{}
+
+inline auto utils::detail::work_stealing_deque::push(pool_task * task) -> bool {
+	auto const bottom = m_bottom.load(std::memory_order_relaxed);
+	auto const top = m_top.load(std::memory_order_acquire);
+	if (bottom - top >= capacity) {
+		return false;
+	}
+	m_tasks[bottom & (capacity - 1)].store(task, std::memory_order_relaxed);
+	// Publishes the task and its contents to thieves.
+	m_bottom.store(bottom + 1, std::memory_order_release);
+	return true;
+}
+
+inline auto utils::detail::work_stealing_deque::pop() -> pool_task * {
+	auto const bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	auto top = m_top.load(std::memory_order_relaxed);
+	if (top > bottom) {
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	auto task = m_tasks[bottom & (capacity - 1)].load(std::memory_order_relaxed);
+	if (top == bottom) {
+		// Last task: race against concurrent thieves.
+		if (!m_top.compare_exchange_strong(top, top + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			task = nullptr;
+		}
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return task;
+}
+
+inline auto utils::detail::work_stealing_deque::steal() -> pool_task * {
+	auto top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	auto const bottom = m_bottom.load(std::memory_order_acquire);
+	if (top >= bottom) {
+		return nullptr;
+	}
+	auto const task = m_tasks[top & (capacity - 1)].load(std::memory_order_relaxed);
+	if (!m_top.compare_exchange_strong(top, top + 1,
+			std::memory_order_seq_cst, std::memory_order_relaxed)) {
+		return nullptr;
+	}
+	return task;
+}
+
+inline auto utils::detail::work_stealing_deque::has_tasks() const -> bool {
+	return m_bottom.load(std::memory_order_seq_cst) > m_top.load(std::memory_order_seq_cst);
+}
+
+//============================================================
+// Constructors
+//============================================================
+
+inline utils::thread_pool::thread_pool(size_t workers):
+	m_workers{},
+	m_deques{new detail::work_stealing_deque[workers + 1]},
+	m_deque_count{workers + 1},
+	m_external_mutex{},
+	m_sleep_mutex{},
+	m_sleep{},
+	m_sleeping{0},
+	m_wake_epoch{0},
+	m_stop{false}
+{
+	m_workers.reserve(workers);
+	for (size_t i = 0; i != workers; ++i) {
+		m_workers.emplace_back([this, i] { work(i); });
+	}
+}
+
+inline utils::thread_pool::~thread_pool() {
+	{
+		std::lock_guard<std::mutex> lock{m_sleep_mutex};
+		m_stop.store(true, std::memory_order_seq_cst);
+		++m_wake_epoch;
+	}
+	m_sleep.notify_all();
+	for (auto & worker : m_workers) {
+		worker.join();
+	}
+}
+
+inline auto utils::thread_pool::instance() -> thread_pool & {
+	static thread_pool pool{[] {
+		auto const threads = std::thread::hardware_concurrency();
+		return threads > 1 ? size_t{threads - 1} : size_t{0};
+	}()};
+	return pool;
+}
+
+//============================================================
+// Scheduling API
+//============================================================
+
+inline auto utils::thread_pool::concurrency() const -> size_t {
+	return m_workers.size() + 1;
+}
+
+inline auto utils::thread_pool::current() -> context *& {
+	thread_local context * ctx = nullptr;
+	return ctx;
+}
+
+template<typename Body>
+void utils::thread_pool::enter(Body & body) {
+	auto & ctx = current();
+	if (ctx != nullptr && ctx->pool == this) {
+		body(*ctx);
+		return;
+	}
+	// External thread: take over the dedicated external deque.
+	std::lock_guard<std::mutex> lock{m_external_mutex};
+	auto const external = m_deque_count - 1;
+	auto previous = ctx;
+	context local{this, &m_deques[external], external};
+	ctx = &local;
+	try {
+		body(local);
+	}
+	catch (...) {
+		ctx = previous;
+		throw;
+	}
+	ctx = previous;
+}
+
+template<typename F>
+void utils::thread_pool::parallel_for(size_t first, size_t last, size_t grain, F && f) {
+	if (grain == 0) {
+		grain = 1;
+	}
+	if (first >= last) {
+		return;
+	}
+	if (m_workers.empty()) {
+		// Still honor the grain since callers may size buffers by it.
+		for (; last - first > grain; first += grain) {
+			f(first, first + grain);
+		}
+		f(first, last);
+		return;
+	}
+	if (last - first <= grain) {
+		f(first, last);
+		return;
+	}
+	auto body = [&](context & ctx) { split(ctx, first, last, grain, f); };
+	enter(body);
+}
+
+template<typename F1, typename F2>
+void utils::thread_pool::parallel_invoke(F1 && f1, F2 && f2) {
+	if (m_workers.empty()) {
+		f1();
+		f2();
+		return;
+	}
+	auto body = [&](context & ctx) { fork_join(ctx, f1, f2); };
+	enter(body);
+}
+
+template<typename F>
+void utils::thread_pool::split(context & ctx, size_t first, size_t last, size_t grain, F & f) {
+	if (last - first <= grain) {
+		f(first, last);
+		return;
+	}
+	auto const mid = first + (last - first) / 2;
+	auto left = [&] { split(ctx, first, mid, grain, f); };
+	auto right = [&] { split(*current(), mid, last, grain, f); };
+	fork_join(ctx, left, right);
+}
+
+template<typename F1, typename F2>
+void utils::thread_pool::fork_join(context & ctx, F1 & f1, F2 & f2) {
+	struct closure : detail::pool_task {
+		F2 * f;
+		explicit closure(F2 & fn):
+			detail::pool_task{[](detail::pool_task * self) { (*static_cast<closure *>(self)->f)(); }},
+			f{&fn}
+		{}
+	};
+	closure forked{f2};
+	if (!push(ctx, forked)) {
+		// Deque is full: no need to expose more parallelism.
+		f1();
+		f2();
+		return;
+	}
+	try {
+		f1();
+	}
+	catch (...) {
+		// The forked task lives on this stack frame and must finish first.
+		try { join(ctx, forked); } catch (...) {}
+		throw;
+	}
+	join(ctx, forked);
+}
+
+inline auto utils::thread_pool::push(context & ctx, detail::pool_task & task) -> bool {
+	if (!ctx.deque->push(&task)) {
+		return false;
+	}
+	// Pairs with the sequentially consistent increment of m_sleeping
+	// in work(): either a sleeping worker is seen here or the worker
+	// sees the pushed task before going to sleep.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_sleeping.load(std::memory_order_seq_cst) != 0) {
+		{
+			std::lock_guard<std::mutex> lock{m_sleep_mutex};
+			++m_wake_epoch;
+		}
+		m_sleep.notify_one();
+	}
+	return true;
+}
+
+inline void utils::thread_pool::run(detail::pool_task * task) {
+	try {
+		task->execute(task);
+	}
+	catch (...) {
+		task->error = std::current_exception();
+	}
+	task->done.store(true, std::memory_order_release);
+}
+
+inline void utils::thread_pool::join(context & ctx, detail::pool_task & task) {
+	unsigned idle_rounds = 0;
+	while (!task.done.load(std::memory_order_acquire)) {
+		auto other = ctx.deque->pop();
+		if (other == nullptr) {
+			other = steal(ctx.index);
+		}
+		if (other != nullptr) {
+			run(other);
+			idle_rounds = 0;
+		}
+		else if (++idle_rounds > 64) {
+			std::this_thread::yield();
+		}
+	}
+	if (task.error) {
+		std::rethrow_exception(task.error);
+	}
+}
+
+inline auto utils::thread_pool::steal(size_t self) -> detail::pool_task * {
+	// Start at a per-thread rotating victim to spread contention.
+	thread_local size_t seed = std::hash<std::thread::id>{}(std::this_thread::get_id());
+	seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+	auto const start = static_cast<size_t>(seed >> 33) % m_deque_count;
+	for (size_t i = 0; i != m_deque_count; ++i) {
+		auto const victim = (start + i) % m_deque_count;
+		if (victim == self) {
+			continue;
+		}
+		if (auto const task = m_deques[victim].steal()) {
+			return task;
+		}
+	}
+	return nullptr;
+}
+
+inline void utils::thread_pool::work(size_t index) {
+	context ctx{this, &m_deques[index], index};
+	current() = &ctx;
+	unsigned idle_rounds = 0;
+	while (!m_stop.load(std::memory_order_relaxed)) {
+		auto task = ctx.deque->pop();
+		if (task == nullptr) {
+			task = steal(index);
+		}
+		if (task != nullptr) {
+			run(task);
+			idle_rounds = 0;
+			continue;
+		}
+		if (++idle_rounds < 128) {
+			std::this_thread::yield();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock{m_sleep_mutex};
+		m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+		auto const epoch = m_wake_epoch;
+		auto pending = false;
+		for (size_t i = 0; i != m_deque_count && !pending; ++i) {
+			pending = m_deques[i].has_tasks();
+		}
+		if (!pending) {
+			m_sleep.wait(lock, [&] { return m_wake_epoch != epoch || m_stop.load(); });
+		}
+		m_sleeping.fetch_sub(1, std::memory_order_seq_cst);
+		idle_rounds = 0;
+	}
+	current() = nullptr;
+}
+
+//============================================================
+// Dynarray entry points
+//============================================================
+
+template<typename T, typename F>
+void utils::parallel_for(dynarray<T> & array, size_t grain, F && f) {
+	auto const data = array.data();
+	thread_pool::instance().parallel_for(0, array.size(), grain,
+		[&](size_t first, size_t last) { f(data + first, data + last); });
+}
+
+template<typename T, typename F>
+void utils::parallel_for(dynarray<T> const& array, size_t grain, F && f) {
+	auto const data = array.data();
+	thread_pool::instance().parallel_for(0, array.size(), grain,
+		[&](size_t first, size_t last) { f(data + first, data + last); });
+}
+
+#endif // UTILS_THREAD_POOL_HPP